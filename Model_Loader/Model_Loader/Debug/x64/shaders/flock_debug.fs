@@ -0,0 +1,9 @@
+#version 440 core
+out vec4 FragColor;
+
+in vec4 Colour;
+
+void main()
+{
+    FragColor = Colour;
+}
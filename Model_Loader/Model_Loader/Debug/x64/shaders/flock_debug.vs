@@ -0,0 +1,39 @@
+#version 440 core
+// a unit line, sphere or arrow, the line and arrow running from the origin to one along z
+layout (location = 0) in vec3 aPos;
+// per instance, where the primitive is drawn from and the vector it shows
+layout (location = 1) in vec4 aOrigin;
+layout (location = 2) in vec4 aVector;
+
+out vec4 Colour;
+
+// shared with every other program, written once a frame (see FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 impostorFade;
+};
+
+uniform vec4 debugColour;
+// scales the vectors, velocities and forces are far too short to see as they are
+uniform float debugScale;
+// when above zero every instance is drawn this size and the vector is ignored
+uniform float debugRadius;
+
+void main()
+{
+    vec3 vector = aVector.xyz * debugScale;
+    float size = debugRadius > 0.0 ? debugRadius : length(vector);
+    vec3 forward = debugRadius > 0.0 || size <= 0.0 ? vec3(0.0, 0.0, 1.0) : vector / size;
+
+    // any two directions at right angles to the vector, the primitives look the same rolled around it
+    vec3 other = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(other, forward));
+    vec3 up = cross(forward, right);
+
+    vec3 worldPosition = aOrigin.xyz + mat3(right, up, forward) * (aPos * size);
+    Colour = debugColour;
+    gl_Position = projection * view * vec4(worldPosition, 1.0);
+}
@@ -0,0 +1,68 @@
+#version 440 core
+// a corner of the unit quad, and where it sits within a frame
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+// per instance model matrix, shared with the meshes drawn close up
+layout (location = 5) in mat4 aInstanceModel;
+
+out vec2 TexCoords;
+out float ImpostorFade;
+
+// shared with every other program, written once a frame (see FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    // x and y are the distances the meshes start and finish fading into impostors
+    vec4 impostorFade;
+};
+
+// the atlas is impostorFrames by impostorFrames frames, each showing a sphere of impostorRadius around the model
+uniform int impostorFrames;
+uniform float impostorRadius;
+
+// folds a direction onto the octahedron and unfolds it into the square, the inverse of ImpostorAtlas::OctahedralDecode
+vec2 octEncode(vec3 direction)
+{
+    direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+    vec2 point = direction.xz;
+    if (direction.y < 0.0)
+        point = (1.0 - abs(point.yx)) * vec2(point.x >= 0.0 ? 1.0 : -1.0, point.y >= 0.0 ? 1.0 : -1.0);
+    return point * 0.5 + 0.5;
+}
+
+vec3 octDecode(vec2 point)
+{
+    point = point * 2.0 - 1.0;
+    vec3 direction = vec3(point.x, 1.0 - abs(point.x) - abs(point.y), point.y);
+    if (direction.y < 0.0)
+        direction.xz = (1.0 - abs(direction.zx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(direction);
+}
+
+void main()
+{
+    vec3 center = aInstanceModel[3].xyz;
+    vec3 axisX = aInstanceModel[0].xyz;
+    vec3 axisY = aInstanceModel[1].xyz;
+    vec3 axisZ = aInstanceModel[2].xyz;
+    float scale = max(length(axisX), max(length(axisY), length(axisZ)));
+    mat3 rotation = mat3(normalize(axisX), normalize(axisY), normalize(axisZ));
+
+    // the frame baked nearest to the direction the camera sees the model from
+    vec3 toCamera = cameraPosition.xyz - center;
+    vec3 localDirection = normalize(transpose(rotation) * toCamera);
+    vec2 cell = clamp(floor(octEncode(localDirection) * float(impostorFrames)), vec2(0.0), vec2(float(impostorFrames - 1)));
+    vec3 frameDirection = octDecode((cell + 0.5) / float(impostorFrames));
+
+    // the quad faces the way the frame was baked, with the same up vector as the bake camera
+    vec3 up = abs(frameDirection.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, frameDirection));
+    up = cross(frameDirection, right);
+    vec3 position = center + rotation * (right * aPos.x + up * aPos.y) * impostorRadius * scale;
+
+    TexCoords = (cell + aTexCoords) / float(impostorFrames);
+    ImpostorFade = impostorFade.y > impostorFade.x ? clamp((length(toCamera) - impostorFade.x) / (impostorFade.y - impostorFade.x), 0.0, 1.0) : 1.0;
+    gl_Position = projection * view * vec4(position, 1.0);
+}
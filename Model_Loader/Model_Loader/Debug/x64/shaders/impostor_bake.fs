@@ -0,0 +1,12 @@
+#version 440 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture_diffuse1;
+
+void main()
+{
+    // the atlas is cleared to transparent, so alpha marks where the model is
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb, 1.0);
+}
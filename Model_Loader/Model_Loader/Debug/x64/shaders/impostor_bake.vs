@@ -0,0 +1,16 @@
+#version 440 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+// the orthographic camera looking at the model from the direction being baked
+uniform mat4 bakeViewProjection;
+// packed meshes store positions relative to their bounds, xyz the centre and w the scale (see VertexLayout)
+uniform vec4 meshBounds;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    gl_Position = bakeViewProjection * vec4(meshBounds.xyz + aPos * meshBounds.w, 1.0);
+}
@@ -0,0 +1,57 @@
+#version 440 core
+// each pass keeps, for every texel, the nearest texel the model covers in the same frame found so far, so
+// after a pass for each halving of the frame size every empty texel knows roughly the nearest covered one
+layout (location = 0) out uvec2 Seed;
+layout (location = 1) out vec4 Colour;
+
+uniform sampler2D bakedAtlas;
+// the previous pass's seeds
+uniform usampler2D seeds;
+// how far this pass looks, 0 for the first pass, which makes every covered texel its own seed
+uniform int dilateStep;
+uniform int impostorFrameSize;
+
+const uint NO_SEED = 0xffffu;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 baked = texelFetch(bakedAtlas, texel, 0);
+
+    uvec2 best = uvec2(NO_SEED);
+    if (dilateStep == 0)
+    {
+        if (baked.a > 0.0)
+            best = uvec2(texel);
+    }
+    else
+    {
+        // the search stops at the frame edges, a frame never picks up a neighbours colour
+        ivec2 frameStart = texel - texel % impostorFrameSize;
+        ivec2 frameEnd = frameStart + impostorFrameSize;
+        float bestDistance = 0.0;
+        for (int y = -1; y <= 1; y++)
+        {
+            for (int x = -1; x <= 1; x++)
+            {
+                ivec2 neighbour = texel + ivec2(x, y) * dilateStep;
+                if (any(lessThan(neighbour, frameStart)) || any(greaterThanEqual(neighbour, frameEnd)))
+                    continue;
+                uvec2 seed = texelFetch(seeds, neighbour, 0).xy;
+                if (seed.x == NO_SEED)
+                    continue;
+                vec2 offset = vec2(ivec2(seed) - texel);
+                float distance = dot(offset, offset);
+                if (best.x == NO_SEED || distance < bestDistance)
+                {
+                    best = seed;
+                    bestDistance = distance;
+                }
+            }
+        }
+    }
+    Seed = best;
+
+    // empty texels take the colour of their seed but stay transparent, the alpha still marks the model
+    Colour = best.x == NO_SEED ? baked : vec4(texelFetch(bakedAtlas, ivec2(best), 0).rgb, baked.a);
+}
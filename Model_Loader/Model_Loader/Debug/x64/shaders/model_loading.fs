@@ -2,10 +2,17 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in float ImpostorFade;
 
 uniform sampler2D texture_diffuse1;
 
+// the same dither as impostor.fs, this keeps the pixels the impostor drops
+const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+
 void main()
 {    
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    if (ImpostorFade > (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0)
+        discard;
     FragColor = texture(texture_diffuse1, TexCoords);
 }
\ No newline at end of file
@@ -2,15 +2,34 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// per instance model matrix, takes up locations 5 to 8 (3 and 4 are the tangents)
+layout (location = 5) in mat4 aInstanceModel;
 
 out vec2 TexCoords;
+out float ImpostorFade;
+
+// shared with every other program, written once a frame (see FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    // x and y are the distances the meshes start and finish fading into impostors
+    vec4 impostorFade;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// packed meshes store positions relative to their bounds, xyz the centre and w the scale (see VertexLayout)
+uniform vec4 meshBounds;
+// when set the model matrix comes from the instance attribute instead of the uniform
+uniform bool instanced;
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 modelMatrix = instanced ? aInstanceModel : model;
+    // only instanced boids have impostors to fade into
+    float fadeDistance = length(cameraPosition.xyz - modelMatrix[3].xyz);
+    ImpostorFade = instanced && impostorFade.y > impostorFade.x ? clamp((fadeDistance - impostorFade.x) / (impostorFade.y - impostorFade.x), 0.0, 1.0) : 0.0;
+    gl_Position = projection * view * modelMatrix * vec4(meshBounds.xyz + aPos * meshBounds.w, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+#ifndef ASSETMANAGER_H
+#define ASSETMANAGER_H
+
+// std includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Forward declerations
+class Model;
+class Shader;
+class AssetManager;
+
+/// <summary>
+/// Something the AssetManager loads. It is read on a loader thread, then finished on the thread that owns
+/// the context, and is resident from then on until the last handle to it goes
+/// </summary>
+class Asset
+{
+public:
+	enum STATE
+	{
+		// waiting for a loader thread
+		ASSET_QUEUED,
+		ASSET_LOADING,
+		// read, waiting to be uploaded on the context's thread
+		ASSET_LOADED,
+		ASSET_RESIDENT,
+		ASSET_FAILED
+	};
+
+	const std::string& GetPath() const { return m_sPath; }
+	STATE GetState() const { return m_eState.load(std::memory_order_acquire); }
+	bool IsResident() const { return GetState() == ASSET_RESIDENT; }
+	// from being asked for to being resident, 0 until then
+	float GetLoadMs() const { return m_fLoadMs; }
+	// the bytes it holds in memory and on the GPU, as of the last time the manager measured it
+	size_t GetCpuBytes() const { return m_uCpuBytes.load(std::memory_order_relaxed); }
+	size_t GetGpuBytes() const { return m_uGpuBytes.load(std::memory_order_relaxed); }
+
+protected:
+	Asset(const std::string& a_sPath);
+	virtual ~Asset() {}
+
+	// reads the files, on a loader thread with no GL calls. false if it can't be loaded
+	virtual bool Load() = 0;
+	// makes the GL objects from what Load read, on the context's thread
+	virtual void Upload() = 0;
+	// deletes the GL objects again, on the context's thread
+	virtual void Unload() = 0;
+	// what it holds in memory and on the GPU, and what Upload will add to the GPU. never while it is loading
+	virtual size_t CountCpuBytes() const = 0;
+	virtual size_t CountGpuBytes() const = 0;
+	virtual size_t CountUploadBytes() const = 0;
+	// lets go of any copy in memory that can be got back from the GPU, returns the bytes freed
+	virtual size_t TrimCpuData() { return 0; }
+
+private:
+	friend class AssetManager;
+
+	Asset(const Asset&);
+	Asset& operator=(const Asset&);
+
+	std::string m_sPath;
+	std::atomic<STATE> m_eState;
+	std::chrono::high_resolution_clock::time_point m_xRequested;
+	float m_fLoadMs;
+	// set once the last handle has gone, so a load not started yet is skipped
+	std::atomic<bool> m_bReleased;
+	std::atomic<size_t> m_uCpuBytes;
+	std::atomic<size_t> m_uGpuBytes;
+};
+
+/// <summary>
+/// A model, drawn as its placeholder until it is resident
+/// </summary>
+class ModelAsset : public Asset
+{
+public:
+	// the model to draw, the placeholder until the model is resident or if it failed to load. any thread
+	Model* Get() const;
+	// the loaded model, null until it is resident
+	Model* GetResident() const { return m_pResident.load(std::memory_order_acquire); }
+
+private:
+	friend class AssetManager;
+
+	ModelAsset(const std::string& a_sPath, const std::vector<float>& a_afLodRatios, unsigned int a_uAttributeMask, bool a_bPacked, bool a_bRetainCpuData,
+		Model* a_pPlaceholder);
+	~ModelAsset();
+
+	virtual bool Load();
+	virtual void Upload();
+	virtual void Unload();
+	virtual size_t CountCpuBytes() const;
+	virtual size_t CountGpuBytes() const;
+	virtual size_t CountUploadBytes() const;
+	virtual size_t TrimCpuData();
+
+	std::vector<float> m_afLodRatios;
+	unsigned int m_uAttributeMask;
+	bool m_bPacked;
+	bool m_bRetainCpuData;
+
+	// filled in on the loader thread, and only handed out once it is uploaded
+	Model* m_pModel;
+	std::atomic<Model*> m_pResident;
+	// the manager's, shared by every model loaded with the same layout and placeholder size
+	Model* m_pPlaceholder;
+};
+
+/// <summary>
+/// A vertex and fragment shader pair, with no program until it is resident
+/// </summary>
+class ShaderAsset : public Asset
+{
+public:
+	// the program, null until it is resident
+	Shader* Get() const { return m_pResident.load(std::memory_order_acquire); }
+
+private:
+	friend class AssetManager;
+
+	ShaderAsset(const std::string& a_sVertexPath, const std::string& a_sFragmentPath);
+	~ShaderAsset();
+
+	virtual bool Load();
+	virtual void Upload();
+	virtual void Unload();
+	// the source until it is compiled, the driver doesn't say what the program takes
+	virtual size_t CountCpuBytes() const { return m_sVertexCode.capacity() + m_sFragmentCode.capacity(); }
+	virtual size_t CountGpuBytes() const { return 0; }
+	virtual size_t CountUploadBytes() const { return 0; }
+
+	std::string m_sVertexPath;
+	std::string m_sFragmentPath;
+	// read on the loader thread, compiled when it is uploaded
+	std::string m_sVertexCode;
+	std::string m_sFragmentCode;
+
+	// made when it is uploaded, and handed out from then
+	Shader* m_pShader;
+	std::atomic<Shader*> m_pResident;
+};
+
+// shared handles, an asset is unloaded once the last handle to it is gone
+typedef std::shared_ptr<ModelAsset> ModelHandle;
+typedef std::shared_ptr<ShaderAsset> ShaderHandle;
+
+/// <summary>
+/// Loads models and shaders on loader threads of its own and hands out shared handles to them. Asking for a
+/// path already held gives the same asset rather than loading it twice. The files are read and decoded on
+/// the loader threads, and Update, once a frame on the thread that owns the context, uploads the finished
+/// ones a few at a time so a load never costs a frame more than an upload. Models are drawn as a small
+/// placeholder until then. Handles can be dropped on any thread, the asset is freed at the next Update.
+/// Everything held counts against one memory budget, in memory and on the GPU. Models only keep their
+/// meshes in memory until they are uploaded unless asked to, and those that were asked to are the first to
+/// let go if the budget is exceeded. A load that wouldn't fit waits, drawn as its placeholder, until
+/// something is freed
+/// </summary>
+class AssetManager
+{
+public:
+	// constructor and destructor, on the thread that owns the context. every handle has to be gone before
+	// the manager is
+	AssetManager(size_t a_uMemoryBudget);
+	~AssetManager();
+
+	// the model at a_sPath, starting it loading if nothing holds it. the meshes keep the vertex attributes
+	// in a_uAttributeMask (see VertexLayout), packed if a_bPacked, and a level of detail for each of
+	// a_afLodRatios. until it is resident it is drawn as an octahedron a_fPlaceholderRadius across, about the
+	// model's size. a_bRetainCpuData keeps the meshes' vertices and indices in memory once uploaded while
+	// the budget allows, Mesh::readBackTriangles gets the shape back if they have gone. a model already held
+	// is handed back as it was loaded
+	ModelHandle LoadModel(const std::string& a_sPath, const std::vector<float>& a_afLodRatios, unsigned int a_uAttributeMask, bool a_bPacked,
+		float a_fPlaceholderRadius, bool a_bRetainCpuData = false);
+	// the program made from the two files, starting it loading if nothing holds it
+	ShaderHandle LoadShader(const std::string& a_sVertexPath, const std::string& a_sFragmentPath);
+
+	// uploads up to a_uMaxUploads loaded assets that fit in the budget and frees the released ones, on the
+	// context's thread
+	void Update(unsigned int a_uMaxUploads = 1);
+	// blocks until an asset has loaded and uploads it straight away, for anything that can't go on without it
+	void Wait(const ModelHandle& a_xModel) { Wait(a_xModel.get()); }
+	void Wait(const ShaderHandle& a_xShader) { Wait(a_xShader.get()); }
+
+	// what is held, for showing in the overlay
+	struct AssetInfo
+	{
+		std::string sPath;
+		Asset::STATE eState;
+		long lHandles;
+		float fLoadMs;
+		size_t uCpuBytes;
+		size_t uGpuBytes;
+	};
+	std::vector<AssetInfo> GetAssetInfo() const;
+	unsigned int GetLoadingCount() const;
+	// every asset's bytes in memory and on the GPU together as of the last Update, and what the resident ones
+	// are kept to. over budget is set while a load is held back for want of room
+	size_t GetMemoryUsed() const { return m_uMemoryUsed; }
+	size_t GetMemoryBudget() const { return m_uMemoryBudget; }
+	bool IsOverBudget() const { return m_bOverBudget; }
+
+private:
+	AssetManager(const AssetManager&);
+	AssetManager& operator=(const AssetManager&);
+
+	// the handle's deleter, on whichever thread dropped the last handle
+	void Release(Asset* a_pAsset);
+	// queues a new asset for the loader threads and times it from now
+	void Queue(Asset* a_pAsset);
+	void Wait(Asset* a_pAsset);
+	// uploads a loaded asset, false if it was released while it loaded so wasn't worth uploading
+	bool Finish(Asset* a_pAsset);
+	// measures every held asset that isn't being read, and adds them up. a_uResidentBytes is added the
+	// resident ones
+	size_t MeasureMemory(size_t& a_uResidentBytes);
+	// trims models' copies in memory, biggest first, until a_uBytes are freed or there are none left.
+	// returns the bytes freed
+	size_t TrimCpuData(size_t a_uBytes);
+	// loop run by each loader thread
+	void LoaderLoop();
+	// a model to draw while models with this layout and size load, made the first time one is asked for
+	Model* GetPlaceholder(unsigned int a_uAttributeMask, bool a_bPacked, float a_fRadius);
+
+	std::vector<std::thread> m_axLoaders;
+	// guards the three lists below, the states of the assets in them change under it too
+	mutable std::mutex m_xMutex;
+	std::condition_variable m_xQueuedCondition;
+	std::condition_variable m_xLoadedCondition;
+	std::deque<Asset*> m_apQueued;
+	std::deque<Asset*> m_apLoaded;
+	std::vector<Asset*> m_apReleased;
+	bool m_bShuttingDown;
+
+	size_t m_uMemoryBudget;
+	size_t m_uMemoryUsed;
+	bool m_bOverBudget;
+
+	// every asset handed out, by path. only touched on the context's thread
+	std::map<std::string, std::weak_ptr<ModelAsset>> m_xModels;
+	std::map<std::string, std::weak_ptr<ShaderAsset>> m_xShaders;
+	std::map<std::tuple<unsigned int, bool, float>, Model*> m_xPlaceholders;
+};
+
+#endif // !ASSETMANAGER_H
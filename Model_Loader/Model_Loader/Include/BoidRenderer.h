@@ -0,0 +1,129 @@
+#ifndef BOIDRENDERER_H
+#define BOIDRENDERER_H
+
+// Project Includes
+#include "FrustumCuller.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <map>
+#include <vector>
+
+// Forward declerations
+class Model;
+class Shader;
+struct BoidSnapshot;
+class StreamingBuffer;
+class RenderQueue;
+class ImpostorAtlas;
+
+/// <summary>
+/// Draws every boid that shares a model with one instanced draw call per mesh and level, instead of
+/// one draw per mesh per boid. The thread pool culls the snapshot's boids, sorts the visible ones into
+/// runs by model and level, and copies their matrices straight into a persistently mapped per instance buffer
+/// </summary>
+class BoidRenderer
+{
+public:
+	BoidRenderer();
+	~BoidRenderer();
+
+	// collects every boid in the snapshot with a model, grouped by model. the snapshot is read again by
+	// Submit, so it has to stay as it is until then
+	void Gather(const BoidSnapshot& a_xSnapshot);
+	// culls the gathered instances against the camera, picks each visible one a level of detail from its
+	// size on screen, writes their model matrices into the instance buffer and queues each model once per level
+	void Submit(Shader* a_pShader, RenderQueue& a_xQueue, const glm::mat4& a_m4View, const glm::mat4& a_m4Projection);
+	// fences the instance data, call once the queue has been flushed
+	void EndFrame();
+
+	// returns how many instances and draw calls the last submit used
+	unsigned int GetInstanceCount() const { return static_cast<unsigned int>(m_auInstances.size()); }
+	unsigned int GetDrawCallCount() const { return m_uDrawCallCount; }
+	// returns the instance buffer, for showing its stalls
+	const StreamingBuffer* GetInstanceBuffer() const { return m_pInstanceBuffer; }
+
+	// turns frustum culling on or off, and whether it is spread over the thread pool
+	void SetCulling(bool a_bCulling) { m_bCulling = a_bCulling; }
+	void SetParallelCulling(bool a_bParallel) { m_bParallelCulling = a_bParallel; }
+	// how many instances survived culling last submit, and how long culling them took
+	unsigned int GetVisibleCount() const { return m_uVisibleCount; }
+	float GetCullMs() const { return m_fCullMs; }
+
+	// turns level of detail selection on or off, when off every instance draws the full mesh
+	void SetLodSelection(bool a_bLodSelection) { m_bLodSelection = a_bLodSelection; }
+	// the screen sizes (the fraction of the screen height a bounding sphere covers) below which an instance
+	// drops to the next level, largest first. levels past what a model has use its last one
+	void SetLodScreenSizes(const std::vector<float>& a_afScreenSizes) { m_afLodScreenSizes = a_afScreenSizes; }
+	// how many visible instances drew at each level last submit
+	const std::vector<unsigned int>& GetLodCounts() const { return m_auLodCounts; }
+
+	// draws a_pModel's far away instances as impostors from a_pAtlas, or stops with a null atlas
+	void SetImpostor(const Model* a_pModel, ImpostorAtlas* a_pAtlas);
+	// instances between a_fStart and a_fEnd from the camera are drawn as both mesh and impostor, the shaders
+	// dithering one into the other, and past a_fEnd only as impostors. an end no further than the start turns
+	// impostors off. the shaders fade every instanced mesh, so FrameUniforms has to be given the same distances
+	void SetImpostorFade(float a_fStart, float a_fEnd) { m_fImpostorFadeStart = a_fStart; m_fImpostorFadeEnd = a_fEnd; }
+	// how many impostors were drawn last submit
+	unsigned int GetImpostorCount() const { return m_uImpostorCount; }
+
+private:
+	// a run of m_auInstances that all use the same model
+	struct ModelBatch
+	{
+		Model* pModel;
+		// null if the model has no impostor
+		ImpostorAtlas* pImpostor;
+		unsigned int uFirstInstance;
+		unsigned int uInstanceCount;
+		// the first of the batch's runs of the instance buffer, one per level then one for the impostors
+		unsigned int uFirstRun;
+	};
+
+	std::vector<ModelBatch> m_axBatches;
+	// the snapshot gathered from, and the index in it of each instance
+	const BoidSnapshot* m_pSnapshot;
+	std::vector<unsigned int> m_auInstances;
+
+	// per instance bounding sphere, split by component for the culler
+	std::vector<float> m_afSphereX;
+	std::vector<float> m_afSphereY;
+	std::vector<float> m_afSphereZ;
+	std::vector<float> m_afSphereRadius;
+	std::vector<unsigned char> m_abVisible;
+	std::vector<unsigned char> m_abLods;
+	// how far each instance is from the camera, for the impostor fade
+	std::vector<float> m_afDistances;
+	// the run each instance's mesh and impostor are written to, uNO_RUN if it isn't drawn that way
+	std::vector<unsigned int> m_auMeshRuns;
+	std::vector<unsigned int> m_auImpostorRuns;
+	// how many instances each pool chunk writes to each run, then where in the region its next one goes
+	std::vector<unsigned int> m_auChunkRuns;
+	// where each run starts in the region and how many instances it holds
+	std::vector<unsigned int> m_auRunStarts;
+	std::vector<unsigned int> m_auRunCounts;
+
+	FrustumCuller m_xCuller;
+	bool m_bCulling;
+	bool m_bParallelCulling;
+	unsigned int m_uVisibleCount;
+	float m_fCullMs;
+
+	bool m_bLodSelection;
+	std::vector<float> m_afLodScreenSizes;
+	std::vector<unsigned int> m_auLodCounts;
+
+	std::map<const Model*, ImpostorAtlas*> m_xImpostors;
+	float m_fImpostorFadeStart;
+	float m_fImpostorFadeEnd;
+	unsigned int m_uImpostorCount;
+
+	StreamingBuffer* m_pInstanceBuffer;
+	// whether a region of the instance buffer is waiting on EndFrame
+	bool m_bRegionOpen;
+	unsigned int m_uDrawCallCount;
+};
+
+#endif // !BOIDRENDERER_H
@@ -0,0 +1,49 @@
+#ifndef BOIDSNAPSHOT_H
+#define BOIDSNAPSHOT_H
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <vector>
+
+// Forward declerations
+class Model;
+
+/// <summary>
+/// Everything the render thread needs from one step of the simulation, copied out of the entities once the
+/// step has finished. The streams hold one entry per boid, in entity order, so the renderer and the debug
+/// drawing never touch the entities the simulation thread is changing
+/// </summary>
+struct BoidSnapshot
+{
+	std::vector<unsigned int> auEntityIDs;
+	std::vector<Model*> apModels;
+	// the entity matrix with the model scale applied, what ModelComponent::GetModelMatrix gives
+	std::vector<glm::mat4> am4Models;
+	std::vector<glm::vec3> av3Positions;
+	std::vector<glm::vec3> av3Velocities;
+	// BEHAVIOUR_COUNT forces per boid, in BEHAVIOUR_SLOT order
+	std::vector<glm::vec3> av3BehaviourForces;
+
+	// the GPU flock was moving the boids, so the positions here are from before it started
+	bool bGpuFlock = false;
+	// which step this was, and how long the step took to run
+	unsigned int uStep = 0;
+	float fStepMs = 0.0f;
+	// how many boid model swaps the simulation had run before this step, none of the earlier models are in it
+	unsigned int uModelSwaps = 0;
+
+	unsigned int GetBoidCount() const { return static_cast<unsigned int>(auEntityIDs.size()); }
+	void Clear()
+	{
+		auEntityIDs.clear();
+		apModels.clear();
+		am4Models.clear();
+		av3Positions.clear();
+		av3Velocities.clear();
+		av3BehaviourForces.clear();
+	}
+};
+
+#endif // !BOIDSNAPSHOT_H
@@ -0,0 +1,93 @@
+#ifndef BOIDSYSTEMS_H
+#define BOIDSYSTEMS_H
+
+// Project Includes
+#include "System.h"
+#include "FlockCore.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <vector>
+
+/// <summary>
+/// Works out the steering forces for the current group of boids
+/// </summary>
+class BoidForceSystem : public System
+{
+public:
+	BoidForceSystem();
+
+	virtual void Update(float a_fDeltaTime, float a_fBoundingBoxSize);
+
+	// sets which group of boids has its forces processed this frame
+	void SetGroup(int a_iGroupNum, int a_iSizeOfGroup) { m_iGroupNum = a_iGroupNum; m_iSizeOfGroup = a_iSizeOfGroup; }
+
+private:
+	int m_iGroupNum;
+	int m_iSizeOfGroup;
+};
+
+/// <summary>
+/// Moves every boid along its velocity and keeps it inside the bounds
+/// </summary>
+class BoidMovementSystem : public System
+{
+public:
+	BoidMovementSystem();
+
+	virtual void Update(float a_fDeltaTime, float a_fBoundingBoxSize);
+};
+
+/// <summary>
+/// Builds the gizmo geometry for the bounding box and the box the boids avoid
+/// </summary>
+class SceneGizmoSystem : public System
+{
+public:
+	SceneGizmoSystem();
+
+	virtual void Update(float a_fDeltaTime, float a_fBoundingBoxSize);
+
+	// sets the position of the box the boids avoid
+	void SetBoxPosition(const glm::vec3& a_v3BoxPos) { m_v3BoxPos = a_v3BoxPos; }
+
+private:
+	glm::vec3 m_v3BoxPos;
+
+	// the boxes only change when the box moves or the bounds are resized, so they are kept on a static layer
+	unsigned int m_uLayer;
+	bool m_bLayerBuilt;
+	glm::vec3 m_v3BuiltBoxPos;
+	float m_fBuiltBoundingBoxSize;
+};
+
+/// <summary>
+/// Runs the boids as a flat 2D flock instead of through their brain components, for crowds that
+/// never leave the ground. The flock lies on the XZ plane so it still renders through the transforms
+/// </summary>
+class PlanarFlockSystem : public System
+{
+public:
+	PlanarFlockSystem();
+
+	virtual void Update(float a_fDeltaTime, float a_fBoundingBoxSize);
+
+	// takes the boids positions from their transforms again next update
+	void Reset() { m_auEntityIDs.clear(); }
+
+	// sets the behaviour weights and the position of the box the boids avoid
+	void SetWeights(const FlockWeights& a_xWeights) { m_xSettings.xWeights = a_xWeights; }
+	void SetBoxPosition(const glm::vec3& a_v3BoxPos) { m_xSettings.v3Obstacle = glm::vec3(a_v3BoxPos.x, a_v3BoxPos.z, 0.0f); }
+
+private:
+	// matches the flock to the entity list, keeping the boids that are still there
+	void SyncEntities();
+
+	FlockCore2f m_xFlock;
+	FlockSettings m_xSettings;
+	std::vector<unsigned int> m_auEntityIDs;
+};
+
+#endif // !BOIDSYSTEMS_H
@@ -3,6 +3,7 @@
 
 
 #include "Component.h"
+#include "FlockCore.h"
 // third party include
 #include <glm/glm.hpp>
 #include <list>
@@ -21,8 +22,12 @@ public:
 
 	// returns velocity of the boid
 	glm::vec3 GetCurrentVelocity() const { return m_v3CurrentVelocity; }
+	// sets the velocity, for when the boid has been moved by something else
+	void SetCurrentVelocity(const glm::vec3& a_v3Velocity) { m_v3CurrentVelocity = a_v3Velocity; }
 	// updates the forces for the boid
 	void UpdateForces(float a_fDeltaTime);
+	// the weighted force each behaviour gave the last time the forces were updated, zero if it was switched off
+	const glm::vec3& GetBehaviourForce(BEHAVIOUR_SLOT a_eSlot) const { return m_av3BehaviourForces[a_eSlot]; }
 
 	// values that are edited by the gui
 	float wanderWeight;
@@ -36,19 +41,16 @@ private:
 	glm::vec3 CalculateForces();
 	glm::vec3 CalculateSeekForce(const glm::vec3& v3Target, const glm::vec3& v3CurrentPos) const;
 	glm::vec3 CalculateFleeForce(const glm::vec3& v3Target, const glm::vec3& v3CurrentPos) const;
-	glm::vec3 AvoidBox(const glm::vec3& v3Target, const glm::vec3& v3CurrentPos) const;
 	glm::vec3 CalculateWanderForce(const glm::vec3& v3Forward, const glm::vec3& v3CurrentPos);
 
-	// Flocking behaviours
-	glm::vec3 CalculateSeparationForce(glm::vec3 v3SeparationVel, unsigned int uNeighbourCount);
-	glm::vec3 CalculateAlignmentForce(glm::vec3 v3AllignmentVel, unsigned int uNeighbourCount);
-	glm::vec3 CalculateCohesionForce(glm::vec3 v3LocalPos, glm::vec3 v3CohesionVel, unsigned int uNeighbourCount);
-
-	glm::vec3 UpdateBoundsFleeForce(float a_fBoundsSize, glm::vec3 a_v3LocalPos);
+	// the flocking behaviours themselves live in BoidBehaviours.h, and how the boid moves in FlockCore.h.
+	// these are the settings it moves with
+	FlockSettings GetMovementSettings(float a_fBoundsSize) const;
 
 	// Var
 	glm::vec3 m_v3CurrentVelocity;
 	glm::vec3 m_v3WanderPoint;
+	glm::vec3 m_av3BehaviourForces[BEHAVIOUR_COUNT];
 	glm::vec3 m_v3UpperVelClamp = glm::vec3(2.5f, 2.5f, 2.5f);
 	glm::vec3 m_v3LowerVelClamp = glm::vec3(-2.5f, -2.5f, -2.5f);
 
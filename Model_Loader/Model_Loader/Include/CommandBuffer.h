@@ -0,0 +1,80 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+// std includes
+#include <functional>
+#include <vector>
+
+// Forward declerations
+class Entity;
+class Component;
+
+// sets up the components of a newly spawned entity
+typedef std::function<void(Entity*)> EntityBuilder;
+// creates a component for an entity
+typedef std::function<Component*(Entity*)> ComponentFactory;
+
+/// <summary>
+/// Records changes to the set of entities so they can be applied later at a sync point.
+/// Each thread records into its own buffer, so recording never needs a lock
+/// </summary>
+class alignas(64) CommandBuffer
+{
+public:
+	CommandBuffer();
+
+	// creates a new entity and hands it to the builder to add its components
+	void Spawn(EntityBuilder a_xBuilder);
+	// removes and deletes an entity
+	void Despawn(unsigned int a_uEntityID);
+	// adds a component to an existing entity
+	void AddComponent(unsigned int a_uEntityID, ComponentFactory a_xFactory);
+
+	// returns true if nothing has been recorded since the last flush
+	bool IsEmpty() const { return m_axCommands.empty(); }
+
+private:
+	friend class CommandQueue;
+
+	enum COMMAND_TYPE
+	{
+		SPAWN,
+		DESPAWN,
+		ADD_COMPONENT,
+	};
+
+	// commands are applied in order of their key, which is the thread pool task tag at the time they were
+	// recorded, then by thread, then in recording order. the scheduler tags work with the system running it
+	// so the result doesn't depend on which thread ran what
+	struct Command
+	{
+		COMMAND_TYPE eType;
+		unsigned int uKey;
+		unsigned int uEntityID;
+		EntityBuilder xBuilder;
+		ComponentFactory xFactory;
+	};
+
+	// aligned so buffers for different threads never share a cache line
+	std::vector<Command> m_axCommands;
+};
+
+/// <summary>
+/// One command buffer per thread plus the flush that applies them all in a fixed order
+/// </summary>
+class CommandQueue
+{
+public:
+	CommandQueue(unsigned int a_uThreadCount);
+
+	// returns the buffer belonging to the calling thread
+	CommandBuffer& GetThreadBuffer();
+
+	// applies every recorded command then clears the buffers, must only be called while no systems are running
+	void Flush();
+
+private:
+	std::vector<CommandBuffer> m_axBuffers;
+};
+
+#endif // !COMMANDBUFFER_H
@@ -29,6 +29,10 @@ public:
 	static const std::map<const unsigned int, Entity*>& GetEntityList() { return s_xEntityList; }
 	// removed specified entity from the map of entities
 	static void RemoveEntity(std::map<const unsigned int, Entity*>::const_iterator xIter) { s_xEntityList.erase(xIter); s_uEntityCount--; }
+	// returns the entity with the given id, or nullptr if there isn't one
+	static Entity* FindEntity(unsigned int a_uEntityID);
+	// removes the entity with the given id from the map and deletes it
+	static void DestroyEntity(unsigned int a_uEntityID);
 
 	// gets id of the entity
 	unsigned int GetEntityID() { return m_uEntityID; }
@@ -38,6 +42,8 @@ private:
 	std::vector<Component*> m_apComponentList;
 
 	static unsigned int s_uEntityCount;
+	// ids are never reused so a deferred command can't hit a newer entity by mistake
+	static unsigned int s_uNextEntityID;
 	static std::map<const unsigned int, Entity*> s_xEntityList;
 };
 
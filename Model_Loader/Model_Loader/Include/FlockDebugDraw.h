@@ -0,0 +1,97 @@
+#ifndef FLOCKDEBUGDRAW_H
+#define FLOCKDEBUGDRAW_H
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <cstddef>
+
+// Forward declerations
+class Shader;
+class StreamingBuffer;
+class GpuFlock;
+struct BoidSnapshot;
+
+/// <summary>
+/// Draws what steers each boid, its velocity, its neighbourhood and the force from each behaviour, as unit
+/// line, sphere and arrow meshes placed per instance by the vertex shader. Every boid's vectors go into one
+/// per instance buffer (or are read straight from the GPU flock's storage buffers), so each thing shown is a
+/// single instanced draw however many boids there are
+/// </summary>
+class FlockDebugDraw
+{
+public:
+	// what to show, as bits that can be combined
+	enum SHOW
+	{
+		SHOW_VELOCITY = 1,
+		SHOW_NEIGHBOURHOOD = 2,
+		SHOW_FORCES = 4
+	};
+
+	FlockDebugDraw();
+	~FlockDebugDraw();
+
+	// writes every boid's position, velocity and behaviour forces from the snapshot into the instance buffer and draws them
+	void Draw(const BoidSnapshot& a_xSnapshot, unsigned int a_uShow);
+	// draws the GPU flock from its own buffers, which only keep the sum of the behaviour forces
+	void Draw(const GpuFlock& a_xFlock, unsigned int a_uShow);
+	// fences the instance data, call once the frame's debug drawing is done
+	void EndFrame();
+
+	// the radius the neighbourhood spheres are drawn at
+	void SetNeighbourhoodRadius(float a_fRadius) { m_fNeighbourhoodRadius = a_fRadius; }
+	// velocities and forces are per step, so they are scaled up to be seen
+	void SetVelocityScale(float a_fScale) { m_fVelocityScale = a_fScale; }
+	void SetForceScale(float a_fScale) { m_fForceScale = a_fScale; }
+
+	// how many boids and draw calls the last draw used
+	unsigned int GetBoidCount() const { return m_uBoidCount; }
+	unsigned int GetDrawCallCount() const { return m_uDrawCallCount; }
+
+private:
+	FlockDebugDraw(const FlockDebugDraw&);
+	FlockDebugDraw& operator=(const FlockDebugDraw&);
+
+	// the unit meshes, all drawn as lines from the one vertex buffer
+	enum PRIMITIVE
+	{
+		PRIMITIVE_LINE,
+		PRIMITIVE_SPHERE,
+		PRIMITIVE_ARROW,
+		PRIMITIVE_COUNT
+	};
+
+	// a primitive's run of the vertex buffer
+	struct PrimitiveRange
+	{
+		unsigned int uFirst;
+		unsigned int uCount;
+	};
+
+	// builds the unit meshes and the vertex array that places them
+	void CreateMeshes();
+	// one instanced draw of a_ePrimitive, the origins and vectors read as vec4s from the given buffers and offsets.
+	// a radius above zero draws every instance that size instead of the length of its vector
+	void DrawPrimitive(PRIMITIVE a_ePrimitive, unsigned int a_uCount, unsigned int a_uOriginBuffer, size_t a_uOriginOffset,
+		unsigned int a_uVectorBuffer, size_t a_uVectorOffset, const glm::vec4& a_v4Colour, float a_fScale, float a_fRadius);
+
+	Shader* m_pShader;
+	unsigned int m_uVAO;
+	unsigned int m_uVBO;
+	PrimitiveRange m_axPrimitives[PRIMITIVE_COUNT];
+
+	StreamingBuffer* m_pInstanceBuffer;
+	// whether a region of the instance buffer is waiting on EndFrame
+	bool m_bRegionOpen;
+
+	float m_fNeighbourhoodRadius;
+	float m_fVelocityScale;
+	float m_fForceScale;
+
+	unsigned int m_uBoidCount;
+	unsigned int m_uDrawCallCount;
+};
+
+#endif // !FLOCKDEBUGDRAW_H
@@ -0,0 +1,46 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+// third party include
+#include <glm/glm.hpp>
+
+// the uniform buffer binding point the frame uniforms are bound to, shared by every program that uses them
+static const unsigned int uFRAME_UNIFORMS_BINDING = 0;
+// the name of the uniform block in the shaders
+static const char* const szFRAME_UNIFORMS_BLOCK = "FrameUniforms";
+
+/// <summary>
+/// The per frame uniforms (view, projection, camera position and impostor fade) kept in one std140 uniform buffer. It is written once a frame
+/// and left bound, so every program with a FrameUniforms block reads the same matrices without setting them
+/// </summary>
+class FrameUniforms
+{
+public:
+	FrameUniforms();
+	~FrameUniforms();
+
+	// uploads this frames matrices and binds the buffer to uFRAME_UNIFORMS_BINDING
+	void Update(const glm::mat4& a_m4View, const glm::mat4& a_m4Projection);
+
+	// the distances from the camera instanced meshes fade into impostors between, uploaded by the next Update.
+	// an end no further than the start turns the fade off
+	void SetImpostorFade(float a_fStart, float a_fEnd) { m_v2ImpostorFade = glm::vec2(a_fStart, a_fEnd); }
+
+private:
+	FrameUniforms(const FrameUniforms&);
+	FrameUniforms& operator=(const FrameUniforms&);
+
+	// matches the std140 layout of the block in the shaders, mat4s and vec4s need no padding
+	struct BlockData
+	{
+		glm::mat4 m4View;
+		glm::mat4 m4Projection;
+		glm::vec4 v4CameraPosition;
+		glm::vec4 v4ImpostorFade;
+	};
+
+	unsigned int m_uBuffer;
+	glm::vec2 m_v2ImpostorFade;
+};
+
+#endif // !FRAMEUNIFORMS_H
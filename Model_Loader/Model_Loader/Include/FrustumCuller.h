@@ -0,0 +1,32 @@
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+// third party include
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Tests bounding spheres against the six planes of a camera frustum. The spheres are read as separate
+/// x, y, z and radius arrays so four of them can be tested at once with SSE, any left over are tested one
+/// at a time (as is everything when SSE isn't available)
+/// </summary>
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	// pulls the planes out of a projection * view matrix, they face inwards and are normalised
+	void SetFrustum(const glm::mat4& a_m4ProjectionView);
+
+	// true if any of the sphere is inside the frustum
+	bool TestSphere(const glm::vec3& a_v3Centre, float a_fRadius) const;
+	// tests spheres a_uBegin to a_uEnd, writing 1 into a_pbVisible for each one that is at least partly
+	// inside and 0 for the rest. ranges that don't overlap can be tested from different threads
+	void TestSpheres(const float* a_pfX, const float* a_pfY, const float* a_pfZ, const float* a_pfRadius,
+		unsigned int a_uBegin, unsigned int a_uEnd, unsigned char* a_pbVisible) const;
+
+private:
+	// a, b, c, d for ax + by + cz + d = 0, with the normal pointing into the frustum
+	glm::vec4 m_av4Planes[6];
+};
+
+#endif // !FRUSTUMCULLER_H
@@ -3,19 +3,30 @@
 
 #include <glm/glm.hpp>
 
+#include <map>
+#include <vector>
+
 class Gizmos
 {
 public:
 
-	static void		create(unsigned int a_maxLines = 32728, unsigned int a_maxTris = 32728);
+	// the line and triangle counts are only where the default layer starts, every layer grows as gizmos are added
+	static void		create(unsigned int a_maxLines = 4096, unsigned int a_maxTris = 4096);
 	static void		destroy();
 
-	// removes all Gizmos
+	// removes all Gizmos on the immediate layers, static layers keep theirs
 	static void		clear();
 
-	// draws current Gizmo buffers, either using a combined (projection * view) matrix, or separate matrices
-	static void		draw(const glm::mat4& a_projectionView);
-	static void		draw(const glm::mat4& a_view, const glm::mat4& a_projection);
+	// adds a layer and returns its id. immediate layers are emptied by clear() and uploaded again every draw,
+	// static layers keep their gizmos, and their copy on the GPU, until something is added to or cleared from them
+	static unsigned int	createLayer(bool a_bStatic);
+	// the layer the add functions go to from now on. layer 0 is immediate and always there
+	static void		setLayer(unsigned int a_layer);
+	// removes the Gizmos on one layer, static or not
+	static void		clearLayer(unsigned int a_layer);
+
+	// draws current Gizmo buffers, using the view and projection in the frame uniform buffer (see FrameUniforms)
+	static void		draw();
 
 	// Adds a single debug line
 	static void		addLine(const glm::vec3& a_rv0, const glm::vec3& a_rv1,
@@ -60,6 +71,8 @@ public:
 private:
 
 	Gizmos(unsigned int a_maxLines, unsigned int a_maxTris);
+	Gizmos(const Gizmos&);
+	Gizmos& operator=(const Gizmos&);
 	~Gizmos();
 
 	void TestShaderStatus(const unsigned int& a_uiShaderId, unsigned int a_uiStatus, int& a_iSuccessFlag, const char* a_shaderType);
@@ -82,32 +95,63 @@ private:
 		GizmoVertex v2;
 	};
 
+	// a vertex buffer that grows a chunk at a time, and how many primitives were last uploaded into it
+	struct GizmoBuffer
+	{
+		unsigned int vao;
+		unsigned int vbo;
+		unsigned int capacity;
+		unsigned int count;
+	};
+
+	struct GizmoLayer
+	{
+		bool isStatic;
+		bool dirty;
+		std::vector<GizmoLine> lines;
+		std::vector<GizmoTri> tris;
+		GizmoBuffer lineBuffer;
+		GizmoBuffer triBuffer;
+	};
+
+	// what a sphere's points depend on apart from its size and placement
+	struct SphereKey
+	{
+		int rows;
+		int columns;
+		float longMin;
+		float longMax;
+		float latMin;
+		float latMax;
+
+		bool operator<(const SphereKey& a_other) const;
+	};
+
+	GizmoLayer*		createLayerData(bool a_bStatic, unsigned int a_lines, unsigned int a_tris);
+	void			createBuffer(GizmoBuffer& a_buffer, unsigned int a_primitiveSize, unsigned int a_capacity);
+	void			destroyBuffer(GizmoBuffer& a_buffer);
+	// copies a layer's primitives into its buffer, making it bigger first if they don't fit
+	void			uploadBuffer(GizmoBuffer& a_buffer, const void* a_data, unsigned int a_count, unsigned int a_primitiveSize, bool a_bStatic);
+
+	// sin and cos around a circle in a_segments steps, with the first step repeated at the end
+	const std::vector<glm::vec2>& circlePoints(unsigned int a_segments);
+	// the points of a sphere of radius 1, laid out the way addSphere indexes them
+	const std::vector<glm::vec3>& spherePoints(const SphereKey& a_key);
+
 	unsigned int	m_programID;
 	unsigned int	m_vertexShader;
 	unsigned int	m_fragmentShader;
 
-	// line data
-	unsigned int	m_maxLines;
-	unsigned int	m_lineCount;
-	GizmoLine*		m_lines;
+	std::vector<GizmoLayer*>	m_layers;
+	GizmoLayer*		m_currentLayer;
 
-	unsigned int	m_lineVAO;
-	unsigned int 	m_lineVBO;
-
-	// triangle data
-	unsigned int	m_maxTris;
-	unsigned int	m_triCount;
-	GizmoTri*		m_tris;
-
-	unsigned int	m_triVAO;
-	unsigned int 	m_triVBO;
+	// tessellations already worked out, so repeated shapes don't recompute their trig
+	std::map<unsigned int, std::vector<glm::vec2>>	m_circleCache;
+	std::map<SphereKey, std::vector<glm::vec3>>		m_sphereCache;
+	// reused by addSphere for the placed points
+	std::vector<glm::vec3>	m_sphereScratch;
 
 	static Gizmos*	sm_singleton;
 };
 
-inline void Gizmos::draw(const glm::mat4& a_view, const glm::mat4& a_projection)
-{
-	draw(a_projection * a_view);
-}
-
 #endif // __GIZMOS_H_
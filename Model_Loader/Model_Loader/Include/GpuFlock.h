@@ -0,0 +1,104 @@
+#ifndef GPUFLOCK_H
+#define GPUFLOCK_H
+
+// Project Includes
+#include "FlockCore.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <vector>
+
+// Forward declerations
+class ComputeShader;
+
+/// <summary>
+/// Steps a 3D flock with compute shaders, keeping the boids in shader storage buffers. Each step bins the
+/// boids into a grid (count, scan, scatter), works out the forces and integrates, the same way as
+/// FlockWorkspace::Step. The last pass also writes a model matrix per boid, which the model shader reads
+/// as instance data so drawing the flock never brings it back to the CPU
+/// </summary>
+class GpuFlock
+{
+public:
+	GpuFlock();
+	~GpuFlock();
+
+	// false if the compute shaders didn't build, the flock can't be stepped then
+	bool IsValid() const { return m_bValid; }
+
+	// replaces the flock, wander points start again
+	void Upload(const std::vector<glm::vec3>& a_av3Positions, const std::vector<glm::vec3>& a_av3Velocities);
+	// reads the flock back, this waits for the GPU so only use it when switching back to the CPU
+	void Download(std::vector<glm::vec3>& a_av3Positions, std::vector<glm::vec3>& a_av3Velocities) const;
+
+	// runs one step, a_fModelScale scales the model matrices written for drawing
+	void Step(float a_fDeltaTime, const FlockSettings& a_xSettings, float a_fModelScale = 1.0f);
+
+	unsigned int GetCount() const { return m_uCount; }
+	// the per boid model matrices, for Mesh::DrawInstanced
+	unsigned int GetInstanceBuffer() const { return m_auBuffers[BUFFER_INSTANCE_MATRICES]; }
+	// the boid positions, velocities and the forces from the last step, a vec4 per boid, for drawing what the flock
+	// is doing without reading it back
+	unsigned int GetPositionBuffer() const { return m_auBuffers[BUFFER_POSITIONS]; }
+	unsigned int GetVelocityBuffer() const { return m_auBuffers[BUFFER_VELOCITIES]; }
+	unsigned int GetForceBuffer() const { return m_auBuffers[BUFFER_FORCES]; }
+
+	// steps the same random flock a_uSteps times here and on the CPU with the randomness switched off, and
+	// returns the largest distance between where the two put a boid. needs a current GL 4.3+ context
+	static float CompareWithCpu(unsigned int a_uBoidCount, unsigned int a_uSteps);
+
+private:
+	GpuFlock(const GpuFlock&);
+	GpuFlock& operator=(const GpuFlock&);
+
+	// the storage buffers, in binding order
+	enum BUFFER
+	{
+		BUFFER_POSITIONS,
+		BUFFER_VELOCITIES,
+		BUFFER_WANDER_POINTS,
+		BUFFER_FORCES,
+		BUFFER_BOID_CELLS,
+		BUFFER_CELL_COUNTS,
+		BUFFER_CELL_START,
+		BUFFER_SORTED_BOIDS,
+		BUFFER_INSTANCE_MATRICES,
+		BUFFER_COUNT
+	};
+
+	// the compute passes, in the order they run
+	enum PASS
+	{
+		PASS_BIN,
+		PASS_SCAN,
+		PASS_SCATTER,
+		PASS_FORCES,
+		PASS_INTEGRATE,
+		PASS_COUNT
+	};
+
+	// makes room for a_uBoidCount boids and a_uCellCount grid cells, only ever grows
+	void Reserve(unsigned int a_uBoidCount, unsigned int a_uCellCount);
+	// sets the uniforms every pass reads
+	void SetUniforms(ComputeShader* a_pPass, float a_fDeltaTime, const FlockSettings& a_xSettings, float a_fModelScale) const;
+
+	ComputeShader* m_apPasses[PASS_COUNT];
+	unsigned int m_auBuffers[BUFFER_COUNT];
+	bool m_bValid;
+
+	unsigned int m_uCount;
+	unsigned int m_uBoidCapacity;
+	unsigned int m_uCellCapacity;
+	// changes every step so the wander randomness does
+	unsigned int m_uSeed;
+
+	// the grid for the current step
+	unsigned int m_uCellsPerAxis;
+	unsigned int m_uCellCount;
+	float m_fCellSize;
+	float m_fGridMin;
+};
+
+#endif // !GPUFLOCK_H
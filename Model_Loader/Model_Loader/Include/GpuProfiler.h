@@ -0,0 +1,92 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+// std includes
+#include <chrono>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Times the render passes on the CPU and, with timestamp queries, on the GPU. A frame's queries are only
+/// read once the GPU says they are done, a few frames later, so profiling never makes the CPU wait on the GPU
+/// </summary>
+class GpuProfiler
+{
+public:
+	struct PassTiming
+	{
+		std::string sName;
+		// in microseconds on the profiler's clock, the GPU times are moved onto it so both can be lined up
+		double dCpuStartUs = 0.0;
+		double dCpuUs = 0.0;
+		double dGpuStartUs = 0.0;
+		double dGpuUs = 0.0;
+	};
+
+	// a whole frame and the passes within it
+	struct FrameTimings
+	{
+		unsigned long long uFrame = 0;
+		PassTiming xFrame;
+		std::vector<PassTiming> axPasses;
+	};
+
+	GpuProfiler();
+	~GpuProfiler();
+
+	// call at the start and end of each frame on the thread that owns the context. BeginFrame also reads
+	// back any earlier frames the GPU has finished
+	void BeginFrame();
+	void EndFrame();
+	// passes don't nest, beginning a pass ends the one before it
+	void BeginPass(const char* a_szName);
+	void EndPass();
+
+	// the newest frame with its GPU times back, and every frame that came back during the last BeginFrame
+	const FrameTimings& GetLatestTimings() const { return m_xLatest; }
+	const std::vector<FrameTimings>& GetResolvedFrames() const { return m_axResolved; }
+	// frames whose queries still weren't done when their slot came round again, so were thrown away
+	unsigned int GetDroppedFrameCount() const { return m_uDroppedFrames; }
+
+	// lines the GPU clock up with the CPU one again, they drift apart over a long run
+	void Calibrate();
+
+private:
+	GpuProfiler(const GpuProfiler&);
+	GpuProfiler& operator=(const GpuProfiler&);
+
+	// a frame waiting on its queries. the first two queries are the frame, then two for each pass
+	struct FrameSlot
+	{
+		FrameTimings xTimings;
+		std::vector<unsigned int> auQueries;
+		bool bPending = false;
+	};
+
+	// reads the slot back if its queries are done, false if they aren't yet
+	bool Resolve(FrameSlot& a_xSlot);
+	// hands the slot's queries back to the pool
+	void Release(FrameSlot& a_xSlot);
+	// takes a query from the pool and writes the GPU time into it once the commands before it are done
+	unsigned int Timestamp();
+	double NowUs() const;
+
+	std::vector<FrameSlot> m_axSlots;
+	unsigned int m_uCurrentSlot;
+	bool m_bInFrame;
+	bool m_bInPass;
+	unsigned long long m_uFrame;
+
+	std::vector<unsigned int> m_auFreeQueries;
+	std::vector<unsigned int> m_auAllQueries;
+
+	std::chrono::high_resolution_clock::time_point m_xEpoch;
+	// added to a GPU timestamp in microseconds to put it on the CPU clock
+	double m_dGpuOffsetUs;
+
+	FrameTimings m_xLatest;
+	std::vector<FrameTimings> m_axResolved;
+	unsigned int m_uDroppedFrames;
+};
+
+#endif // !GPUPROFILER_H
@@ -0,0 +1,53 @@
+#ifndef HEADLESSCONTEXT_H
+#define HEADLESSCONTEXT_H
+
+// std includes
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A GL 4.4 core context with no window, drawing into a framebuffer of its own, for running the scene on
+/// machines with no display. On Linux it is a surfaceless EGL context, which Mesa's llvmpipe provides without
+/// any display server. Elsewhere it falls back to a hidden GLFW window, which runs on llvmpipe when Mesa's
+/// opengl32 is put next to the executable. The Visual Studio project only builds the GLFW branch, the EGL one
+/// has no build target in the repo and has to be compiled by hand, e.g. with g++ and -lEGL -ldl
+/// </summary>
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	// creates the context, makes it current on the calling thread, loads GL and creates the a_uWidth by
+	// a_uHeight framebuffer. false if any of it failed, the reason is printed
+	bool Create(unsigned int a_uWidth, unsigned int a_uHeight);
+	void Destroy();
+
+	// binds the framebuffer and sets the viewport to cover it
+	void Bind() const;
+	// reads the framebuffer back as RGBA rows, top row first
+	void ReadPixels(std::vector<unsigned char>& a_aucPixels) const;
+
+	unsigned int GetWidth() const { return m_uWidth; }
+	unsigned int GetHeight() const { return m_uHeight; }
+
+	// writes RGBA rows, top row first, as a PNG. the image data is stored rather than compressed, which keeps
+	// the writer small at the cost of file size
+	static bool WritePng(const std::string& a_sPath, unsigned int a_uWidth, unsigned int a_uHeight, const std::vector<unsigned char>& a_aucPixels);
+
+private:
+	HeadlessContext(const HeadlessContext&);
+	HeadlessContext& operator=(const HeadlessContext&);
+
+	// the EGL display and context, or the hidden GLFW window
+	void* m_pDisplay;
+	void* m_pContext;
+
+	unsigned int m_uFramebuffer;
+	unsigned int m_uColourBuffer;
+	unsigned int m_uDepthBuffer;
+	unsigned int m_uWidth;
+	unsigned int m_uHeight;
+};
+
+#endif // !HEADLESSCONTEXT_H
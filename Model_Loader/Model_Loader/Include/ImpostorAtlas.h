@@ -0,0 +1,97 @@
+#ifndef IMPOSTORATLAS_H
+#define IMPOSTORATLAS_H
+
+// Project Includes
+#include "AssetManager.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// Forward declerations
+class Model;
+class Mesh;
+class Shader;
+
+/// <summary>
+/// A model baked from a spread of view directions into one texture, so it can be drawn far away as a single
+/// quad. The directions are laid out octahedrally, a square grid of frames covering the whole sphere, and the
+/// impostor shader picks the frame nearest the direction each instance is seen from. The shaders come from the
+/// asset manager and the bake is spread over a few frames, so making an atlas never stalls the frame it's made in
+/// </summary>
+class ImpostorAtlas
+{
+public:
+	// starts loading the shaders for baking a_pModel from a_uFramesPerSide * a_uFramesPerSide directions into
+	// frames a_uFrameSize pixels square. the model has to outlive the atlas
+	ImpostorAtlas(Model* a_pModel, AssetManager* a_pAssetManager, unsigned int a_uFramesPerSide = 16, unsigned int a_uFrameSize = 64);
+	~ImpostorAtlas();
+
+	// bakes a few more rows of frames once the shaders are resident, then runs one pass of the dilation, and
+	// mips the atlas after the last. on the context's thread, once a frame until it returns true, which it
+	// does once the atlas is baked
+	bool Update();
+
+	// false until the bake is done, or if it failed. nothing should be drawn with it then
+	bool IsValid() const { return m_eState == ATLAS_READY; }
+
+	// the shader and the quad (textured with the atlas) to queue instanced impostors with. the quad reads the
+	// same per instance model matrices as the model's meshes
+	Shader* GetShader() const { return m_xShader->Get(); }
+	Mesh* GetQuad() const { return m_pQuad; }
+	unsigned int GetTexture() const { return m_uTexture; }
+
+	// the direction at the centre of a point in the atlas (0 to 1 each way), the inverse of the shaders octEncode
+	static glm::vec3 OctahedralDecode(const glm::vec2& a_v2Point);
+
+private:
+	ImpostorAtlas(const ImpostorAtlas&);
+	ImpostorAtlas& operator=(const ImpostorAtlas&);
+
+	enum STATE
+	{
+		// waiting for the shaders to be resident
+		ATLAS_WAITING,
+		ATLAS_BAKING,
+		ATLAS_READY,
+		ATLAS_FAILED
+	};
+
+	// makes the texture and framebuffer the frames are baked into, false if the framebuffer is incomplete
+	bool BeginBake();
+	// renders a_uRowCount rows of frames from a_uFirstRow
+	void BakeRows(unsigned int a_uFirstRow, unsigned int a_uRowCount);
+	// makes the atlas and what the dilation passes write into
+	void BeginDilation();
+	// one pass of spreading the colour of the model out over the empty texels of its frame, alpha is left at zero
+	void DilatePass(unsigned int a_uPass);
+	unsigned int GetDilatePassCount() const;
+	// mips the atlas, makes the quad and sets the frame layout on the shader
+	void FinishBake();
+	// deletes everything only the bake needs
+	void EndBake();
+
+	Model* m_pModel;
+	unsigned int m_uFramesPerSide;
+	unsigned int m_uFrameSize;
+	float m_fRadius;
+	STATE m_eState;
+	unsigned int m_uNextRow;
+	unsigned int m_uNextPass;
+
+	ShaderHandle m_xShader;
+	ShaderHandle m_xBakeShader;
+	ShaderHandle m_xDilateShader;
+
+	// the frames as baked, before they are dilated into the atlas
+	unsigned int m_uBakeTexture;
+	unsigned int m_uBakeDepth;
+	unsigned int m_uFramebuffer;
+	// each dilation pass reads the seeds of the pass before, so they go back and forth between two textures
+	unsigned int m_auSeeds[2];
+	unsigned int m_uVertexArray;
+	unsigned int m_uTexture;
+
+	Mesh* m_pQuad;
+};
+
+#endif // !IMPOSTORATLAS_H
@@ -2,8 +2,12 @@
 #define MODELCOMPONENT_H
 
 #include "Component.h"
+#include "AssetManager.h"
 
-class Model;
+// GLM includes
+#include <glm/glm.hpp>
+
+class RenderQueue;
 
 /// <summary>
 /// Header file for the model component
@@ -20,13 +24,21 @@ public:
     virtual void Update(float a_fDeltaTime, float a_fBoundingBox) {};
     virtual void Draw(Shader* a_pShader);
 
-    // set the model file to be used for the boids
-    void SetModel(Model* pNewModel) { m_pModelData = pNewModel; }
+    // set the model used for the boids, it is drawn as its placeholder until it has loaded
+    void SetModel(const ModelHandle& a_xNewModel) { m_xModel = a_xNewModel; }
     // set the scale of the model
     void SetScale(float a_fNewScale) { m_fModelScale = a_fNewScale; }
 
+    // queues every mesh of the model with the entities model matrix
+    void Submit(Shader* a_pShader, RenderQueue& a_xQueue) const;
+
+    // returns the model drawn for the boid, its placeholder while it loads
+    Model* GetModel() const { return m_xModel ? m_xModel->Get() : nullptr; }
+    // works out the matrix the model is drawn with, returns false if the entity has no transform
+    bool GetModelMatrix(glm::mat4& a_m4ModelMatrix) const;
+
 private:
-    Model* m_pModelData;
+    ModelHandle m_xModel;
     float m_fModelScale;
 };
 
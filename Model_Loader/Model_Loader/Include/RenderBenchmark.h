@@ -0,0 +1,35 @@
+#ifndef RENDERBENCHMARK_H
+#define RENDERBENCHMARK_H
+
+// std includes
+#include <string>
+
+/// <summary>
+/// Runs the scene headless for a fixed number of frames with the camera orbiting the flock, and writes how
+/// long each frame took as CSV. The frames can also be saved as PNGs to check what was drawn
+/// </summary>
+class RenderBenchmark
+{
+public:
+	struct Options
+	{
+		// frames run before measuring starts, so the boids have spawned and the buffers have grown
+		unsigned int uWarmupFrames = 60;
+		unsigned int uFrames = 600;
+		int iBoids = 500;
+		bool bThreadedSimulation = true;
+		std::string sCsvPath = "benchmark.csv";
+		// every uPngInterval'th measured frame is saved into sPngDirectory, which has to exist. 0 saves none
+		std::string sPngDirectory;
+		unsigned int uPngInterval = 0;
+		// the measured frames' render passes as a Chrome trace, none if empty
+		std::string sTracePath;
+	};
+
+	// reads the options after --benchmark, false if one isn't understood
+	static bool ParseArguments(int a_iArgCount, char** a_aszArgs, Options& a_xOptions);
+	// returns the process exit code
+	static int Run(const Options& a_xOptions);
+};
+
+#endif // !RENDERBENCHMARK_H
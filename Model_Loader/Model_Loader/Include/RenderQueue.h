@@ -0,0 +1,78 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+// Project Includes
+#include "RenderState.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <map>
+#include <utility>
+#include <vector>
+
+// Forward declerations
+class Mesh;
+class Shader;
+
+/// <summary>
+/// Collects the frames draws and issues them sorted by program, then material, then vertex array, so
+/// draws that share state sit next to each other. The binds go through a RenderState so the ones that
+/// wouldn't change anything are skipped
+/// </summary>
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// clears last frames counts and forgets the bound state, which anything could have changed since
+	void BeginFrame();
+
+	// queues a mesh drawn once with the given model matrix
+	void Submit(Shader* a_pShader, Mesh* a_pMesh, const glm::mat4& a_m4Model);
+	// queues a_uInstanceCount copies of a mesh at level of detail a_uLod, reading their model matrices from
+	// a_uInstanceBuffer from a_uBaseInstance on
+	void SubmitInstanced(Shader* a_pShader, Mesh* a_pMesh, unsigned int a_uInstanceBuffer, unsigned int a_uInstanceCount, unsigned int a_uBaseInstance, unsigned int a_uLod = 0);
+
+	// sorts and draws everything queued, then empties the queue
+	void Flush();
+
+	// this frames counts
+	unsigned int GetDrawCallCount() const { return m_uDrawCallCount; }
+	const RenderStateCounts& GetStateCounts() const { return m_xState.GetCounts(); }
+
+private:
+	struct DrawItem
+	{
+		Shader* pShader;
+		Mesh* pMesh;
+		glm::mat4 m4Model;
+		unsigned int uInstanceBuffer;
+		// 0 for a draw that uses m4Model
+		unsigned int uInstanceCount;
+		unsigned int uBaseInstance;
+		unsigned int uLod;
+	};
+
+	// packs the program, material and vertex array into a key that sorts in that order
+	unsigned long long MakeSortKey(const Shader* a_pShader, const Mesh* a_pMesh);
+	// the id of the set of textures a mesh uses, meshes with the same textures share an id. it is looked up
+	// from the texture names on every submit rather than remembered per mesh, as models are freed and loaded
+	// again and a new mesh can land where an old one was
+	unsigned int GetMaterialId(const Mesh* a_pMesh);
+
+	std::vector<DrawItem> m_axItems;
+	// sort key and index into m_axItems, sorted instead of the items themselves
+	std::vector<std::pair<unsigned long long, unsigned int>> m_axOrder;
+
+	// the ids only have to agree within one flush, so they start again after each
+	std::map<std::vector<unsigned int>, unsigned int> m_xMaterialIds;
+	// the texture names of the mesh being submitted, kept so looking them up doesn't allocate
+	std::vector<unsigned int> m_auTextures;
+
+	RenderState m_xState;
+	unsigned int m_uDrawCallCount;
+};
+
+#endif // !RENDERQUEUE_H
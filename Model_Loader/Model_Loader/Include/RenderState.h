@@ -0,0 +1,47 @@
+#ifndef RENDERSTATE_H
+#define RENDERSTATE_H
+
+// the number of texture units whose bindings are tracked, binds to units past it always go through
+static const unsigned int uTRACKED_TEXTURE_UNITS = 16;
+
+// how many state changes went to GL and how many were skipped because nothing changed
+struct RenderStateCounts
+{
+	unsigned int uProgramChanges;
+	unsigned int uVertexArrayChanges;
+	unsigned int uTextureChanges;
+	unsigned int uSkippedChanges;
+};
+
+/// <summary>
+/// Remembers the program, vertex array and textures last bound through it and skips any bind that
+/// wouldn't change anything. It only knows about binds made through it, so Invalidate has to be called
+/// whenever anything else (ImGui, Gizmos) might have touched the state
+/// </summary>
+class RenderState
+{
+public:
+	RenderState();
+
+	void UseProgram(unsigned int a_uProgram);
+	void BindVertexArray(unsigned int a_uVertexArray);
+	void BindTexture2D(unsigned int a_uUnit, unsigned int a_uTexture);
+
+	// forgets what is bound so the next bind of each goes through
+	void Invalidate();
+
+	// the counts since the last reset
+	const RenderStateCounts& GetCounts() const { return m_xCounts; }
+	void ResetCounts();
+
+private:
+	// ~0u means unknown, so nothing matches it
+	unsigned int m_uProgram;
+	unsigned int m_uVertexArray;
+	unsigned int m_uActiveUnit;
+	unsigned int m_auTextures[uTRACKED_TEXTURE_UNITS];
+
+	RenderStateCounts m_xCounts;
+};
+
+#endif // !RENDERSTATE_H
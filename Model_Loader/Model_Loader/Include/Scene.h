@@ -1,32 +1,94 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+// Project includes
+#include "AssetManager.h"
+#include "BoidBehaviours.h"
+#include "BoidSnapshot.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 // Forward decleration
 struct GLFWwindow;
 class Camera;
 class Shader;
 class Model;
+class Entity;
+class SystemScheduler;
+class BoidForceSystem;
+class BoidMovementSystem;
+class PlanarFlockSystem;
+class SceneGizmoSystem;
+class FrameUniforms;
+class RenderQueue;
+class GpuFlock;
+class ImpostorAtlas;
+class FlockDebugDraw;
+class BoidRenderer;
+class HeadlessContext;
+class GpuProfiler;
+class TraceRecorder;
 
 class Scene
 {
 public:
 	static Scene* GetInstance();
 
-	// initial setup function
-	bool Initialise();
-	// processes to be done each frame
+	// initial setup function. a headless scene draws into a framebuffer of its own with no window, ImGui or input
+	bool Initialise(bool a_bHeadless = false);
+	// processes to be done each frame on the render thread, the simulation is stepped on its own thread
 	bool Update();
-	// rendering each frame
+	// rendering each frame, from the latest snapshot the simulation published
 	void Render();
 	// closes everything down when the application is closed
 	void Deinitialise();
 
+	// what the panels would otherwise set, for driving the scene from code
+	void SetCamera(const glm::vec3& a_v3Position, const glm::vec3& a_v3Target);
+	void SetBoidCount(int a_iCount);
+	void SetThreadedSimulation(bool a_bThreaded);
+	// records the next a_uFrames frames' pass timings to a_sPath as a Chrome trace
+	void StartTrace(const std::string& a_sPath, unsigned int a_uFrames);
+
+	// null unless the scene is headless
+	const HeadlessContext* GetHeadlessContext() const { return m_pHeadlessContext; }
+	// what the last frame drew, and how long the step it drew took to simulate
+	unsigned int GetDrawCallCount() const;
+	unsigned int GetBoidCount() const { return m_xSnapshots.GetReadBuffer().GetBoidCount(); }
+	unsigned int GetVisibleBoidCount() const;
+	float GetSimulationStepMs() const { return m_xSnapshots.GetReadBuffer().fStepMs; }
+	// the GPU time of the newest frame the GPU has finished, a few frames behind the one just drawn
+	float GetGpuFrameMs() const;
+
 private:
 	// constructors
 	Scene();
 	Scene(const Scene&);
 	Scene& operator=(const Scene&);
 
+	// what the simulation runs with. the panels edit their own copy, and send it over when it changes
+	struct SimulationSettings
+	{
+		FlockWeights xWeights;
+		glm::vec3 v3BoxPos;
+		int iBoidCount;
+		bool bPlanarFlock;
+		bool bGpuFlock;
+	};
+	// a change for the simulation to make before its next step, run on the simulation thread
+	typedef std::function<void()> SimulationCommand;
+
 	// adjusts the window
 	static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 	// mouse pos
@@ -34,19 +96,135 @@ private:
 	// scroll 
 	static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
+	// loads the models and sets up the systems and boids once there is a context
+	bool InitialiseScene();
+
 	// random values
 	int RandomIntBewtweenRange(int a_iLowerRange, int a_iUpperRange);
 	float RandomFloatBetweenRange(float a_fLowerRange, float a_fUpperRange);
 
+	// runs one step of the simulation and publishes a snapshot of it, on whichever thread owns the simulation
+	void StepSimulation(float a_fDeltaTime);
+	// copies what the render thread needs out of the entities
+	void WriteSnapshot(BoidSnapshot& a_xSnapshot) const;
+	// the simulation thread, it steps once for each frame the render thread starts
+	void SimulationLoop();
+	void StartSimulationThread();
+	void StopSimulationThread();
+	// the panels' values, and sending them to the simulation if they changed since they were last sent
+	SimulationSettings GetPanelSettings() const;
+	void SendSettings();
+	// applies settings from the panels, simulation thread only
+	void ApplySettings(const SimulationSettings& a_xSettings);
+
 	// updates the values for the weights of each force on the boids
 	void UpdateBoidWeights();
 	// modifies boid number
 	void UpdateBoidNumber();
+	// adds the boid components to a new entity
+	void SetupBoid(Entity* a_pEntity);
+	// switches on the systems for whichever flock is in use
+	void UpdateFlockSystems();
+	// hands the boids over to the GPU flock, keeping any already on it, and back to their entities. stopping
+	// sends the boids to the simulation thread, and fails if the command queue is full
+	void StartGpuFlock(const BoidSnapshot& a_xSnapshot);
+	bool StopGpuFlock();
+	// puts the boids read back from the GPU into their entities, simulation thread only
+	void WriteBackGpuFlock(const std::vector<unsigned int>& a_auEntityIDs, const std::vector<glm::vec3>& a_av3Positions,
+		const std::vector<glm::vec3>& a_av3Velocities);
+	// starts a_sPath loading and sends it to the simulation for every boid, they draw its placeholder until it
+	// is resident
+	void SwapBoidModel(const std::string& a_sPath);
+	// gives every boid a_xModel, and any spawned after, simulation thread only
+	void SetBoidModel(const ModelHandle& a_xModel);
+	// bakes the impostors once the boid model is resident, and lets go of swapped out models once no snapshot
+	// still drawn can have them, render thread only
+	void UpdateBoidModel(const BoidSnapshot& a_xSnapshot);
 	
 	GLFWwindow* m_window;
+	// the window's stand in when the scene is headless
+	HeadlessContext* m_pHeadlessContext;
 	Camera* m_camera;
-	Shader* m_shader;
-	Model* m_model;
+	// loads the models and shaders on threads of its own, the scene holds the ones it draws with
+	AssetManager* m_pAssetManager;
+	ShaderHandle m_xShader;
+	// the boid model, which the panel can swap for another file
+	ModelHandle m_xModel;
+	char m_szModelPath[256];
+	// a swapped out model, held until the snapshot drawn was written after the swap that let go of it
+	struct RetiredModel
+	{
+		ModelHandle xModel;
+		unsigned int uSwap;
+	};
+	std::vector<RetiredModel> m_axRetiredModels;
+	// how many swaps have been sent to the simulation
+	unsigned int m_uModelSwaps = 0;
+
+	// runs the per frame systems, and the systems that need values from the scene each frame
+	SystemScheduler* m_pScheduler;
+	BoidForceSystem* m_pForceSystem;
+	BoidMovementSystem* m_pMovementSystem;
+	PlanarFlockSystem* m_pPlanarSystem;
+	// the gizmos upload to GL, so they are updated on the render thread rather than by the scheduler
+	SceneGizmoSystem* m_pGizmoSystem;
+
+	// the simulation runs a frame ahead on its own thread, taking edits from the panels through the command
+	// queue and handing each finished step to the render thread as a snapshot
+	bool m_bThreadedSimulation = true;
+	SimulationSettings m_xSimSettings;
+	// the model new boids are given, and how many swaps the simulation has run
+	ModelHandle m_xSimModel;
+	unsigned int m_uSimModelSwaps = 0;
+	SimulationSettings m_xSentSettings;
+	SpscQueue<SimulationCommand> m_xSimCommands;
+	TripleBuffer<BoidSnapshot> m_xSnapshots;
+	unsigned int m_uSimStep = 0;
+	std::thread m_xSimThread;
+	// only used to wake the simulation thread when a frame starts, no simulation data is behind the lock
+	std::mutex m_xTickMutex;
+	std::condition_variable m_xTickCondition;
+	unsigned int m_uTicks = 0;
+	// the frame time since the simulation last stepped, it steps by all of it at once
+	float m_fTickDeltaTime = 0.0f;
+	bool m_bSimRunning = false;
+	bool m_bShowSystemGraph = false;
+	// runs the boids as a flat 2D flock instead of through their brains
+	bool m_bPlanarFlock = false;
+	// runs the boids with compute shaders instead, they are drawn straight from the GPU buffers
+	GpuFlock* m_pGpuFlock;
+	bool m_bGpuFlock = false;
+	// the entity each boid on the GPU belongs to
+	std::vector<unsigned int> m_auGpuEntityIDs;
+	// scratch for moving boids between the GPU and the snapshots
+	std::vector<glm::vec3> m_av3GpuPositions;
+	std::vector<glm::vec3> m_av3GpuVelocities;
+
+	// draws the boids with one instanced draw per mesh rather than one draw per boid
+	BoidRenderer* m_pBoidRenderer;
+	bool m_bInstancedRendering = true;
+	// skips the boids outside the camera before they are drawn, optionally across the thread pool
+	bool m_bFrustumCulling = true;
+	bool m_bParallelCulling = true;
+	// draws distant boids with their simplified meshes
+	bool m_bLodSelection = true;
+	// the boid model (once it is resident) baked into billboards, drawn instead of the mesh past m_fImpostorDistance
+	ImpostorAtlas* m_pImpostorAtlas;
+	const Model* m_pImpostorModel;
+	bool m_bImpostors = true;
+	float m_fImpostorDistance = 12.0f;
+	// draws each boid's velocity, neighbourhood and behaviour forces, instanced so it keeps up with big flocks
+	FlockDebugDraw* m_pFlockDebugDraw;
+	bool m_bShowVelocities = false;
+	bool m_bShowNeighbourhoods = false;
+	bool m_bShowForces = false;
+	// the view and projection, uploaded once a frame for the model and gizmo shaders
+	FrameUniforms* m_pFrameUniforms;
+	// sorts the frames draws and skips binds that wouldn't change anything
+	RenderQueue* m_pRenderQueue;
+	// times each render pass on the CPU and GPU, and writes those times out as a trace when asked
+	GpuProfiler* m_pGpuProfiler;
+	TraceRecorder* m_pTraceRecorder;
 
 	float m_lastX;
 	float m_lastY;
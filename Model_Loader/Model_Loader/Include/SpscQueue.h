@@ -0,0 +1,62 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+// std includes
+#include <atomic>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// A fixed size ring that one thread pushes onto and one other thread pops from, without locks. Each side
+/// only writes its own end of the ring, and reads the other end to see how far it can go, so a push is seen
+/// by the consumer only once the value is in its slot
+/// </summary>
+template <typename T>
+class SpscQueue
+{
+public:
+	// holds a_uCapacity values before Push starts failing
+	SpscQueue(unsigned int a_uCapacity) : m_axSlots(a_uCapacity + 1), m_uHead(0), m_uTail(0) {}
+
+	// producer thread only. returns false if the queue is full, a_xValue is left untouched then
+	bool Push(T&& a_xValue)
+	{
+		unsigned int uTail = m_uTail.load(std::memory_order_relaxed);
+		unsigned int uNext = Next(uTail);
+		if (uNext == m_uHead.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		m_axSlots[uTail] = std::move(a_xValue);
+		m_uTail.store(uNext, std::memory_order_release);
+		return true;
+	}
+
+	// consumer thread only. returns false if there is nothing to pop
+	bool Pop(T& a_xValue)
+	{
+		unsigned int uHead = m_uHead.load(std::memory_order_relaxed);
+		if (uHead == m_uTail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		a_xValue = std::move(m_axSlots[uHead]);
+		m_axSlots[uHead] = T();
+		m_uHead.store(Next(uHead), std::memory_order_release);
+		return true;
+	}
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator=(const SpscQueue&);
+
+	unsigned int Next(unsigned int a_uIndex) const { return a_uIndex + 1 < m_axSlots.size() ? a_uIndex + 1 : 0; }
+
+	// one slot is always left empty so a full ring can be told apart from an empty one
+	std::vector<T> m_axSlots;
+	// the consumer's and producer's ends
+	std::atomic<unsigned int> m_uHead;
+	std::atomic<unsigned int> m_uTail;
+};
+
+#endif // !SPSCQUEUE_H
@@ -0,0 +1,57 @@
+#ifndef STREAMINGBUFFER_H
+#define STREAMINGBUFFER_H
+
+// std includes
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// A buffer for data that is rewritten every frame. The storage is split into a ring of regions and
+/// stays mapped for the life of the buffer, so the CPU writes straight into memory the GPU reads from.
+/// Each region is fenced once the draws using it are issued, and only reused once that fence has passed,
+/// so the next frame can be written (from any thread) while the GPU is still reading the last one
+/// </summary>
+class StreamingBuffer
+{
+public:
+	// a_uRegionSize is the number of bytes available each frame, a_uRegionCount how many frames can be in flight
+	StreamingBuffer(size_t a_uRegionSize, unsigned int a_uRegionCount = 3);
+	~StreamingBuffer();
+
+	// waits until the next region is free and returns a pointer to write a_uBytes into. the buffer is
+	// reallocated if a_uBytes is more than a region holds. only call from the thread that owns the context
+	void* BeginRegion(size_t a_uBytes);
+	// fences the current region, call once the draws that read it have been issued
+	void EndRegion();
+
+	// the GL buffer and the byte offset of the current region within it, regions start on 256 byte boundaries
+	unsigned int GetBuffer() const { return m_uBuffer; }
+	size_t GetRegionOffset() const { return m_uCurrentRegion * m_uRegionSize; }
+	size_t GetRegionSize() const { return m_uRegionSize; }
+
+	// how many times BeginRegion had to wait for the GPU, and for how long in total
+	unsigned int GetStallCount() const { return m_uStallCount; }
+	float GetStallMs() const { return m_fStallMs; }
+
+private:
+	StreamingBuffer(const StreamingBuffer&);
+	StreamingBuffer& operator=(const StreamingBuffer&);
+
+	// creates the storage for the current region size and maps it
+	void CreateStorage();
+	// blocks until the fence on the given region has passed
+	void WaitForRegion(unsigned int a_uRegion);
+
+	unsigned int m_uBuffer;
+	unsigned char* m_pMapped;
+	size_t m_uRegionSize;
+	unsigned int m_uRegionCount;
+	unsigned int m_uCurrentRegion;
+	// one GLsync per region, null when nothing is reading it
+	std::vector<void*> m_apFences;
+
+	unsigned int m_uStallCount;
+	float m_fStallMs;
+};
+
+#endif // !STREAMINGBUFFER_H
@@ -0,0 +1,72 @@
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+// Project Includes
+#include "Component.h"
+
+// std includes
+#include <string>
+
+// Forward declerations
+class CommandBuffer;
+class CommandQueue;
+
+// shared data that isn't a component but still needs guarding when systems run side by side.
+// these share the access mask with COMPONENT_TYPE so they start well clear of it
+enum SYSTEM_RESOURCE
+{
+	RESOURCE_GIZMOS = 16,
+};
+
+typedef unsigned int AccessMask;
+
+// returns the bit used to represent a component type or resource in an access mask
+inline AccessMask AccessBit(unsigned int a_uTypeOrResource) { return 1u << a_uTypeOrResource; }
+
+/// <summary>
+/// A unit of per frame work. Each system declares what it reads and writes so that
+/// the scheduler can work out which systems are safe to run at the same time
+/// </summary>
+class System
+{
+public:
+	System(const char* a_szName);
+	virtual ~System() {}
+
+	// work to be done each frame
+	virtual void Update(float a_fDeltaTime, float a_fBoundingBoxSize) = 0;
+
+	// returns the name shown in the debug view
+	const std::string& GetName() const { return m_sName; }
+
+	// returns the masks of what the system reads and writes
+	AccessMask GetReadMask() const { return m_uReadMask; }
+	AccessMask GetWriteMask() const { return m_uWriteMask; }
+
+	// disabled systems are left out of the frame graph
+	bool IsEnabled() const { return m_bEnabled; }
+	void SetEnabled(bool a_bEnabled) { m_bEnabled = a_bEnabled; }
+
+	// returns true if the two systems touch the same data and at least one of them writes it
+	bool ConflictsWith(const System& a_xOther) const;
+
+protected:
+	// returns the calling threads command buffer, used to spawn or despawn entities while the
+	// system is running. the commands are applied once all of the frames systems have finished
+	CommandBuffer& GetCommandBuffer();
+
+	// declare the component types or resources this system accesses
+	void Reads(unsigned int a_uTypeOrResource) { m_uReadMask |= AccessBit(a_uTypeOrResource); }
+	void Writes(unsigned int a_uTypeOrResource) { m_uWriteMask |= AccessBit(a_uTypeOrResource); }
+
+private:
+	friend class SystemScheduler;
+
+	std::string m_sName;
+	CommandQueue* m_pCommandQueue;
+	AccessMask m_uReadMask;
+	AccessMask m_uWriteMask;
+	bool m_bEnabled;
+};
+
+#endif // !SYSTEM_H
@@ -0,0 +1,91 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+// Project Includes
+#include "TripleBuffer.h"
+
+// std includes
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Forward declerations
+class System;
+class ThreadPool;
+class TaskGroup;
+class CommandQueue;
+
+/// <summary>
+/// Runs the registered systems each frame. Systems are ordered by registration, and a system only
+/// waits on the earlier systems it conflicts with, so independent systems run side by side on the pool
+/// </summary>
+class SystemScheduler
+{
+public:
+	SystemScheduler(ThreadPool* a_pThreadPool);
+	~SystemScheduler();
+
+	// adds a system to the end of the frame, the scheduler takes ownership of it
+	void AddSystem(System* a_pSystem);
+
+	// builds the frame graph and runs every enabled system, returns once they have all finished
+	// and the commands they recorded have been applied
+	void Run(float a_fDeltaTime, float a_fBoundingBoxSize);
+
+	// returns the queue flushed at the end of each run, anything recorded outside of the
+	// systems is applied before the commands of the systems themselves
+	CommandQueue* GetCommandQueue() { return m_pCommandQueue; }
+
+	// shows the graph of the last frame that was run along with its critical path. it works from a copy of the
+	// last finished frame, so it can be called from another thread while Run is going
+	void ShowDebugWindow(bool* a_pbOpen);
+
+private:
+	struct SystemNode
+	{
+		System* pSystem;
+		// nodes that can't start until this one has finished
+		std::vector<unsigned int> auDependants;
+		// nodes this one waited on
+		std::vector<unsigned int> auDependencies;
+
+		// timings of the last run, in ms from the start of the frame
+		float fStartMs;
+		float fEndMs;
+		unsigned int uThreadIndex;
+		bool bOnCriticalPath;
+	};
+
+	// a finished frame's graph and timings, as handed to the debug window
+	struct GraphReport
+	{
+		std::vector<SystemNode> axNodes;
+		float fFrameMs = 0.0f;
+		float fCriticalPathMs = 0.0f;
+	};
+
+	// works out the dependencies between this frames enabled systems
+	void BuildGraph();
+	// runs a node then releases any dependants that were waiting on it
+	void RunNode(unsigned int a_uNodeIndex, float a_fDeltaTime, float a_fBoundingBoxSize);
+	// marks the longest chain of dependant systems
+	void FindCriticalPath();
+
+	ThreadPool* m_pThreadPool;
+	CommandQueue* m_pCommandQueue;
+	std::vector<System*> m_apSystems;
+	std::vector<SystemNode> m_axNodes;
+	// count of unfinished dependencies per node, kept apart from the nodes as atomics can't be copied
+	std::unique_ptr<std::atomic<unsigned int>[]> m_auRemainingDependencies;
+	unsigned int m_uRemainingCapacity;
+
+	std::chrono::high_resolution_clock::time_point m_xFrameStart;
+	TaskGroup* m_pFrameGroup;
+
+	float m_fFrameMs;
+	float m_fCriticalPathMs;
+	TripleBuffer<GraphReport> m_xReports;
+};
+
+#endif // !SYSTEMSCHEDULER_H
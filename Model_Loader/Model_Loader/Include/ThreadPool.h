@@ -0,0 +1,89 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// std includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a group of tasks that can be waited on together
+class TaskGroup
+{
+public:
+	TaskGroup() : m_iPendingTasks(0) {}
+
+	// returns true once every task submitted to the group has finished
+	bool IsComplete() const { return m_iPendingTasks.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class ThreadPool;
+	std::atomic<int> m_iPendingTasks;
+};
+
+class ThreadPool
+{
+public:
+	static ThreadPool* GetInstance();
+	// stops the workers and frees the pool
+	static void DestroyInstance();
+
+	// queues a task to be run on a worker thread
+	void Submit(std::function<void()> a_xTask, TaskGroup* a_pGroup = nullptr);
+	// blocks until the group is complete, running the group's queued tasks on the calling thread while it waits
+	void Wait(TaskGroup& a_xGroup);
+	// splits [0, a_uCount) into chunks of a_uGrainSize and runs them across the pool and the calling thread
+	void ParallelFor(unsigned int a_uCount, unsigned int a_uGrainSize, const std::function<void(unsigned int, unsigned int)>& a_xBody);
+
+	// returns the number of worker threads (not counting the calling thread)
+	unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_axWorkers.size()); }
+	// returns 0 for any thread outside the pool, 1..GetWorkerCount() for the workers, or GetWorkerCount() + 1
+	// for the thread outside the pool that claimed it
+	static unsigned int GetThreadIndex();
+	// gives the calling thread, which must not be a worker, the index after the workers so per thread data
+	// indexed by GetThreadIndex isn't shared with the other threads outside the pool. one thread at a time
+	void ClaimThreadIndex();
+	// the number of different indices GetThreadIndex can return
+	unsigned int GetThreadIndexCount() const { return GetWorkerCount() + 2; }
+
+	// a value describing what the calling thread is working on. a task runs under the tag of the thread
+	// that submitted it, whichever thread picks it up, so work split across the pool (ParallelFor's chunks
+	// included) still knows who it belongs to
+	static void SetTaskTag(unsigned int a_uTag);
+	static unsigned int GetTaskTag();
+
+private:
+	// constructors
+	ThreadPool(unsigned int a_uWorkerCount);
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+	~ThreadPool();
+
+	struct Task
+	{
+		std::function<void()> xFunction;
+		TaskGroup* pGroup;
+		// the submitting thread's tag
+		unsigned int uTag;
+	};
+
+	// loop run by each of the worker threads
+	void WorkerLoop(unsigned int a_uThreadIndex);
+	// runs a task under its tag and signals its group
+	void RunTask(Task& a_xTask);
+
+	std::vector<std::thread> m_axWorkers;
+	std::deque<Task> m_axTaskQueue;
+	std::mutex m_xQueueMutex;
+	std::condition_variable m_xWakeCondition;
+	// threads in Wait sleep on their own condition, as they only take tasks from the group they are waiting on
+	std::condition_variable m_xWaitCondition;
+	bool m_bShuttingDown;
+
+	static ThreadPool* s_pInstance;
+};
+
+#endif // !THREADPOOL_H
@@ -0,0 +1,59 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+// Project includes
+#include "GpuProfiler.h"
+
+// std includes
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Collects the profiler's frames and writes them out in the Chrome trace event format, which
+/// chrome://tracing and ui.perfetto.dev open. The CPU and GPU times of each pass go on tracks of their own
+/// </summary>
+class TraceRecorder
+{
+public:
+	TraceRecorder();
+
+	// starts collecting, the trace is written to a_sPath after a_uFrames frames or when Stop is called
+	void Start(const std::string& a_sPath, unsigned int a_uFrames);
+	// writes what has been collected, false if nothing was recording or the file couldn't be written
+	bool Stop();
+
+	// adds a frame if recording, frames arrive as the GPU finishes them so a few frames after they were drawn
+	void AddFrame(const GpuProfiler::FrameTimings& a_xFrame);
+
+	bool IsRecording() const { return m_bRecording; }
+	unsigned int GetRecordedFrames() const { return m_uRecordedFrames; }
+	unsigned int GetFrameLimit() const { return m_uFrameLimit; }
+
+private:
+	TraceRecorder(const TraceRecorder&);
+	TraceRecorder& operator=(const TraceRecorder&);
+
+	enum Track
+	{
+		TRACK_CPU = 1,
+		TRACK_GPU
+	};
+
+	struct Event
+	{
+		std::string sName;
+		Track eTrack;
+		double dStartUs;
+		double dDurationUs;
+	};
+
+	void AddEvent(const std::string& a_sName, Track a_eTrack, double a_dStartUs, double a_dDurationUs);
+
+	std::string m_sPath;
+	std::vector<Event> m_axEvents;
+	unsigned int m_uFrameLimit;
+	unsigned int m_uRecordedFrames;
+	bool m_bRecording;
+};
+
+#endif // !TRACERECORDER_H
@@ -0,0 +1,59 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+// std includes
+#include <atomic>
+
+/// <summary>
+/// Hands whole values from one writing thread to one reading thread without either waiting on the other.
+/// There are three slots, one the writer is filling, one the reader is looking at, and one in between
+/// holding the last value published. Publishing and acquiring each swap a slot with the one in between,
+/// so the reader always sees a complete value and the writer never overwrites what is being read.
+/// The slots are reused, so a value keeps whatever it allocated from one publish to the next
+/// </summary>
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : m_uShared(1), m_uWriteIndex(0), m_uReadIndex(2) {}
+
+	// the slot to fill before publishing, writer thread only. it still holds what was published two times ago
+	T& GetWriteBuffer() { return m_axSlots[m_uWriteIndex]; }
+	// makes the filled slot the latest value, writer thread only
+	void Publish()
+	{
+		unsigned int uPrevious = m_uShared.exchange(m_uWriteIndex | uFRESH_BIT, std::memory_order_acq_rel);
+		m_uWriteIndex = uPrevious & uINDEX_MASK;
+	}
+
+	// swaps in the latest value if one was published since the last call, reader thread only. returns false if
+	// there was nothing new, the read slot is left as it was then
+	bool Acquire()
+	{
+		if ((m_uShared.load(std::memory_order_relaxed) & uFRESH_BIT) == 0)
+		{
+			return false;
+		}
+		unsigned int uPrevious = m_uShared.exchange(m_uReadIndex, std::memory_order_acq_rel);
+		m_uReadIndex = uPrevious & uINDEX_MASK;
+		return true;
+	}
+	// the value acquired last, reader thread only. a default value until the first publish is acquired
+	const T& GetReadBuffer() const { return m_axSlots[m_uReadIndex]; }
+
+private:
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+
+	// the shared slot's index is kept with a bit saying whether the reader has had it yet
+	static const unsigned int uINDEX_MASK = 3;
+	static const unsigned int uFRESH_BIT = 4;
+
+	T m_axSlots[3];
+	std::atomic<unsigned int> m_uShared;
+	// only ever touched by their own threads
+	unsigned int m_uWriteIndex;
+	unsigned int m_uReadIndex;
+};
+
+#endif // !TRIPLEBUFFER_H
@@ -0,0 +1,573 @@
+// This files header
+#include "AssetManager.h"
+
+// LearnOpenGL includes
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+#include <learnopengl/texture_cache.h>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+// std includes
+#include <algorithm>
+#include <iostream>
+
+// TypeDef
+typedef std::chrono::high_resolution_clock Clock;
+
+// constants
+// each loader reads one asset at a time, and a model decodes its textures on threads of its own
+static const unsigned int uLOADER_THREADS = 2;
+
+// constructor
+Asset::Asset(const std::string& a_sPath) : m_sPath(a_sPath), m_eState(ASSET_QUEUED), m_fLoadMs(0.0f), m_bReleased(false), m_uCpuBytes(0),
+	m_uGpuBytes(0)
+{
+}
+
+// constructor
+ModelAsset::ModelAsset(const std::string& a_sPath, const std::vector<float>& a_afLodRatios, unsigned int a_uAttributeMask, bool a_bPacked, bool a_bRetainCpuData,
+	Model* a_pPlaceholder) :
+	Asset(a_sPath), m_afLodRatios(a_afLodRatios), m_uAttributeMask(a_uAttributeMask), m_bPacked(a_bPacked), m_bRetainCpuData(a_bRetainCpuData), m_pModel(nullptr),
+	m_pResident(nullptr), m_pPlaceholder(a_pPlaceholder)
+{
+}
+
+// destructor
+ModelAsset::~ModelAsset()
+{
+	delete m_pModel;
+}
+
+Model* ModelAsset::Get() const
+{
+	Model* pResident = GetResident();
+	return pResident ? pResident : m_pPlaceholder;
+}
+
+/// <summary>
+/// Everything but the GL calls, the model is read (or its mesh cache is), simplified and its textures decoded
+/// </summary>
+bool ModelAsset::Load()
+{
+	m_pModel = new Model(GetPath(), false, m_afLodRatios, VertexLayout(m_uAttributeMask, m_bPacked), true, m_bRetainCpuData);
+	// assimp leaves a model it couldn't read without meshes
+	return !m_pModel->meshes.empty();
+}
+
+void ModelAsset::Upload()
+{
+	m_pModel->upload();
+	m_pResident.store(m_pModel, std::memory_order_release);
+}
+
+void ModelAsset::Unload()
+{
+	m_pResident.store(nullptr, std::memory_order_release);
+	if (m_pModel)
+	{
+		m_pModel->release();
+	}
+}
+
+size_t ModelAsset::CountCpuBytes() const
+{
+	return m_pModel ? m_pModel->getCpuBytes() : 0;
+}
+
+size_t ModelAsset::CountGpuBytes() const
+{
+	return m_pModel ? m_pModel->getGpuBytes() : 0;
+}
+
+size_t ModelAsset::CountUploadBytes() const
+{
+	return m_pModel ? m_pModel->getUploadBytes() : 0;
+}
+
+/// <summary>
+/// Only once it is resident, until then the copy in memory is what is waiting to be uploaded
+/// </summary>
+size_t ModelAsset::TrimCpuData()
+{
+	if (!IsResident() || !m_pModel->hasCpuData())
+	{
+		return 0;
+	}
+	size_t uBefore = m_pModel->getCpuBytes();
+	m_pModel->releaseCpuData();
+	return uBefore - m_pModel->getCpuBytes();
+}
+
+// constructor
+ShaderAsset::ShaderAsset(const std::string& a_sVertexPath, const std::string& a_sFragmentPath) : Asset(a_sVertexPath + " + " + a_sFragmentPath),
+	m_sVertexPath(a_sVertexPath), m_sFragmentPath(a_sFragmentPath), m_pShader(nullptr), m_pResident(nullptr)
+{
+}
+
+// destructor
+ShaderAsset::~ShaderAsset()
+{
+	delete m_pShader;
+}
+
+bool ShaderAsset::Load()
+{
+	return Shader::readSource(m_sVertexPath.c_str(), m_sVertexCode) && Shader::readSource(m_sFragmentPath.c_str(), m_sFragmentCode);
+}
+
+/// <summary>
+/// The source is only needed until it is compiled
+/// </summary>
+void ShaderAsset::Upload()
+{
+	m_pShader = Shader::fromSource(m_sVertexCode, m_sFragmentCode);
+	std::string().swap(m_sVertexCode);
+	std::string().swap(m_sFragmentCode);
+	m_pResident.store(m_pShader, std::memory_order_release);
+}
+
+void ShaderAsset::Unload()
+{
+	m_pResident.store(nullptr, std::memory_order_release);
+	if (m_pShader)
+	{
+		glDeleteProgram(m_pShader->ID);
+	}
+}
+
+/// <summary>
+/// Whether the context takes compressed textures is asked here, once, as the loader threads decode textures
+/// into whichever format it takes but can't ask it themselves
+/// </summary>
+AssetManager::AssetManager(size_t a_uMemoryBudget) : m_bShuttingDown(false), m_uMemoryBudget(a_uMemoryBudget), m_uMemoryUsed(0), m_bOverBudget(false)
+{
+	TextureCache::supportsCompression();
+	for (unsigned int i = 0; i < uLOADER_THREADS; i++)
+	{
+		m_axLoaders.push_back(std::thread(&AssetManager::LoaderLoop, this));
+	}
+}
+
+/// <summary>
+/// Loads the loaders have started are finished first. Anything released is freed, anything still held is
+/// left to its holder
+/// </summary>
+AssetManager::~AssetManager()
+{
+	{
+		std::lock_guard<std::mutex> xLock(m_xMutex);
+		m_bShuttingDown = true;
+	}
+	m_xQueuedCondition.notify_all();
+	for (std::thread& xLoader : m_axLoaders)
+	{
+		xLoader.join();
+	}
+
+	for (Asset* pAsset : m_apReleased)
+	{
+		pAsset->Unload();
+		delete pAsset;
+	}
+	std::map<std::tuple<unsigned int, bool, float>, Model*>::iterator xIter;
+	for (xIter = m_xPlaceholders.begin(); xIter != m_xPlaceholders.end(); xIter++)
+	{
+		xIter->second->release();
+		delete xIter->second;
+	}
+}
+
+ModelHandle AssetManager::LoadModel(const std::string& a_sPath, const std::vector<float>& a_afLodRatios, unsigned int a_uAttributeMask, bool a_bPacked,
+	float a_fPlaceholderRadius, bool a_bRetainCpuData)
+{
+	ModelHandle xModel = m_xModels[a_sPath].lock();
+	if (xModel)
+	{
+		return xModel; // already held
+	}
+
+	ModelAsset* pAsset = new ModelAsset(a_sPath, a_afLodRatios, a_uAttributeMask, a_bPacked, a_bRetainCpuData,
+		GetPlaceholder(a_uAttributeMask, a_bPacked, a_fPlaceholderRadius));
+	xModel = ModelHandle(pAsset, [this](ModelAsset* pReleased) { Release(pReleased); });
+	m_xModels[a_sPath] = xModel;
+	Queue(pAsset);
+	return xModel;
+}
+
+ShaderHandle AssetManager::LoadShader(const std::string& a_sVertexPath, const std::string& a_sFragmentPath)
+{
+	const std::string sKey = a_sVertexPath + " + " + a_sFragmentPath;
+	ShaderHandle xShader = m_xShaders[sKey].lock();
+	if (xShader)
+	{
+		return xShader; // already held
+	}
+
+	ShaderAsset* pAsset = new ShaderAsset(a_sVertexPath, a_sFragmentPath);
+	xShader = ShaderHandle(pAsset, [this](ShaderAsset* pReleased) { Release(pReleased); });
+	m_xShaders[sKey] = xShader;
+	Queue(pAsset);
+	return xShader;
+}
+
+void AssetManager::Queue(Asset* a_pAsset)
+{
+	a_pAsset->m_xRequested = Clock::now();
+	{
+		std::lock_guard<std::mutex> xLock(m_xMutex);
+		m_apQueued.push_back(a_pAsset);
+	}
+	m_xQueuedCondition.notify_one();
+}
+
+void AssetManager::Release(Asset* a_pAsset)
+{
+	a_pAsset->m_bReleased.store(true, std::memory_order_release);
+	std::lock_guard<std::mutex> xLock(m_xMutex);
+	m_apReleased.push_back(a_pAsset);
+}
+
+/// <summary>
+/// An asset released before a loader got to it is skipped rather than loaded for nothing
+/// </summary>
+void AssetManager::LoaderLoop()
+{
+	while (true)
+	{
+		Asset* pAsset = nullptr;
+		{
+			std::unique_lock<std::mutex> xLock(m_xMutex);
+			m_xQueuedCondition.wait(xLock, [this]() { return m_bShuttingDown || !m_apQueued.empty(); });
+			if (m_bShuttingDown)
+			{
+				return;
+			}
+			pAsset = m_apQueued.front();
+			m_apQueued.pop_front();
+			pAsset->m_eState.store(Asset::ASSET_LOADING, std::memory_order_release);
+		}
+
+		bool bReleased = pAsset->m_bReleased.load(std::memory_order_acquire);
+		bool bLoaded = !bReleased && pAsset->Load();
+		if (!bLoaded && !bReleased)
+		{
+			std::cout << "Failed to load " << pAsset->GetPath() << std::endl;
+		}
+
+		// measured here, as the context's thread doesn't read an asset that is loading
+		pAsset->m_uCpuBytes.store(pAsset->CountCpuBytes(), std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> xLock(m_xMutex);
+			pAsset->m_eState.store(bLoaded ? Asset::ASSET_LOADED : Asset::ASSET_FAILED, std::memory_order_release);
+			if (bLoaded)
+			{
+				m_apLoaded.push_back(pAsset);
+			}
+		}
+		m_xLoadedCondition.notify_all();
+	}
+}
+
+bool AssetManager::Finish(Asset* a_pAsset)
+{
+	if (a_pAsset->m_bReleased.load(std::memory_order_acquire))
+	{
+		a_pAsset->m_eState.store(Asset::ASSET_FAILED, std::memory_order_release);
+		return false;
+	}
+
+	Clock::time_point xStart = Clock::now();
+	a_pAsset->Upload();
+	a_pAsset->m_fLoadMs = std::chrono::duration<float, std::milli>(Clock::now() - a_pAsset->m_xRequested).count();
+	a_pAsset->m_eState.store(Asset::ASSET_RESIDENT, std::memory_order_release);
+	a_pAsset->m_uCpuBytes.store(a_pAsset->CountCpuBytes(), std::memory_order_relaxed);
+	a_pAsset->m_uGpuBytes.store(a_pAsset->CountGpuBytes(), std::memory_order_relaxed);
+	std::cout << "Asset " << a_pAsset->GetPath() << " uploaded in " << std::chrono::duration<float, std::milli>(Clock::now() - xStart).count()
+		<< " ms, resident " << a_pAsset->m_fLoadMs << " ms after it was asked for, " << a_pAsset->GetCpuBytes() / 1024 << " KB in memory, "
+		<< a_pAsset->GetGpuBytes() / 1024 << " KB on the GPU" << std::endl;
+	return true;
+}
+
+/// <summary>
+/// Uploads first, so an asset released while it waited to upload is freed this frame rather than the next.
+/// A released asset a loader is still reading is left until it has finished. An upload that would take the
+/// resident assets over budget trims what copies in memory it can first, and if that isn't enough it goes
+/// back to the front of the queue, holding up the rest, until it fits. What the loads hold in memory until
+/// then is counted in the total but not held against them, it is let go of as they are uploaded
+/// </summary>
+void AssetManager::Update(unsigned int a_uMaxUploads)
+{
+	size_t uResidentBytes = 0;
+	m_uMemoryUsed = MeasureMemory(uResidentBytes);
+	if (uResidentBytes > m_uMemoryBudget)
+	{
+		size_t uTrimmed = TrimCpuData(uResidentBytes - m_uMemoryBudget);
+		uResidentBytes -= uTrimmed;
+		m_uMemoryUsed -= uTrimmed;
+	}
+
+	m_bOverBudget = false;
+	unsigned int uUploads = 0;
+	while (uUploads < a_uMaxUploads)
+	{
+		Asset* pAsset = nullptr;
+		{
+			std::lock_guard<std::mutex> xLock(m_xMutex);
+			if (m_apLoaded.empty())
+			{
+				break;
+			}
+			pAsset = m_apLoaded.front();
+			m_apLoaded.pop_front();
+		}
+		// Wait may have uploaded it already
+		if (pAsset->GetState() != Asset::ASSET_LOADED)
+		{
+			continue;
+		}
+
+		size_t uUploadBytes = pAsset->CountUploadBytes();
+		if (uResidentBytes + uUploadBytes > m_uMemoryBudget && !pAsset->m_bReleased.load(std::memory_order_acquire))
+		{
+			size_t uTrimmed = TrimCpuData(uResidentBytes + uUploadBytes - m_uMemoryBudget);
+			uResidentBytes -= uTrimmed;
+			m_uMemoryUsed -= uTrimmed;
+			// one too big for the budget on its own still goes once there is nothing left for it to wait on
+			if (uResidentBytes + uUploadBytes > m_uMemoryBudget && uResidentBytes > 0)
+			{
+				std::lock_guard<std::mutex> xLock(m_xMutex);
+				m_apLoaded.push_front(pAsset);
+				m_bOverBudget = true;
+				break;
+			}
+		}
+
+		size_t uLoadedBytes = pAsset->GetCpuBytes();
+		if (Finish(pAsset))
+		{
+			size_t uBytes = pAsset->GetCpuBytes() + pAsset->GetGpuBytes();
+			uResidentBytes += uBytes;
+			m_uMemoryUsed += uBytes - uLoadedBytes;
+			uUploads++;
+		}
+	}
+
+	std::vector<Asset*> apFree;
+	{
+		std::lock_guard<std::mutex> xLock(m_xMutex);
+		std::vector<Asset*> apStillLoading;
+		for (Asset* pAsset : m_apReleased)
+		{
+			if (pAsset->GetState() == Asset::ASSET_LOADING)
+			{
+				apStillLoading.push_back(pAsset);
+				continue;
+			}
+			// nothing else can refer to it once it is out of the queues
+			m_apQueued.erase(std::remove(m_apQueued.begin(), m_apQueued.end(), pAsset), m_apQueued.end());
+			m_apLoaded.erase(std::remove(m_apLoaded.begin(), m_apLoaded.end(), pAsset), m_apLoaded.end());
+			apFree.push_back(pAsset);
+		}
+		m_apReleased.swap(apStillLoading);
+	}
+	for (Asset* pAsset : apFree)
+	{
+		pAsset->Unload();
+		delete pAsset;
+	}
+
+	// forget the paths nothing holds any more
+	std::map<std::string, std::weak_ptr<ModelAsset>>::iterator xModel = m_xModels.begin();
+	while (xModel != m_xModels.end())
+	{
+		xModel = xModel->second.expired() ? m_xModels.erase(xModel) : std::next(xModel);
+	}
+	std::map<std::string, std::weak_ptr<ShaderAsset>>::iterator xShader = m_xShaders.begin();
+	while (xShader != m_xShaders.end())
+	{
+		xShader = xShader->second.expired() ? m_xShaders.erase(xShader) : std::next(xShader);
+	}
+}
+
+/// <summary>
+/// Every asset is remeasured but those a loader has, which are left at what they last measured
+/// </summary>
+size_t AssetManager::MeasureMemory(size_t& a_uResidentBytes)
+{
+	std::vector<Asset*> apAssets;
+	std::map<std::string, std::weak_ptr<ShaderAsset>>::const_iterator xShader;
+	for (xShader = m_xShaders.begin(); xShader != m_xShaders.end(); xShader++)
+	{
+		ShaderHandle xHandle = xShader->second.lock();
+		if (xHandle)
+		{
+			apAssets.push_back(xHandle.get());
+		}
+	}
+	std::map<std::string, std::weak_ptr<ModelAsset>>::const_iterator xModel;
+	for (xModel = m_xModels.begin(); xModel != m_xModels.end(); xModel++)
+	{
+		ModelHandle xHandle = xModel->second.lock();
+		if (xHandle)
+		{
+			apAssets.push_back(xHandle.get());
+		}
+	}
+
+	size_t uBytes = 0;
+	std::lock_guard<std::mutex> xLock(m_xMutex);
+	for (Asset* pAsset : apAssets)
+	{
+		if (pAsset->GetState() != Asset::ASSET_LOADING && pAsset->GetState() != Asset::ASSET_QUEUED)
+		{
+			pAsset->m_uCpuBytes.store(pAsset->CountCpuBytes(), std::memory_order_relaxed);
+			pAsset->m_uGpuBytes.store(pAsset->CountGpuBytes(), std::memory_order_relaxed);
+		}
+		uBytes += pAsset->GetCpuBytes() + pAsset->GetGpuBytes();
+		if (pAsset->IsResident())
+		{
+			a_uResidentBytes += pAsset->GetCpuBytes() + pAsset->GetGpuBytes();
+		}
+	}
+	return uBytes;
+}
+
+/// <summary>
+/// Only models asked to keep their copy in memory have one left once resident, so those are what go
+/// </summary>
+size_t AssetManager::TrimCpuData(size_t a_uBytes)
+{
+	std::vector<ModelHandle> axModels;
+	std::map<std::string, std::weak_ptr<ModelAsset>>::const_iterator xModel;
+	for (xModel = m_xModels.begin(); xModel != m_xModels.end(); xModel++)
+	{
+		ModelHandle xHandle = xModel->second.lock();
+		if (xHandle && xHandle->IsResident())
+		{
+			axModels.push_back(xHandle);
+		}
+	}
+	std::sort(axModels.begin(), axModels.end(), [](const ModelHandle& a_xA, const ModelHandle& a_xB) { return a_xA->GetCpuBytes() > a_xB->GetCpuBytes(); });
+
+	size_t uFreed = 0;
+	for (unsigned int i = 0; i < axModels.size() && uFreed < a_uBytes; i++)
+	{
+		size_t uTrimmed = axModels[i]->TrimCpuData();
+		if (uTrimmed > 0)
+		{
+			axModels[i]->m_uCpuBytes.store(axModels[i]->CountCpuBytes(), std::memory_order_relaxed);
+			std::cout << "Over the asset memory budget, let go of " << uTrimmed / 1024 << " KB of " << axModels[i]->GetPath() << " in memory" << std::endl;
+			uFreed += uTrimmed;
+		}
+	}
+	return uFreed;
+}
+
+void AssetManager::Wait(Asset* a_pAsset)
+{
+	if (!a_pAsset)
+	{
+		return; // early out
+	}
+
+	{
+		std::unique_lock<std::mutex> xLock(m_xMutex);
+		m_xLoadedCondition.wait(xLock, [a_pAsset]() { return a_pAsset->GetState() >= Asset::ASSET_LOADED; });
+	}
+	if (a_pAsset->GetState() == Asset::ASSET_LOADED)
+	{
+		Finish(a_pAsset);
+	}
+}
+
+/// <summary>
+/// Shaders first then models, each in path order. The handle count leaves out the one made to look
+/// </summary>
+std::vector<AssetManager::AssetInfo> AssetManager::GetAssetInfo() const
+{
+	std::vector<AssetInfo> axInfo;
+	std::map<std::string, std::weak_ptr<ShaderAsset>>::const_iterator xShader;
+	for (xShader = m_xShaders.begin(); xShader != m_xShaders.end(); xShader++)
+	{
+		ShaderHandle xHandle = xShader->second.lock();
+		if (xHandle)
+		{
+			AssetInfo xInfo = { xHandle->GetPath(), xHandle->GetState(), xHandle.use_count() - 1, xHandle->GetLoadMs(), xHandle->GetCpuBytes(),
+				xHandle->GetGpuBytes() };
+			axInfo.push_back(xInfo);
+		}
+	}
+	std::map<std::string, std::weak_ptr<ModelAsset>>::const_iterator xModel;
+	for (xModel = m_xModels.begin(); xModel != m_xModels.end(); xModel++)
+	{
+		ModelHandle xHandle = xModel->second.lock();
+		if (xHandle)
+		{
+			AssetInfo xInfo = { xHandle->GetPath(), xHandle->GetState(), xHandle.use_count() - 1, xHandle->GetLoadMs(), xHandle->GetCpuBytes(),
+				xHandle->GetGpuBytes() };
+			axInfo.push_back(xInfo);
+		}
+	}
+	return axInfo;
+}
+
+unsigned int AssetManager::GetLoadingCount() const
+{
+	std::lock_guard<std::mutex> xLock(m_xMutex);
+	return static_cast<unsigned int>(m_apQueued.size() + m_apLoaded.size());
+}
+
+/// <summary>
+/// An octahedron with a_fRadius from the centre to each corner. The faces have vertices of their own so they
+/// shade flat, and it has no textures
+/// </summary>
+Model* AssetManager::GetPlaceholder(unsigned int a_uAttributeMask, bool a_bPacked, float a_fRadius)
+{
+	std::tuple<unsigned int, bool, float> xKey(a_uAttributeMask, a_bPacked, a_fRadius);
+	std::map<std::tuple<unsigned int, bool, float>, Model*>::const_iterator xFound = m_xPlaceholders.find(xKey);
+	if (xFound != m_xPlaceholders.end())
+	{
+		return xFound->second;
+	}
+
+	std::vector<Vertex> axVertices;
+	std::vector<unsigned int> auIndices;
+	for (int iX = -1; iX <= 1; iX += 2)
+	{
+		for (int iY = -1; iY <= 1; iY += 2)
+		{
+			for (int iZ = -1; iZ <= 1; iZ += 2)
+			{
+				// x, y, z turns anticlockwise seen from outside when the face's octant has an even number of
+				// negative axes, so the others go x, z, y
+				glm::vec3 av3Corners[3] = { glm::vec3((float)iX, 0.0f, 0.0f), glm::vec3(0.0f, (float)iY, 0.0f), glm::vec3(0.0f, 0.0f, (float)iZ) };
+				if (iX * iY * iZ < 0)
+				{
+					std::swap(av3Corners[1], av3Corners[2]);
+				}
+				glm::vec3 v3Normal = glm::normalize(glm::vec3((float)iX, (float)iY, (float)iZ));
+				glm::vec3 v3Tangent = glm::normalize(av3Corners[1] - av3Corners[0]);
+				for (const glm::vec3& v3Corner : av3Corners)
+				{
+					Vertex xVertex;
+					xVertex.Position = v3Corner * a_fRadius;
+					xVertex.Normal = v3Normal;
+					xVertex.TexCoords = glm::vec2(0.0f);
+					xVertex.Tangent = v3Tangent;
+					xVertex.Bitangent = glm::cross(v3Normal, v3Tangent);
+					auIndices.push_back(static_cast<unsigned int>(axVertices.size()));
+					axVertices.push_back(xVertex);
+				}
+			}
+		}
+	}
+
+	Model* pPlaceholder = new Model();
+	pPlaceholder->meshes.push_back(Mesh(axVertices, auIndices, std::vector<Texture>(), VertexLayout(a_uAttributeMask, a_bPacked)));
+	pPlaceholder->boundingRadius = a_fRadius;
+	pPlaceholder->releaseCpuData();
+	m_xPlaceholders[xKey] = pPlaceholder;
+	return pPlaceholder;
+}
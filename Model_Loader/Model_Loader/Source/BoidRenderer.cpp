@@ -0,0 +1,350 @@
+// This files header
+#include "BoidRenderer.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// LearnOpenGL includes
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+
+// Project Includes
+#include "BoidSnapshot.h"
+#include "ImpostorAtlas.h"
+#include "RenderQueue.h"
+#include "StreamingBuffer.h"
+#include "ThreadPool.h"
+
+// std includes
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+// typedefs
+typedef std::chrono::high_resolution_clock Clock;
+
+// constants
+static const unsigned int uINITIAL_INSTANCES = 1024;
+// matrices written by each thread pool task
+static const unsigned int uINSTANCE_GRAIN = 256;
+// the run of an instance that isn't drawn as a mesh, or as an impostor
+static const unsigned int uNO_RUN = 0xffffffff;
+// spheres tested by each thread pool task, a multiple of the four tested at once
+static const unsigned int uCULL_GRAIN = 1024;
+// the screen size each level of detail is used down to, the fish are too small to need more than three steps
+static const float afDEFAULT_LOD_SCREEN_SIZES[] = { 0.05f, 0.025f, 0.0125f };
+
+// constructor
+BoidRenderer::BoidRenderer() : m_pSnapshot(nullptr), m_bCulling(true), m_bParallelCulling(true), m_uVisibleCount(0), m_fCullMs(0.0f), m_bLodSelection(true),
+	m_afLodScreenSizes(std::begin(afDEFAULT_LOD_SCREEN_SIZES), std::end(afDEFAULT_LOD_SCREEN_SIZES)), m_fImpostorFadeStart(0.0f), m_fImpostorFadeEnd(0.0f), m_uImpostorCount(0),
+	m_pInstanceBuffer(nullptr), m_bRegionOpen(false), m_uDrawCallCount(0)
+{
+	m_pInstanceBuffer = new StreamingBuffer(uINITIAL_INSTANCES * sizeof(glm::mat4));
+}
+
+// destructor
+BoidRenderer::~BoidRenderer()
+{
+	delete m_pInstanceBuffer;
+}
+
+void BoidRenderer::SetImpostor(const Model* a_pModel, ImpostorAtlas* a_pAtlas)
+{
+	if (a_pAtlas && a_pAtlas->IsValid())
+	{
+		m_xImpostors[a_pModel] = a_pAtlas;
+	}
+	else
+	{
+		m_xImpostors.erase(a_pModel);
+	}
+}
+
+/// <summary>
+/// Lays the snapshot's boids out so every model's instances sit next to each other
+/// </summary>
+void BoidRenderer::Gather(const BoidSnapshot& a_xSnapshot)
+{
+	m_pSnapshot = &a_xSnapshot;
+	m_axBatches.clear();
+	m_auInstances.clear();
+
+	// first pass counts the instances of each model
+	const unsigned int uBoidCount = a_xSnapshot.GetBoidCount();
+	for (unsigned int i = 0; i < uBoidCount; i++)
+	{
+		Model* pModel = a_xSnapshot.apModels[i];
+		if (!pModel)
+		{
+			continue;
+		}
+
+		// there are only ever a handful of models so a linear search is fine
+		unsigned int uBatch = 0;
+		while (uBatch < m_axBatches.size() && m_axBatches[uBatch].pModel != pModel)
+		{
+			uBatch++;
+		}
+		if (uBatch == m_axBatches.size())
+		{
+			std::map<const Model*, ImpostorAtlas*>::const_iterator xImpostor = m_xImpostors.find(pModel);
+			ModelBatch xBatch = { pModel, xImpostor != m_xImpostors.end() ? xImpostor->second : nullptr, 0, 0, 0 };
+			m_axBatches.push_back(xBatch);
+		}
+		m_axBatches[uBatch].uInstanceCount++;
+	}
+
+	// give each model its range of the instance buffer
+	unsigned int uTotal = 0;
+	for (ModelBatch& xBatch : m_axBatches)
+	{
+		xBatch.uFirstInstance = uTotal;
+		uTotal += xBatch.uInstanceCount;
+		xBatch.uInstanceCount = 0;
+	}
+	m_auInstances.resize(uTotal);
+
+	// second pass fills the ranges in
+	for (unsigned int i = 0; i < uBoidCount; i++)
+	{
+		for (ModelBatch& xBatch : m_axBatches)
+		{
+			if (xBatch.pModel == a_xSnapshot.apModels[i])
+			{
+				m_auInstances[xBatch.uFirstInstance + xBatch.uInstanceCount++] = i;
+				break;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Works out every gathered bounding sphere and level of detail across the thread pool, culls the spheres
+/// against the camera, then packs the visible matrices into this frames region of the instance buffer grouped
+/// into runs by model and level, so each model is queued once per level with only its visible instances. Models
+/// with an impostor get one more run for the instances past the start of the fade. The pool counts what each of
+/// its chunks puts in each run, the counts are summed into where each chunk writes, and the pool then copies
+/// the matrices straight into the mapping, in the same order as a single thread would
+/// </summary>
+void BoidRenderer::Submit(Shader* a_pShader, RenderQueue& a_xQueue, const glm::mat4& a_m4View, const glm::mat4& a_m4Projection)
+{
+	m_uDrawCallCount = 0;
+	m_uVisibleCount = 0;
+	m_uImpostorCount = 0;
+	m_fCullMs = 0.0f;
+	std::fill(m_auLodCounts.begin(), m_auLodCounts.end(), 0u);
+	if (!a_pShader || !m_pSnapshot || m_auInstances.empty())
+	{
+		return; // early out
+	}
+
+	unsigned int uInstanceCount = static_cast<unsigned int>(m_auInstances.size());
+	m_afSphereX.resize(uInstanceCount);
+	m_afSphereY.resize(uInstanceCount);
+	m_afSphereZ.resize(uInstanceCount);
+	m_afSphereRadius.resize(uInstanceCount);
+	m_abVisible.resize(uInstanceCount);
+	m_abLods.resize(uInstanceCount);
+	m_afDistances.resize(uInstanceCount);
+	m_auMeshRuns.resize(uInstanceCount);
+	m_auImpostorRuns.resize(uInstanceCount);
+
+	const glm::mat4 m4ProjectionView = a_m4Projection * a_m4View;
+	// how far up the screen a unit high object one unit in front of the camera reaches
+	const float fProjectedScale = a_m4Projection[1][1];
+	const glm::vec3 v3CameraPosition(glm::inverse(a_m4View)[3]);
+
+	ThreadPool* pThreadPool = ThreadPool::GetInstance();
+	pThreadPool->ParallelFor(uInstanceCount, uINSTANCE_GRAIN, [this, &m4ProjectionView, fProjectedScale, &v3CameraPosition](unsigned int a_uBegin, unsigned int a_uEnd)
+	{
+		for (unsigned int i = a_uBegin; i < a_uEnd; i++)
+		{
+			const unsigned int uBoid = m_auInstances[i];
+			const glm::mat4& m4ModelMatrix = m_pSnapshot->am4Models[uBoid];
+
+			// the sphere sits on the models origin and grows with the largest scale in the matrix
+			float fScale = std::max(glm::length(glm::vec3(m4ModelMatrix[0])), std::max(glm::length(glm::vec3(m4ModelMatrix[1])), glm::length(glm::vec3(m4ModelMatrix[2]))));
+			m_afSphereX[i] = m4ModelMatrix[3].x;
+			m_afSphereY[i] = m4ModelMatrix[3].y;
+			m_afSphereZ[i] = m4ModelMatrix[3].z;
+			m_afSphereRadius[i] = m_pSnapshot->apModels[uBoid]->boundingRadius * fScale;
+			m_afDistances[i] = glm::length(glm::vec3(m4ModelMatrix[3]) - v3CameraPosition);
+
+			// the sphere covers about radius * scale / depth of the screen height, the clip w being the depth
+			unsigned int uLod = 0;
+			float fDepth = m4ProjectionView[0][3] * m_afSphereX[i] + m4ProjectionView[1][3] * m_afSphereY[i] + m4ProjectionView[2][3] * m_afSphereZ[i] + m4ProjectionView[3][3];
+			if (m_bLodSelection && fDepth > m_afSphereRadius[i])
+			{
+				float fScreenSize = m_afSphereRadius[i] * fProjectedScale / fDepth;
+				unsigned int uLastLod = m_pSnapshot->apModels[uBoid]->getLodCount() - 1;
+				while (uLod < uLastLod && uLod < m_afLodScreenSizes.size() && fScreenSize < m_afLodScreenSizes[uLod])
+				{
+					uLod++;
+				}
+			}
+			m_abLods[i] = static_cast<unsigned char>(uLod);
+		}
+	});
+
+	Clock::time_point xCullStart = Clock::now();
+	if (m_bCulling)
+	{
+		m_xCuller.SetFrustum(m4ProjectionView);
+		if (m_bParallelCulling)
+		{
+			pThreadPool->ParallelFor(uInstanceCount, uCULL_GRAIN, [this](unsigned int a_uBegin, unsigned int a_uEnd)
+			{
+				m_xCuller.TestSpheres(m_afSphereX.data(), m_afSphereY.data(), m_afSphereZ.data(), m_afSphereRadius.data(), a_uBegin, a_uEnd, m_abVisible.data());
+			});
+		}
+		else
+		{
+			m_xCuller.TestSpheres(m_afSphereX.data(), m_afSphereY.data(), m_afSphereZ.data(), m_afSphereRadius.data(), 0, uInstanceCount, m_abVisible.data());
+		}
+	}
+	else
+	{
+		std::fill(m_abVisible.begin(), m_abVisible.end(), static_cast<unsigned char>(1));
+	}
+
+	for (unsigned char bVisible : m_abVisible)
+	{
+		m_uVisibleCount += bVisible;
+	}
+	m_fCullMs = std::chrono::duration<float, std::milli>(Clock::now() - xCullStart).count();
+
+	// every batch has a run per level, and one more for its impostors
+	const bool bImpostors = m_fImpostorFadeEnd > m_fImpostorFadeStart;
+	unsigned int uRunCount = 0;
+	for (ModelBatch& xBatch : m_axBatches)
+	{
+		unsigned int uLodCount = xBatch.pModel->getLodCount();
+		if (m_auLodCounts.size() < uLodCount)
+		{
+			m_auLodCounts.resize(uLodCount, 0);
+		}
+		xBatch.uFirstRun = uRunCount;
+		uRunCount += uLodCount + 1;
+	}
+	const unsigned int uChunkCount = (uInstanceCount + uINSTANCE_GRAIN - 1) / uINSTANCE_GRAIN;
+	m_auChunkRuns.assign(static_cast<size_t>(uChunkCount) * uRunCount, 0);
+	m_auRunStarts.resize(uRunCount);
+	m_auRunCounts.resize(uRunCount);
+
+	// an instance in the fade band is written twice, once for its mesh and once for its impostor. past the band
+	// only the impostor is drawn
+	pThreadPool->ParallelFor(uInstanceCount, uINSTANCE_GRAIN, [this, bImpostors, uRunCount](unsigned int a_uBegin, unsigned int a_uEnd)
+	{
+		unsigned int* puCounts = &m_auChunkRuns[static_cast<size_t>(a_uBegin / uINSTANCE_GRAIN) * uRunCount];
+		unsigned int uBatch = 0;
+		for (unsigned int i = a_uBegin; i < a_uEnd; i++)
+		{
+			while (i >= m_axBatches[uBatch].uFirstInstance + m_axBatches[uBatch].uInstanceCount)
+			{
+				uBatch++;
+			}
+			const ModelBatch& xBatch = m_axBatches[uBatch];
+			const bool bBatchImpostors = bImpostors && xBatch.pImpostor;
+
+			m_auMeshRuns[i] = uNO_RUN;
+			m_auImpostorRuns[i] = uNO_RUN;
+			if (!m_abVisible[i])
+			{
+				continue;
+			}
+			if (!bBatchImpostors || m_afDistances[i] < m_fImpostorFadeEnd)
+			{
+				m_auMeshRuns[i] = xBatch.uFirstRun + m_abLods[i];
+				puCounts[m_auMeshRuns[i]]++;
+			}
+			if (bBatchImpostors && m_afDistances[i] > m_fImpostorFadeStart)
+			{
+				m_auImpostorRuns[i] = xBatch.uFirstRun + xBatch.pModel->getLodCount();
+				puCounts[m_auImpostorRuns[i]]++;
+			}
+		}
+	});
+
+	// each run takes the chunks in order, so each chunk's counts become where it starts writing in each run
+	unsigned int uWriteCount = 0;
+	for (unsigned int uRun = 0; uRun < uRunCount; uRun++)
+	{
+		m_auRunStarts[uRun] = uWriteCount;
+		for (unsigned int uChunk = 0; uChunk < uChunkCount; uChunk++)
+		{
+			unsigned int& uChunkRun = m_auChunkRuns[static_cast<size_t>(uChunk) * uRunCount + uRun];
+			unsigned int uCount = uChunkRun;
+			uChunkRun = uWriteCount;
+			uWriteCount += uCount;
+		}
+		m_auRunCounts[uRun] = uWriteCount - m_auRunStarts[uRun];
+	}
+	if (uWriteCount == 0)
+	{
+		return; // nothing to draw
+	}
+
+	glm::mat4* pm4Instances = static_cast<glm::mat4*>(m_pInstanceBuffer->BeginRegion(uWriteCount * sizeof(glm::mat4)));
+	if (!pm4Instances)
+	{
+		return; // early out
+	}
+	m_bRegionOpen = true;
+
+	// every chunk writes its own slots of each run, so the workers copy into the mapping without sharing any
+	pThreadPool->ParallelFor(uInstanceCount, uINSTANCE_GRAIN, [this, pm4Instances, uRunCount](unsigned int a_uBegin, unsigned int a_uEnd)
+	{
+		unsigned int* puNext = &m_auChunkRuns[static_cast<size_t>(a_uBegin / uINSTANCE_GRAIN) * uRunCount];
+		for (unsigned int i = a_uBegin; i < a_uEnd; i++)
+		{
+			const glm::mat4& m4ModelMatrix = m_pSnapshot->am4Models[m_auInstances[i]];
+			if (m_auMeshRuns[i] != uNO_RUN)
+			{
+				pm4Instances[puNext[m_auMeshRuns[i]]++] = m4ModelMatrix;
+			}
+			if (m_auImpostorRuns[i] != uNO_RUN)
+			{
+				pm4Instances[puNext[m_auImpostorRuns[i]]++] = m4ModelMatrix;
+			}
+		}
+	});
+
+	// the region is addressed by instance, so its offset becomes part of the base instance
+	unsigned int uRegionBase = static_cast<unsigned int>(m_pInstanceBuffer->GetRegionOffset() / sizeof(glm::mat4));
+	for (const ModelBatch& xBatch : m_axBatches)
+	{
+		unsigned int uLodCount = xBatch.pModel->getLodCount();
+		for (unsigned int uLod = 0; uLod < uLodCount; uLod++)
+		{
+			unsigned int uRun = xBatch.uFirstRun + uLod;
+			if (m_auRunCounts[uRun] == 0)
+			{
+				continue;
+			}
+			m_auLodCounts[uLod] += m_auRunCounts[uRun];
+			for (Mesh& xMesh : xBatch.pModel->meshes)
+			{
+				a_xQueue.SubmitInstanced(a_pShader, &xMesh, m_pInstanceBuffer->GetBuffer(), m_auRunCounts[uRun], uRegionBase + m_auRunStarts[uRun], uLod);
+				m_uDrawCallCount++;
+			}
+		}
+
+		unsigned int uImpostorRun = xBatch.uFirstRun + uLodCount;
+		if (m_auRunCounts[uImpostorRun] > 0)
+		{
+			m_uImpostorCount += m_auRunCounts[uImpostorRun];
+			a_xQueue.SubmitInstanced(xBatch.pImpostor->GetShader(), xBatch.pImpostor->GetQuad(), m_pInstanceBuffer->GetBuffer(), m_auRunCounts[uImpostorRun],
+				uRegionBase + m_auRunStarts[uImpostorRun]);
+			m_uDrawCallCount++;
+		}
+	}
+}
+
+void BoidRenderer::EndFrame()
+{
+	if (m_bRegionOpen)
+	{
+		m_pInstanceBuffer->EndRegion();
+		m_bRegionOpen = false;
+	}
+}
@@ -0,0 +1,191 @@
+// This files header
+#include "BoidSystems.h"
+
+// Project Includes
+#include "Entity.h"
+#include "BrainComponent.h"
+#include "TransformComponent.h"
+#include "Gizmos.h"
+
+// std includes
+#include <unordered_map>
+
+// typedefs
+typedef System PARENT;
+
+BoidForceSystem::BoidForceSystem() : PARENT("Boid Forces"), m_iGroupNum(1), m_iSizeOfGroup(1)
+{
+	Reads(TRANSFORM);
+	Reads(BRAIN);
+	Writes(BRAIN);
+}
+
+/// <summary>
+/// Entities are processed in groups so that they are not all processed at once
+/// this makes it less intensive on processing so performs faster
+/// </summary>
+void BoidForceSystem::Update(float a_fDeltaTime, float /*a_fBoundingBoxSize*/)
+{
+	// groups go by position in the list rather than id, as ids aren't reused once boids are removed
+	int iIndex = 0;
+	std::map<const unsigned int, Entity*>::const_iterator xIter;
+	for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++, iIndex++)
+	{
+		Entity* pEntity = xIter->second;
+		if (pEntity)
+		{
+			// the groups are numbered from 1
+			if (InForceGroup(static_cast<unsigned int>(iIndex), static_cast<unsigned int>(m_iGroupNum - 1), static_cast<unsigned int>(m_iSizeOfGroup)))
+			{
+				BrainComponent* pBrainComp = static_cast<BrainComponent*>(pEntity->FindComponentOfType(BRAIN));
+				if (pBrainComp)
+				{
+					pBrainComp->UpdateForces(a_fDeltaTime);
+				}
+			}
+		}
+	}
+}
+
+BoidMovementSystem::BoidMovementSystem() : PARENT("Boid Movement")
+{
+	Reads(BRAIN);
+	Writes(BRAIN);
+	Writes(TRANSFORM);
+}
+
+/// <summary>
+/// other update functions are called for all of the boids each frame rather than just the groups
+/// </summary>
+void BoidMovementSystem::Update(float a_fDeltaTime, float a_fBoundingBoxSize)
+{
+	std::map<const unsigned int, Entity*>::const_iterator xIter;
+	for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++)
+	{
+		Entity* pEntity = xIter->second;
+		if (pEntity)
+		{
+			pEntity->Update(a_fDeltaTime, a_fBoundingBoxSize);
+		}
+	}
+}
+
+SceneGizmoSystem::SceneGizmoSystem() : PARENT("Scene Gizmos"), m_v3BoxPos(0.0f), m_uLayer(0), m_bLayerBuilt(false),
+	m_v3BuiltBoxPos(0.0f), m_fBuiltBoundingBoxSize(0.0f)
+{
+	Writes(RESOURCE_GIZMOS);
+}
+
+/// <summary>
+/// The immediate gizmos are cleared for the frame, the boxes are only rebuilt (and uploaded again) after they move
+/// </summary>
+void SceneGizmoSystem::Update(float /*a_fDeltaTime*/, float a_fBoundingBoxSize)
+{
+	Gizmos::clear();
+
+	if (m_bLayerBuilt && m_v3BuiltBoxPos == m_v3BoxPos && m_fBuiltBoundingBoxSize == a_fBoundingBoxSize)
+	{
+		return; // early out
+	}
+	if (!m_bLayerBuilt)
+	{
+		m_uLayer = Gizmos::createLayer(true);
+		m_bLayerBuilt = true;
+	}
+	m_v3BuiltBoxPos = m_v3BoxPos;
+	m_fBuiltBoundingBoxSize = a_fBoundingBoxSize;
+
+	Gizmos::clearLayer(m_uLayer);
+	Gizmos::setLayer(m_uLayer);
+	// create the bounding box
+	Gizmos::addBox(glm::vec3(0), glm::vec3(a_fBoundingBoxSize), false, glm::vec4(1, 0, 0, 1));
+	// create the box that the boids avoid
+	Gizmos::addBox(m_v3BoxPos, glm::vec3(0.25f), true, glm::vec4(1, 0, 0, 1));
+	Gizmos::setLayer(0);
+}
+
+PlanarFlockSystem::PlanarFlockSystem() : PARENT("Planar Flock")
+{
+	Reads(TRANSFORM);
+	Writes(TRANSFORM);
+}
+
+void PlanarFlockSystem::Update(float a_fDeltaTime, float a_fBoundingBoxSize)
+{
+	SyncEntities();
+
+	m_xSettings.fBoundsSize = a_fBoundingBoxSize;
+	m_xFlock.Step(a_fDeltaTime, m_xSettings);
+
+	// lift the flock back into the world so the models draw where the boids are
+	const glm::vec3 v3Up(0.0f, 1.0f, 0.0f);
+	for (unsigned int i = 0; i < m_auEntityIDs.size(); i++)
+	{
+		Entity* pEntity = Entity::FindEntity(m_auEntityIDs[i]);
+		TransformComponent* pTransComp = pEntity ? static_cast<TransformComponent*>(pEntity->FindComponentOfType(TRANSFORM)) : nullptr;
+		if (!pTransComp)
+		{
+			continue;
+		}
+
+		glm::vec3 v3Forward = LiftToWorld(m_xFlock.GetForward(i));
+		if (glm::length(v3Forward) > 0.0f)
+		{
+			pTransComp->SetEntityMatrixRow(RIGHT_VECTOR, glm::normalize(glm::cross(v3Up, v3Forward)));
+			pTransComp->SetEntityMatrixRow(FORWARD_VECTOR, v3Forward);
+			pTransComp->SetEntityMatrixRow(UP_VECTOR, v3Up);
+		}
+		pTransComp->SetEntityMatrixRow(POSITION_VECTOR, LiftToWorld(m_xFlock.GetPosition(i)));
+	}
+}
+
+/// <summary>
+/// Boids that are new to the flock start from where their transform has them, flattened onto the plane
+/// </summary>
+void PlanarFlockSystem::SyncEntities()
+{
+	const std::map<const unsigned int, Entity*>& xEntityMap = Entity::GetEntityList();
+
+	// nothing to do if the same boids are still here in the same order
+	bool bChanged = xEntityMap.size() != m_auEntityIDs.size();
+	std::map<const unsigned int, Entity*>::const_iterator xIter = xEntityMap.begin();
+	for (unsigned int i = 0; !bChanged && xIter != xEntityMap.end(); xIter++, i++)
+	{
+		bChanged = xIter->first != m_auEntityIDs[i];
+	}
+	if (!bChanged)
+	{
+		return; // early out
+	}
+
+	// remember where the boids that are staying were
+	std::unordered_map<unsigned int, unsigned int> xOldIndices;
+	for (unsigned int i = 0; i < m_auEntityIDs.size(); i++)
+	{
+		xOldIndices[m_auEntityIDs[i]] = i;
+	}
+	FlockCore2f xOldFlock = m_xFlock;
+
+	m_auEntityIDs.clear();
+	m_xFlock.Resize(static_cast<unsigned int>(xEntityMap.size()));
+	for (xIter = xEntityMap.begin(); xIter != xEntityMap.end(); xIter++)
+	{
+		unsigned int uIndex = static_cast<unsigned int>(m_auEntityIDs.size());
+		m_auEntityIDs.push_back(xIter->first);
+
+		std::unordered_map<unsigned int, unsigned int>::const_iterator xOld = xOldIndices.find(xIter->first);
+		if (xOld != xOldIndices.end())
+		{
+			m_xFlock.SetBoid(uIndex, xOldFlock.GetPosition(xOld->second), xOldFlock.GetVelocity(xOld->second));
+			continue;
+		}
+
+		glm::vec3 v3Position(0.0f);
+		TransformComponent* pTransComp = xIter->second ? static_cast<TransformComponent*>(xIter->second->FindComponentOfType(TRANSFORM)) : nullptr;
+		if (pTransComp)
+		{
+			v3Position = pTransComp->GetEntityMatrixRow(POSITION_VECTOR);
+		}
+		m_xFlock.SetBoid(uIndex, glm::vec2(v3Position.x, v3Position.z), glm::vec2(0.0f));
+	}
+}
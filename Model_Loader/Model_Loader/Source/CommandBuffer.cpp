@@ -0,0 +1,112 @@
+// This files header
+#include "CommandBuffer.h"
+
+// Project Includes
+#include "Entity.h"
+#include "ThreadPool.h"
+
+// std includes
+#include <algorithm>
+
+// constructor
+CommandBuffer::CommandBuffer()
+{
+
+}
+
+/// <summary>
+/// Records the creation of an entity, the builder is called on it when the buffer is flushed
+/// </summary>
+void CommandBuffer::Spawn(EntityBuilder a_xBuilder)
+{
+	m_axCommands.push_back({ SPAWN, ThreadPool::GetTaskTag(), 0, std::move(a_xBuilder), nullptr });
+}
+
+/// <summary>
+/// Records the removal of an entity, despawning an entity that is already gone does nothing
+/// </summary>
+void CommandBuffer::Despawn(unsigned int a_uEntityID)
+{
+	m_axCommands.push_back({ DESPAWN, ThreadPool::GetTaskTag(), a_uEntityID, nullptr, nullptr });
+}
+
+/// <summary>
+/// Records adding a component to an entity, skipped if the entity is gone by the time of the flush
+/// </summary>
+void CommandBuffer::AddComponent(unsigned int a_uEntityID, ComponentFactory a_xFactory)
+{
+	m_axCommands.push_back({ ADD_COMPONENT, ThreadPool::GetTaskTag(), a_uEntityID, nullptr, std::move(a_xFactory) });
+}
+
+// constructor
+CommandQueue::CommandQueue(unsigned int a_uThreadCount) : m_axBuffers(a_uThreadCount > 0 ? a_uThreadCount : 1)
+{
+
+}
+
+/// <summary>
+/// Threads are indexed by the thread pool, a thread outside the pool gets the first buffer unless it claimed
+/// an index of its own
+/// </summary>
+CommandBuffer& CommandQueue::GetThreadBuffer()
+{
+	unsigned int uThreadIndex = ThreadPool::GetThreadIndex();
+	return m_axBuffers[uThreadIndex < m_axBuffers.size() ? uThreadIndex : 0];
+}
+
+/// <summary>
+/// Applies the recorded commands ordered by key, then thread, then the order they were recorded in
+/// </summary>
+void CommandQueue::Flush()
+{
+	std::vector<CommandBuffer::Command*> apCommands;
+	for (CommandBuffer& xBuffer : m_axBuffers)
+	{
+		for (CommandBuffer::Command& xCommand : xBuffer.m_axCommands)
+		{
+			apCommands.push_back(&xCommand);
+		}
+	}
+
+	if (apCommands.empty())
+	{
+		return; // early out
+	}
+
+	// stable so that commands with the same key stay in thread then recording order
+	std::stable_sort(apCommands.begin(), apCommands.end(),
+		[](const CommandBuffer::Command* pA, const CommandBuffer::Command* pB) { return pA->uKey < pB->uKey; });
+
+	for (CommandBuffer::Command* pCommand : apCommands)
+	{
+		switch (pCommand->eType)
+		{
+		case CommandBuffer::SPAWN:
+		{
+			Entity* pEntity = new Entity();
+			if (pCommand->xBuilder)
+			{
+				pCommand->xBuilder(pEntity);
+			}
+			break;
+		}
+		case CommandBuffer::DESPAWN:
+			Entity::DestroyEntity(pCommand->uEntityID);
+			break;
+		case CommandBuffer::ADD_COMPONENT:
+		{
+			Entity* pEntity = Entity::FindEntity(pCommand->uEntityID);
+			if (pEntity && pCommand->xFactory)
+			{
+				pEntity->AddComponent(pCommand->xFactory(pEntity));
+			}
+			break;
+		}
+		}
+	}
+
+	for (CommandBuffer& xBuffer : m_axBuffers)
+	{
+		xBuffer.m_axCommands.clear();
+	}
+}
@@ -5,17 +5,45 @@ typedef std::pair<const unsigned int, Entity*> EntityPair;
 
 // Statics
 unsigned int Entity::s_uEntityCount = 0;
+unsigned int Entity::s_uNextEntityID = 0;
 std::map<const unsigned int, Entity*> Entity::s_xEntityList;
 
 Entity::Entity()
 {
 	// Increment Entity ID
-	m_uEntityID = s_uEntityCount++;
+	m_uEntityID = s_uNextEntityID++;
+	s_uEntityCount++;
 
 	// Add this entity to the list
 	s_xEntityList.insert(EntityPair(m_uEntityID, this));
 }
 
+/// <summary>
+/// looks up an entity by its id
+/// </summary>
+Entity* Entity::FindEntity(unsigned int a_uEntityID)
+{
+	std::map<const unsigned int, Entity*>::const_iterator xIter = s_xEntityList.find(a_uEntityID);
+	return xIter != s_xEntityList.end() ? xIter->second : nullptr;
+}
+
+/// <summary>
+/// removes an entity from the list and clears it from memory
+/// </summary>
+/// <param name="a_uEntityID"> id of the entity to destroy </param>
+void Entity::DestroyEntity(unsigned int a_uEntityID)
+{
+	std::map<const unsigned int, Entity*>::const_iterator xIter = s_xEntityList.find(a_uEntityID);
+	if (xIter == s_xEntityList.end())
+	{
+		return; // already gone
+	}
+
+	Entity* pEntity = xIter->second;
+	RemoveEntity(xIter);
+	delete pEntity;
+}
+
 /// <summary>
 /// function called each frame
 /// </summary>
@@ -0,0 +1,246 @@
+// This files header
+#include "FlockDebugDraw.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// LearnOpenGL includes
+#include <learnopengl/shader.h>
+
+// Project Includes
+#include "BoidBehaviours.h"
+#include "BoidSnapshot.h"
+#include "FrameUniforms.h"
+#include "GpuFlock.h"
+#include "StreamingBuffer.h"
+
+// third party include
+#include <glm/gtc/constants.hpp>
+
+// std includes
+#include <cmath>
+#include <vector>
+
+// constants
+static const UniformName xCOLOUR_UNIFORM("debugColour");
+static const UniformName xSCALE_UNIFORM("debugScale");
+static const UniformName xRADIUS_UNIFORM("debugRadius");
+static const unsigned int uINITIAL_BOIDS = 1024;
+// the vertex buffer bindings, the unit meshes and then the two per instance vectors
+static const unsigned int uMESH_BINDING = 0;
+static const unsigned int uORIGIN_BINDING = 1;
+static const unsigned int uVECTOR_BINDING = 2;
+// segments in each of the circles the sphere is drawn with
+static const unsigned int uSPHERE_SEGMENTS = 24;
+// the per instance streams written for the snapshot's boids, a vec4 per boid each
+static const unsigned int uSTREAM_POSITION = 0;
+static const unsigned int uSTREAM_VELOCITY = 1;
+static const unsigned int uSTREAM_FIRST_FORCE = 2;
+static const unsigned int uSTREAM_COUNT = uSTREAM_FIRST_FORCE + BEHAVIOUR_COUNT;
+
+static const glm::vec4 v4VELOCITY_COLOUR(1.0f, 1.0f, 0.0f, 1.0f);
+static const glm::vec4 v4NEIGHBOURHOOD_COLOUR(0.3f, 0.3f, 0.3f, 1.0f);
+// in BEHAVIOUR_SLOT order
+static const glm::vec4 av4FORCE_COLOURS[BEHAVIOUR_COUNT] = { glm::vec4(0.8f, 0.0f, 0.8f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+	glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), glm::vec4(0.0f, 0.4f, 1.0f, 1.0f) };
+// the GPU flock only keeps the total
+static const glm::vec4 v4TOTAL_FORCE_COLOUR(1.0f, 0.5f, 0.0f, 1.0f);
+
+// constructor
+FlockDebugDraw::FlockDebugDraw() : m_pShader(nullptr), m_uVAO(0), m_uVBO(0), m_pInstanceBuffer(nullptr), m_bRegionOpen(false),
+	m_fNeighbourhoodRadius(5.0f), m_fVelocityScale(25.0f), m_fForceScale(0.5f), m_uBoidCount(0), m_uDrawCallCount(0)
+{
+	m_pShader = new Shader("shaders/flock_debug.vs", "shaders/flock_debug.fs");
+	m_pShader->bindUniformBlock(szFRAME_UNIFORMS_BLOCK, uFRAME_UNIFORMS_BINDING);
+	m_pInstanceBuffer = new StreamingBuffer(uINITIAL_BOIDS * uSTREAM_COUNT * sizeof(glm::vec4));
+	CreateMeshes();
+}
+
+// destructor
+FlockDebugDraw::~FlockDebugDraw()
+{
+	delete m_pInstanceBuffer;
+	glDeleteBuffers(1, &m_uVBO);
+	glDeleteVertexArrays(1, &m_uVAO);
+	glDeleteProgram(m_pShader->ID);
+	delete m_pShader;
+}
+
+/// <summary>
+/// The line and arrow run from the origin to one along z, the sphere is three circles of radius one. The vertex
+/// array reads the meshes at a fixed binding, and the two per instance vectors from bindings that are pointed at
+/// whichever buffer each draw reads
+/// </summary>
+void FlockDebugDraw::CreateMeshes()
+{
+	std::vector<glm::vec3> av3Vertices;
+
+	m_axPrimitives[PRIMITIVE_LINE].uFirst = static_cast<unsigned int>(av3Vertices.size());
+	av3Vertices.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+	av3Vertices.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+	m_axPrimitives[PRIMITIVE_LINE].uCount = static_cast<unsigned int>(av3Vertices.size()) - m_axPrimitives[PRIMITIVE_LINE].uFirst;
+
+	m_axPrimitives[PRIMITIVE_SPHERE].uFirst = static_cast<unsigned int>(av3Vertices.size());
+	const float fSegmentAngle = glm::two_pi<float>() / uSPHERE_SEGMENTS;
+	for (unsigned int i = 0; i < uSPHERE_SEGMENTS; i++)
+	{
+		glm::vec2 v2Start(std::sin(i * fSegmentAngle), std::cos(i * fSegmentAngle));
+		glm::vec2 v2End(std::sin((i + 1) * fSegmentAngle), std::cos((i + 1) * fSegmentAngle));
+		// one circle around each axis
+		av3Vertices.push_back(glm::vec3(v2Start.x, v2Start.y, 0.0f));
+		av3Vertices.push_back(glm::vec3(v2End.x, v2End.y, 0.0f));
+		av3Vertices.push_back(glm::vec3(v2Start.x, 0.0f, v2Start.y));
+		av3Vertices.push_back(glm::vec3(v2End.x, 0.0f, v2End.y));
+		av3Vertices.push_back(glm::vec3(0.0f, v2Start.x, v2Start.y));
+		av3Vertices.push_back(glm::vec3(0.0f, v2End.x, v2End.y));
+	}
+	m_axPrimitives[PRIMITIVE_SPHERE].uCount = static_cast<unsigned int>(av3Vertices.size()) - m_axPrimitives[PRIMITIVE_SPHERE].uFirst;
+
+	m_axPrimitives[PRIMITIVE_ARROW].uFirst = static_cast<unsigned int>(av3Vertices.size());
+	av3Vertices.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+	av3Vertices.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+	const glm::vec3 av3Barbs[] = { glm::vec3(0.1f, 0.0f, 0.8f), glm::vec3(-0.1f, 0.0f, 0.8f), glm::vec3(0.0f, 0.1f, 0.8f), glm::vec3(0.0f, -0.1f, 0.8f) };
+	for (const glm::vec3& v3Barb : av3Barbs)
+	{
+		av3Vertices.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+		av3Vertices.push_back(v3Barb);
+	}
+	m_axPrimitives[PRIMITIVE_ARROW].uCount = static_cast<unsigned int>(av3Vertices.size()) - m_axPrimitives[PRIMITIVE_ARROW].uFirst;
+
+	glGenVertexArrays(1, &m_uVAO);
+	glGenBuffers(1, &m_uVBO);
+	glBindVertexArray(m_uVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_uVBO);
+	glBufferData(GL_ARRAY_BUFFER, av3Vertices.size() * sizeof(glm::vec3), av3Vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(0, uMESH_BINDING);
+	glBindVertexBuffer(uMESH_BINDING, m_uVBO, 0, sizeof(glm::vec3));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(1, uORIGIN_BINDING);
+	glVertexBindingDivisor(uORIGIN_BINDING, 1);
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribFormat(2, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(2, uVECTOR_BINDING);
+	glVertexBindingDivisor(uVECTOR_BINDING, 1);
+
+	glBindVertexArray(0);
+}
+
+/// <summary>
+/// The streams are written straight into the mapped region, each boid's position, velocity and behaviour
+/// forces going into its own run so each draw reads one run as the origins and another as the vectors
+/// </summary>
+void FlockDebugDraw::Draw(const BoidSnapshot& a_xSnapshot, unsigned int a_uShow)
+{
+	m_uBoidCount = 0;
+	m_uDrawCallCount = 0;
+	const unsigned int uCount = a_xSnapshot.GetBoidCount();
+	if (a_uShow == 0 || uCount == 0)
+	{
+		return; // nothing to draw
+	}
+
+	EndFrame();
+	const size_t uCapacity = uCount;
+	glm::vec4* pv4Streams = static_cast<glm::vec4*>(m_pInstanceBuffer->BeginRegion(uCapacity * uSTREAM_COUNT * sizeof(glm::vec4)));
+	if (!pv4Streams)
+	{
+		return; // early out
+	}
+	m_bRegionOpen = true;
+
+	for (unsigned int uBoid = 0; uBoid < uCount; uBoid++)
+	{
+		pv4Streams[uSTREAM_POSITION * uCapacity + uBoid] = glm::vec4(a_xSnapshot.av3Positions[uBoid], 1.0f);
+		pv4Streams[uSTREAM_VELOCITY * uCapacity + uBoid] = glm::vec4(a_xSnapshot.av3Velocities[uBoid], 0.0f);
+		for (unsigned int i = 0; i < BEHAVIOUR_COUNT; i++)
+		{
+			pv4Streams[(uSTREAM_FIRST_FORCE + i) * uCapacity + uBoid] = glm::vec4(a_xSnapshot.av3BehaviourForces[uBoid * BEHAVIOUR_COUNT + i], 0.0f);
+		}
+	}
+	m_uBoidCount = uCount;
+
+	const unsigned int uBuffer = m_pInstanceBuffer->GetBuffer();
+	const size_t uRegionOffset = m_pInstanceBuffer->GetRegionOffset();
+	const size_t uStreamBytes = uCapacity * sizeof(glm::vec4);
+	const size_t uPositions = uRegionOffset + uSTREAM_POSITION * uStreamBytes;
+
+	m_pShader->use();
+	if (a_uShow & SHOW_NEIGHBOURHOOD)
+	{
+		DrawPrimitive(PRIMITIVE_SPHERE, uCount, uBuffer, uPositions, uBuffer, uPositions, v4NEIGHBOURHOOD_COLOUR, 1.0f, m_fNeighbourhoodRadius);
+	}
+	if (a_uShow & SHOW_FORCES)
+	{
+		for (unsigned int i = 0; i < BEHAVIOUR_COUNT; i++)
+		{
+			const size_t uForces = uRegionOffset + (uSTREAM_FIRST_FORCE + i) * uStreamBytes;
+			DrawPrimitive(PRIMITIVE_LINE, uCount, uBuffer, uPositions, uBuffer, uForces, av4FORCE_COLOURS[i], m_fForceScale, 0.0f);
+		}
+	}
+	if (a_uShow & SHOW_VELOCITY)
+	{
+		const size_t uVelocities = uRegionOffset + uSTREAM_VELOCITY * uStreamBytes;
+		DrawPrimitive(PRIMITIVE_ARROW, uCount, uBuffer, uPositions, uBuffer, uVelocities, v4VELOCITY_COLOUR, m_fVelocityScale, 0.0f);
+	}
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+/// <summary>
+/// The storage buffers hold a vec4 per boid already, so they are read as instance attributes as they are
+/// </summary>
+void FlockDebugDraw::Draw(const GpuFlock& a_xFlock, unsigned int a_uShow)
+{
+	m_uBoidCount = a_xFlock.GetCount();
+	m_uDrawCallCount = 0;
+	if (a_uShow == 0 || m_uBoidCount == 0)
+	{
+		return; // nothing to draw
+	}
+
+	m_pShader->use();
+	if (a_uShow & SHOW_NEIGHBOURHOOD)
+	{
+		DrawPrimitive(PRIMITIVE_SPHERE, m_uBoidCount, a_xFlock.GetPositionBuffer(), 0, a_xFlock.GetPositionBuffer(), 0, v4NEIGHBOURHOOD_COLOUR, 1.0f, m_fNeighbourhoodRadius);
+	}
+	if (a_uShow & SHOW_FORCES)
+	{
+		DrawPrimitive(PRIMITIVE_LINE, m_uBoidCount, a_xFlock.GetPositionBuffer(), 0, a_xFlock.GetForceBuffer(), 0, v4TOTAL_FORCE_COLOUR, m_fForceScale, 0.0f);
+	}
+	if (a_uShow & SHOW_VELOCITY)
+	{
+		DrawPrimitive(PRIMITIVE_ARROW, m_uBoidCount, a_xFlock.GetPositionBuffer(), 0, a_xFlock.GetVelocityBuffer(), 0, v4VELOCITY_COLOUR, m_fVelocityScale, 0.0f);
+	}
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+void FlockDebugDraw::EndFrame()
+{
+	if (m_bRegionOpen)
+	{
+		m_pInstanceBuffer->EndRegion();
+		m_bRegionOpen = false;
+	}
+}
+
+void FlockDebugDraw::DrawPrimitive(PRIMITIVE a_ePrimitive, unsigned int a_uCount, unsigned int a_uOriginBuffer, size_t a_uOriginOffset,
+	unsigned int a_uVectorBuffer, size_t a_uVectorOffset, const glm::vec4& a_v4Colour, float a_fScale, float a_fRadius)
+{
+	m_pShader->setVec4(xCOLOUR_UNIFORM, a_v4Colour);
+	m_pShader->setFloat(xSCALE_UNIFORM, a_fScale);
+	m_pShader->setFloat(xRADIUS_UNIFORM, a_fRadius);
+
+	glBindVertexArray(m_uVAO);
+	glBindVertexBuffer(uORIGIN_BINDING, a_uOriginBuffer, static_cast<GLintptr>(a_uOriginOffset), sizeof(glm::vec4));
+	glBindVertexBuffer(uVECTOR_BINDING, a_uVectorBuffer, static_cast<GLintptr>(a_uVectorOffset), sizeof(glm::vec4));
+	glDrawArraysInstanced(GL_LINES, m_axPrimitives[a_ePrimitive].uFirst, m_axPrimitives[a_ePrimitive].uCount, a_uCount);
+	m_uDrawCallCount++;
+}
@@ -0,0 +1,44 @@
+// This files header
+#include "FrameUniforms.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// constructor
+FrameUniforms::FrameUniforms() : m_uBuffer(0), m_v2ImpostorFade(0.0f)
+{
+	glGenBuffers(1, &m_uBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_uBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(BlockData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, uFRAME_UNIFORMS_BINDING, m_uBuffer);
+}
+
+// destructor
+FrameUniforms::~FrameUniforms()
+{
+	if (m_uBuffer)
+	{
+		glDeleteBuffers(1, &m_uBuffer);
+	}
+}
+
+/// <summary>
+/// Replaces the whole block in one upload. The buffer is bound again in case anything else has used the binding point
+/// </summary>
+void FrameUniforms::Update(const glm::mat4& a_m4View, const glm::mat4& a_m4Projection)
+{
+	BlockData xData;
+	xData.m4View = a_m4View;
+	xData.m4Projection = a_m4Projection;
+	// the camera sits at the origin of view space, so it is wherever the inverse view puts the origin
+	xData.v4CameraPosition = glm::inverse(a_m4View)[3];
+	xData.v4ImpostorFade = glm::vec4(m_v2ImpostorFade, 0.0f, 0.0f);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_uBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(BlockData), &xData);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, uFRAME_UNIFORMS_BINDING, m_uBuffer);
+}
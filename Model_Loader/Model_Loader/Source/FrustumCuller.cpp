@@ -0,0 +1,116 @@
+// This files header
+#include "FrustumCuller.h"
+
+// SSE is always there on x64, for anything else it has to be turned on
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+// constants
+static const unsigned int uPLANE_COUNT = 6;
+
+// constructor
+FrustumCuller::FrustumCuller()
+{
+	// planes every point is in front of, so nothing is culled until a frustum is set
+	for (unsigned int i = 0; i < uPLANE_COUNT; i++)
+	{
+		m_av4Planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/// <summary>
+/// Each plane is the sum or difference of the fourth row of the matrix and one of the others (Gribb and Hartmann).
+/// They are normalised so the distance to a plane can be compared with a radius
+/// </summary>
+void FrustumCuller::SetFrustum(const glm::mat4& a_m4ProjectionView)
+{
+	// glm is column major, so a row is one element from each column
+	glm::vec4 av4Rows[4];
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		av4Rows[i] = glm::vec4(a_m4ProjectionView[0][i], a_m4ProjectionView[1][i], a_m4ProjectionView[2][i], a_m4ProjectionView[3][i]);
+	}
+
+	m_av4Planes[0] = av4Rows[3] + av4Rows[0]; // left
+	m_av4Planes[1] = av4Rows[3] - av4Rows[0]; // right
+	m_av4Planes[2] = av4Rows[3] + av4Rows[1]; // bottom
+	m_av4Planes[3] = av4Rows[3] - av4Rows[1]; // top
+	m_av4Planes[4] = av4Rows[3] + av4Rows[2]; // near
+	m_av4Planes[5] = av4Rows[3] - av4Rows[2]; // far
+
+	for (unsigned int i = 0; i < uPLANE_COUNT; i++)
+	{
+		float fLength = glm::length(glm::vec3(m_av4Planes[i]));
+		if (fLength > 0.0f)
+		{
+			m_av4Planes[i] /= fLength;
+		}
+	}
+}
+
+bool FrustumCuller::TestSphere(const glm::vec3& a_v3Centre, float a_fRadius) const
+{
+	for (unsigned int i = 0; i < uPLANE_COUNT; i++)
+	{
+		// wholly behind any one plane is enough to be outside
+		if (glm::dot(glm::vec3(m_av4Planes[i]), a_v3Centre) + m_av4Planes[i].w < -a_fRadius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Four spheres go through each plane at once, one per lane, and a sphere stays visible while its distance to
+/// every plane is more than minus its radius
+/// </summary>
+void FrustumCuller::TestSpheres(const float* a_pfX, const float* a_pfY, const float* a_pfZ, const float* a_pfRadius,
+	unsigned int a_uBegin, unsigned int a_uEnd, unsigned char* a_pbVisible) const
+{
+	unsigned int i = a_uBegin;
+
+#ifdef FRUSTUM_CULLER_SSE
+	// each plane spread across all four lanes
+	__m128 axPlaneX[uPLANE_COUNT], axPlaneY[uPLANE_COUNT], axPlaneZ[uPLANE_COUNT], axPlaneW[uPLANE_COUNT];
+	for (unsigned int uPlane = 0; uPlane < uPLANE_COUNT; uPlane++)
+	{
+		axPlaneX[uPlane] = _mm_set1_ps(m_av4Planes[uPlane].x);
+		axPlaneY[uPlane] = _mm_set1_ps(m_av4Planes[uPlane].y);
+		axPlaneZ[uPlane] = _mm_set1_ps(m_av4Planes[uPlane].z);
+		axPlaneW[uPlane] = _mm_set1_ps(m_av4Planes[uPlane].w);
+	}
+
+	const __m128 xZero = _mm_setzero_ps();
+	for (; i + 4 <= a_uEnd; i += 4)
+	{
+		__m128 xX = _mm_loadu_ps(a_pfX + i);
+		__m128 xY = _mm_loadu_ps(a_pfY + i);
+		__m128 xZ = _mm_loadu_ps(a_pfZ + i);
+		__m128 xNegRadius = _mm_sub_ps(xZero, _mm_loadu_ps(a_pfRadius + i));
+
+		// all lanes set to start with, each plane can only clear them
+		__m128 xInside = _mm_cmpeq_ps(xZero, xZero);
+		for (unsigned int uPlane = 0; uPlane < uPLANE_COUNT; uPlane++)
+		{
+			__m128 xDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xX, axPlaneX[uPlane]), _mm_mul_ps(xY, axPlaneY[uPlane])),
+				_mm_add_ps(_mm_mul_ps(xZ, axPlaneZ[uPlane]), axPlaneW[uPlane]));
+			xInside = _mm_and_ps(xInside, _mm_cmpge_ps(xDistance, xNegRadius));
+		}
+
+		int iMask = _mm_movemask_ps(xInside);
+		a_pbVisible[i] = static_cast<unsigned char>(iMask & 1);
+		a_pbVisible[i + 1] = static_cast<unsigned char>((iMask >> 1) & 1);
+		a_pbVisible[i + 2] = static_cast<unsigned char>((iMask >> 2) & 1);
+		a_pbVisible[i + 3] = static_cast<unsigned char>((iMask >> 3) & 1);
+	}
+#endif
+
+	// whatever didn't fill a group of four
+	for (; i < a_uEnd; i++)
+	{
+		a_pbVisible[i] = TestSphere(glm::vec3(a_pfX[i], a_pfY[i], a_pfZ[i]), a_pfRadius[i]) ? 1 : 0;
+	}
+}
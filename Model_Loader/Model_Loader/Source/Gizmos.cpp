@@ -1,17 +1,18 @@
 #include "Gizmos.h"
+#include "FrameUniforms.h"
 #include <sstream>
 #include <glad/glad.h>
 #include <glm/ext.hpp>
 
 Gizmos* Gizmos::sm_singleton = nullptr;
 
+// layer buffers grow by whole chunks of this many lines or triangles
+static const unsigned int uGIZMO_BUFFER_CHUNK = 4096;
+// how many different circles or spheres are kept before the caches start again
+static const unsigned int uGIZMO_CACHE_LIMIT = 64;
+
 Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris)
-	: m_maxLines(a_maxLines),
-	m_maxTris(a_maxTris),
-	m_lineCount(0),
-	m_triCount(0),
-	m_lines(new GizmoLine[a_maxLines]),
-	m_tris(new GizmoTri[a_maxTris])
+	: m_currentLayer(nullptr)
 {
 	//\==============================================================================================
 	//\ Create our Vertex Shader from a char array
@@ -19,8 +20,8 @@ Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris)
 					 in vec4 Position; \
 					 in vec4 Colour; \
 					 out vec4 vColour; \
-					 uniform mat4 ProjectionView; \
-					 void main() { vColour = Colour; gl_Position = ProjectionView * Position; }";
+					 layout(std140) uniform FrameUniforms { mat4 View; mat4 Projection; }; \
+					 void main() { vColour = Colour; gl_Position = Projection * View * Position; }";
 
 	m_vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(m_vertexShader, 1, (const char**)&vsSource, 0);
@@ -43,33 +44,14 @@ Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris)
 	glBindAttribLocation(m_programID, 0, "Position");
 	glBindAttribLocation(m_programID, 1, "Colour");
 	glLinkProgram(m_programID);
-	
-	// create VBOs
-	glGenBuffers(1, &m_lineVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxLines * sizeof(GizmoLine), m_lines, GL_DYNAMIC_DRAW);
-
-
-	glGenBuffers(1, &m_triVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(GizmoTri), m_tris, GL_DYNAMIC_DRAW);
-
-
-	glGenVertexArrays(1, &m_lineVAO);
-	glBindVertexArray(m_lineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
 
-	glGenVertexArrays(1, &m_triVAO);
-	glBindVertexArray(m_triVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+	// the view and projection come from the same uniform buffer the models use
+	unsigned int frameUniformsBlock = glGetUniformBlockIndex(m_programID, szFRAME_UNIFORMS_BLOCK);
+	if (frameUniformsBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_programID, frameUniformsBlock, uFRAME_UNIFORMS_BINDING);
+	
+	// the default layer, the one everything went to before there were layers
+	m_currentLayer = createLayerData(false, a_maxLines, a_maxTris);
 
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -77,18 +59,18 @@ Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris)
 
 Gizmos::~Gizmos()
 {
-	delete[] m_lines;
-	delete[] m_tris;
-	glDeleteBuffers(1, &m_lineVBO);
-	glDeleteBuffers(1, &m_triVBO);
-	glDeleteVertexArrays(1, &m_lineVAO);
-	glDeleteVertexArrays(1, &m_triVAO);
+	for (GizmoLayer* layer : m_layers)
+	{
+		destroyBuffer(layer->lineBuffer);
+		destroyBuffer(layer->triBuffer);
+		delete layer;
+	}
 	glDeleteProgram(m_programID);
 	glDeleteShader(m_fragmentShader);
 	glDeleteShader(m_vertexShader);
 }
 
-void Gizmos::create(unsigned int a_maxLines /* = 16384 */, unsigned int a_maxTris /* = 16384 */)
+void Gizmos::create(unsigned int a_maxLines /* = 4096 */, unsigned int a_maxTris /* = 4096 */)
 {
 	if (sm_singleton == nullptr)
 		sm_singleton = new Gizmos(a_maxLines, a_maxTris);
@@ -102,8 +84,173 @@ void Gizmos::destroy()
 
 void Gizmos::clear()
 {
-	sm_singleton->m_lineCount = 0;
-	sm_singleton->m_triCount = 0;
+	for (GizmoLayer* layer : sm_singleton->m_layers)
+	{
+		if (!layer->isStatic)
+		{
+			layer->lines.clear();
+			layer->tris.clear();
+			layer->dirty = true;
+		}
+	}
+}
+
+unsigned int Gizmos::createLayer(bool a_bStatic)
+{
+	if (sm_singleton == nullptr)
+		return 0;
+	sm_singleton->createLayerData(a_bStatic, 0, 0);
+	return (unsigned int)sm_singleton->m_layers.size() - 1;
+}
+
+void Gizmos::setLayer(unsigned int a_layer)
+{
+	if (sm_singleton != nullptr && a_layer < sm_singleton->m_layers.size())
+		sm_singleton->m_currentLayer = sm_singleton->m_layers[a_layer];
+}
+
+void Gizmos::clearLayer(unsigned int a_layer)
+{
+	if (sm_singleton != nullptr && a_layer < sm_singleton->m_layers.size())
+	{
+		GizmoLayer* layer = sm_singleton->m_layers[a_layer];
+		layer->lines.clear();
+		layer->tris.clear();
+		layer->dirty = true;
+	}
+}
+
+Gizmos::GizmoLayer* Gizmos::createLayerData(bool a_bStatic, unsigned int a_lines, unsigned int a_tris)
+{
+	GizmoLayer* layer = new GizmoLayer();
+	layer->isStatic = a_bStatic;
+	layer->dirty = false;
+	layer->lines.reserve(a_lines);
+	layer->tris.reserve(a_tris);
+	createBuffer(layer->lineBuffer, sizeof(GizmoLine), a_lines);
+	createBuffer(layer->triBuffer, sizeof(GizmoTri), a_tris);
+	m_layers.push_back(layer);
+	return layer;
+}
+
+void Gizmos::createBuffer(GizmoBuffer& a_buffer, unsigned int a_primitiveSize, unsigned int a_capacity)
+{
+	a_buffer.capacity = a_capacity;
+	a_buffer.count = 0;
+
+	glGenBuffers(1, &a_buffer.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, a_buffer.vbo);
+	glBufferData(GL_ARRAY_BUFFER, a_capacity * a_primitiveSize, nullptr, GL_DYNAMIC_DRAW);
+
+	glGenVertexArrays(1, &a_buffer.vao);
+	glBindVertexArray(a_buffer.vao);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Gizmos::destroyBuffer(GizmoBuffer& a_buffer)
+{
+	glDeleteBuffers(1, &a_buffer.vbo);
+	glDeleteVertexArrays(1, &a_buffer.vao);
+}
+
+void Gizmos::uploadBuffer(GizmoBuffer& a_buffer, const void* a_data, unsigned int a_count, unsigned int a_primitiveSize, bool a_bStatic)
+{
+	a_buffer.count = a_count;
+	if (a_count == 0)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, a_buffer.vbo);
+	if (a_count > a_buffer.capacity)
+	{
+		// grow to the next whole chunk, so a layer that keeps growing isn't reallocated every time
+		a_buffer.capacity = (a_count + uGIZMO_BUFFER_CHUNK - 1) / uGIZMO_BUFFER_CHUNK * uGIZMO_BUFFER_CHUNK;
+		glBufferData(GL_ARRAY_BUFFER, a_buffer.capacity * a_primitiveSize, nullptr, a_bStatic ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+	}
+	else if (!a_bStatic)
+	{
+		// orphan the old storage, rather than wait for last frame's draw to finish with it
+		glBufferData(GL_ARRAY_BUFFER, a_buffer.capacity * a_primitiveSize, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, a_count * a_primitiveSize, a_data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool Gizmos::SphereKey::operator<(const SphereKey& a_other) const
+{
+	if (rows != a_other.rows) return rows < a_other.rows;
+	if (columns != a_other.columns) return columns < a_other.columns;
+	if (longMin != a_other.longMin) return longMin < a_other.longMin;
+	if (longMax != a_other.longMax) return longMax < a_other.longMax;
+	if (latMin != a_other.latMin) return latMin < a_other.latMin;
+	return latMax < a_other.latMax;
+}
+
+const std::vector<glm::vec2>& Gizmos::circlePoints(unsigned int a_segments)
+{
+	std::map<unsigned int, std::vector<glm::vec2>>::iterator iter = m_circleCache.find(a_segments);
+	if (iter != m_circleCache.end())
+		return iter->second;
+
+	// nothing should ask for this many different circles, but don't let it grow forever if something does
+	if (m_circleCache.size() >= uGIZMO_CACHE_LIMIT)
+		m_circleCache.clear();
+
+	std::vector<glm::vec2>& points = m_circleCache[a_segments];
+	points.resize(a_segments + 1);
+	float fSegmentSize = (2 * glm::pi<float>()) / a_segments;
+	for (unsigned int i = 0; i < a_segments; ++i)
+		points[i] = glm::vec2(sinf(i * fSegmentSize), cosf(i * fSegmentSize));
+	points[a_segments] = points[0];
+	return points;
+}
+
+const std::vector<glm::vec3>& Gizmos::spherePoints(const SphereKey& a_key)
+{
+	std::map<SphereKey, std::vector<glm::vec3>>::iterator iter = m_sphereCache.find(a_key);
+	if (iter != m_sphereCache.end())
+		return iter->second;
+
+	if (m_sphereCache.size() >= uGIZMO_CACHE_LIMIT)
+		m_sphereCache.clear();
+
+	//Invert these first as the multiply is slightly quicker
+	float invColumns = 1.0f / float(a_key.columns);
+	float invRows = 1.0f / float(a_key.rows);
+
+	float DEG2RAD = glm::pi<float>() / 180;
+
+	//Lets put everything in radians first
+	float latitiudinalRange = (a_key.latMax - a_key.latMin) * DEG2RAD;
+	float longitudinalRange = (a_key.longMax - a_key.longMin) * DEG2RAD;
+
+	std::vector<glm::vec3>& points = m_sphereCache[a_key];
+	points.resize(a_key.rows * a_key.columns + a_key.columns);
+
+	// for each row of the mesh
+	for (int row = 0; row <= a_key.rows; ++row)
+	{
+		// y ordinates this may be a little confusing but here we are navigating around the xAxis in GL
+		float ratioAroundXAxis = float(row) * invRows;
+		float radiansAboutXAxis = ratioAroundXAxis * latitiudinalRange + (a_key.latMin * DEG2RAD);
+		float y = sin(radiansAboutXAxis);
+		float z = cos(radiansAboutXAxis);
+
+		for (int col = 0; col <= a_key.columns; ++col)
+		{
+			float ratioAroundYAxis = float(col) * invColumns;
+			float theta = ratioAroundYAxis * longitudinalRange + (a_key.longMin * DEG2RAD);
+
+			int index = row * a_key.columns + (col % a_key.columns);
+			points[index] = glm::vec3(-z * sinf(theta), y, -z * cosf(theta));
+		}
+	}
+	return points;
 }
 
 // Adds 3 unit-length lines (red,green,blue) representing the 3 axis of a transform, 
@@ -214,9 +361,12 @@ void Gizmos::addCylinder(const glm::vec3& a_center, float a_radius,
 	const glm::mat4& a_transform /* = mat4::identity */,
 	glm::vec3** vertexData /*= nullptr*/, unsigned int* a_vertexCount /*= nullptr*/)
 {
+	if (sm_singleton == nullptr)
+		return;
+
 	glm::vec4 vWhite(1, 1, 1, 1);
 
-	float fSegmentSize = (2 * glm::pi<float>()) / a_segments;
+	const std::vector<glm::vec2>& points = sm_singleton->circlePoints(a_segments);
 	if (vertexData != nullptr)
 	{
 		*vertexData = new glm::vec3[a_segments * 12];
@@ -226,12 +376,14 @@ void Gizmos::addCylinder(const glm::vec3& a_center, float a_radius,
 
 	for (unsigned int i = 0; i < a_segments; ++i)
 	{
+		glm::vec2 v2Edge1 = points[i] * a_radius;
+		glm::vec2 v2Edge2 = points[i + 1] * a_radius;
 		glm::vec3 v0top(0, a_fHalfLength, 0);
-		glm::vec3 v1top(sinf(i * fSegmentSize) * a_radius, a_fHalfLength, cosf(i * fSegmentSize) * a_radius);
-		glm::vec3 v2top(sinf((i + 1) * fSegmentSize) * a_radius, a_fHalfLength, cosf((i + 1) * fSegmentSize) * a_radius);
+		glm::vec3 v1top(v2Edge1.x, a_fHalfLength, v2Edge1.y);
+		glm::vec3 v2top(v2Edge2.x, a_fHalfLength, v2Edge2.y);
 		glm::vec3 v0bottom(0, -a_fHalfLength, 0);
-		glm::vec3 v1bottom(sinf(i * fSegmentSize) * a_radius, -a_fHalfLength, cosf(i * fSegmentSize) * a_radius);
-		glm::vec3 v2bottom(sinf((i + 1) * fSegmentSize) * a_radius, -a_fHalfLength, cosf((i + 1) * fSegmentSize) * a_radius);
+		glm::vec3 v1bottom(v2Edge1.x, -a_fHalfLength, v2Edge1.y);
+		glm::vec3 v2bottom(v2Edge2.x, -a_fHalfLength, v2Edge2.y);
 
 		v0top = (a_transform * glm::vec4(v0top, 0)).xyz;
 		v1top = (a_transform * glm::vec4(v1top, 0)).xyz;
@@ -274,8 +426,10 @@ void Gizmos::addCircle(const glm::vec3& a_center, float a_radius, unsigned int a
 	const glm::mat4& a_transform /* = mat4::identity */,
 	glm::vec3** vertexData /*= nullptr*/, unsigned int* a_vertexCount /*= nullptr*/)
 {
-	//calculate the inner angle for each segment
-	float fAngle = (2 * glm::pi<float>()) / a_segments;
+	if (sm_singleton == nullptr)
+		return;
+
+	const std::vector<glm::vec2>& points = sm_singleton->circlePoints(a_segments);
 	//We can start our first edge vector at (0,0,radius) as sin(0) = 0, cos(0) = 1
 	glm::vec4 v3Edge1(0, 0, a_radius, 0);
 	if (vertexData != nullptr)
@@ -287,7 +441,7 @@ void Gizmos::addCircle(const glm::vec3& a_center, float a_radius, unsigned int a
 	for (unsigned int i = 0; i < a_segments; ++i)
 	{
 
-		glm::vec4 v3Edge2(sinf((i + 1) * fAngle) * a_radius, 0, cosf((i + 1) * fAngle) * a_radius, 0);
+		glm::vec4 v3Edge2(points[i + 1].x * a_radius, 0, points[i + 1].y * a_radius, 0);
 
 		v3Edge1 = a_transform * v3Edge1;
 		v3Edge2 = a_transform * v3Edge2;
@@ -318,47 +472,32 @@ void Gizmos::addSphere(const glm::vec3& a_center, int a_rows, int a_columns, flo
 	float a_latMin /*= -90*/, float a_latMax /*= 90*/,
 	glm::vec3** vertexData/* = nullptr*/, unsigned int* a_vertexCount /*= nullptr*/)
 {
-	//Invert these first as the multiply is slightly quicker
-	float invColumns = 1.0f / float(a_columns);
-	float invRows = 1.0f / float(a_rows);
+	if (sm_singleton == nullptr)
+		return;
 
-	float DEG2RAD = glm::pi<float>() / 180;
+	float longitudinalRange = (a_longMax - a_longMin) * glm::pi<float>() / 180;
 
-	//Lets put everything in radians first
-	float latitiudinalRange = (a_latMax - a_latMin) * DEG2RAD;
-	float longitudinalRange = (a_longMax - a_longMin) * DEG2RAD;
-	// for each row of the mesh
-	glm::vec3* v4Array = new glm::vec3[a_rows*a_columns + a_columns];
+	SphereKey key = { a_rows, a_columns, a_longMin, a_longMax, a_latMin, a_latMax };
+	const std::vector<glm::vec3>& points = sm_singleton->spherePoints(key);
 
-	for (int row = 0; row <= a_rows; ++row)
+	// place the unit sphere, in a buffer kept between calls
+	std::vector<glm::vec3>& v4Array = sm_singleton->m_sphereScratch;
+	v4Array.resize(points.size());
+	for (size_t i = 0; i < points.size(); ++i)
 	{
-		// y ordinates this may be a little confusing but here we are navigating around the xAxis in GL
-		float ratioAroundXAxis = float(row) * invRows;
-		float radiansAboutXAxis = ratioAroundXAxis * latitiudinalRange + (a_latMin * DEG2RAD);
-		float y = a_radius * sin(radiansAboutXAxis);
-		float z = a_radius * cos(radiansAboutXAxis);
-
-		for (int col = 0; col <= a_columns; ++col)
+		glm::vec3 v4Point = points[i] * a_radius;
+		if (a_transform != nullptr)
 		{
-			float ratioAroundYAxis = float(col) * invColumns;
-			float theta = ratioAroundYAxis * longitudinalRange + (a_longMin * DEG2RAD);
-			glm::vec3 v4Point(-z * sinf(theta), y, -z * cosf(theta));
-
-			if (a_transform != nullptr)
-			{
-				v4Point = (*a_transform * glm::vec4(v4Point, 0)).xyz;
-			}
-
-			int index = row * a_columns + (col % a_columns);
-			v4Array[index] = a_center + v4Point;
+			v4Point = glm::vec3(*a_transform * glm::vec4(v4Point, 0));
 		}
+		v4Array[i] = a_center + v4Point;
 	}
 
 	if (vertexData != nullptr)
 	{
 		unsigned int vertexCount = a_rows * a_columns + a_columns;
 		*vertexData = new glm::vec3[vertexCount];
-		memcpy(*vertexData, v4Array, sizeof(glm::vec3)*vertexCount);
+		memcpy(*vertexData, v4Array.data(), sizeof(glm::vec3)*vertexCount);
 		*a_vertexCount = a_rows * a_columns + a_columns;
 	}
 
@@ -382,8 +521,6 @@ void Gizmos::addSphere(const glm::vec3& a_center, int a_rows, int a_columns, flo
 		addTri(v4Array[iNextFace + a_columns], v4Array[face], v4Array[iNextFace], a_fillColour);
 		addTri(v4Array[iNextFace + a_columns], v4Array[face + a_columns], v4Array[face], a_fillColour);
 	}
-
-	delete[] v4Array;
 }
 
 
@@ -394,15 +531,16 @@ void Gizmos::addLine(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::
 
 void Gizmos::addLine(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::vec4& a_colour0, const glm::vec4& a_colour1)
 {
-	if (sm_singleton != nullptr &&
-		sm_singleton->m_lineCount < sm_singleton->m_maxLines)
+	if (sm_singleton != nullptr)
 	{
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.position = glm::vec4(a_rv0, 1);
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.colour = a_colour0;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.position = glm::vec4(a_rv1, 1);
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.colour = a_colour1;
-
-		sm_singleton->m_lineCount++;
+		GizmoLine line;
+		line.v0.position = glm::vec4(a_rv0, 1);
+		line.v0.colour = a_colour0;
+		line.v1.position = glm::vec4(a_rv1, 1);
+		line.v1.colour = a_colour1;
+
+		sm_singleton->m_currentLayer->lines.push_back(line);
+		sm_singleton->m_currentLayer->dirty = true;
 	}
 }
 
@@ -410,52 +548,60 @@ void Gizmos::addTri(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::v
 {
 	if (sm_singleton != nullptr)
 	{
-		if (sm_singleton->m_triCount < sm_singleton->m_maxTris)
-		{
-			sm_singleton->m_tris[sm_singleton->m_triCount].v0.position = glm::vec4(a_rv0, 1);
-			sm_singleton->m_tris[sm_singleton->m_triCount].v1.position = glm::vec4(a_rv1, 1);
-			sm_singleton->m_tris[sm_singleton->m_triCount].v2.position = glm::vec4(a_rv2, 1);
-			sm_singleton->m_tris[sm_singleton->m_triCount].v0.colour = a_colour;
-			sm_singleton->m_tris[sm_singleton->m_triCount].v1.colour = a_colour;
-			sm_singleton->m_tris[sm_singleton->m_triCount].v2.colour = a_colour;
-
-			sm_singleton->m_triCount++;
-		}
+		GizmoTri tri;
+		tri.v0.position = glm::vec4(a_rv0, 1);
+		tri.v1.position = glm::vec4(a_rv1, 1);
+		tri.v2.position = glm::vec4(a_rv2, 1);
+		tri.v0.colour = a_colour;
+		tri.v1.colour = a_colour;
+		tri.v2.colour = a_colour;
+
+		sm_singleton->m_currentLayer->tris.push_back(tri);
+		sm_singleton->m_currentLayer->dirty = true;
 	}
 }
 
-void Gizmos::draw(const glm::mat4& a_projectionView)
+void Gizmos::draw()
 {
-	if (sm_singleton != nullptr &&
-		(sm_singleton->m_lineCount > 0 || sm_singleton->m_triCount > 0))
+	if (sm_singleton == nullptr)
+		return;
+
+	bool bProgramBound = false;
+	for (GizmoLayer* layer : sm_singleton->m_layers)
 	{
-		glUseProgram(sm_singleton->m_programID);
+		// only layers that changed since they were last drawn are sent to the GPU again
+		if (layer->dirty)
+		{
+			sm_singleton->uploadBuffer(layer->lineBuffer, layer->lines.data(), (unsigned int)layer->lines.size(), sizeof(GizmoLine), layer->isStatic);
+			sm_singleton->uploadBuffer(layer->triBuffer, layer->tris.data(), (unsigned int)layer->tris.size(), sizeof(GizmoTri), layer->isStatic);
+			layer->dirty = false;
+		}
+		if (layer->lineBuffer.count == 0 && layer->triBuffer.count == 0)
+			continue;
 
-		unsigned int projectionViewUniform = glGetUniformLocation(sm_singleton->m_programID, "ProjectionView");
-		glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(a_projectionView));
+		if (!bProgramBound)
+		{
+			glUseProgram(sm_singleton->m_programID);
+			bProgramBound = true;
+		}
 
-		if (sm_singleton->m_lineCount > 0)
+		if (layer->lineBuffer.count > 0)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_lineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_lineCount * sizeof(GizmoLine), sm_singleton->m_lines);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindVertexArray(sm_singleton->m_lineVAO);
-			glDrawArrays(GL_LINES, 0, sm_singleton->m_lineCount * 2);
+			glBindVertexArray(layer->lineBuffer.vao);
+			glDrawArrays(GL_LINES, 0, layer->lineBuffer.count * 2);
 		}
 
-		if (sm_singleton->m_triCount > 0)
+		if (layer->triBuffer.count > 0)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_triVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_triCount * sizeof(GizmoTri), sm_singleton->m_tris);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindVertexArray(sm_singleton->m_triVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_triCount * 3);
+			glBindVertexArray(layer->triBuffer.vao);
+			glDrawArrays(GL_TRIANGLES, 0, layer->triBuffer.count * 3);
 		}
+	}
 
+	if (bProgramBound)
+	{
 		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glUseProgram(0);
-
 	}
 }
 
@@ -0,0 +1,280 @@
+// This files header
+#include "GpuFlock.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// LearnOpenGL includes
+#include <learnopengl/shader_c.h>
+
+// std includes
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+// typedefs
+typedef FlockWorkspace<3, float> GridLayout;
+
+// constants
+static const char* szFLOCK_SHADER = "shaders/flock.comp";
+// must match the local sizes in flock.comp
+static const unsigned int uBOID_GROUP_SIZE = 128;
+static const char* aszPASS_DEFINES[] = { "#define FLOCK_BIN", "#define FLOCK_SCAN", "#define FLOCK_SCATTER", "#define FLOCK_FORCES", "#define FLOCK_INTEGRATE" };
+
+// the uniforms, interned once as they are set every pass every step
+static const UniformName xBOID_COUNT("boidCount");
+static const UniformName xCELLS_PER_AXIS("cellsPerAxis");
+static const UniformName xCELL_COUNT("cellCount");
+static const UniformName xCELL_SIZE("cellSize");
+static const UniformName xGRID_MIN("gridMin");
+static const UniformName xWEIGHTS("weights");
+static const UniformName xNEIGHBOURHOOD_RADIUS("neighbourhoodRadius");
+static const UniformName xBOUNDS_SIZE("boundsSize");
+static const UniformName xEARLY_SEPARATION_DIST("earlySeparationDist");
+static const UniformName xBOUNDS_FLEE_FORCE("boundsFleeForce");
+static const UniformName xMAX_SPEED("maxSpeed");
+static const UniformName xOBSTACLE("obstacle");
+static const UniformName xOBSTACLE_SIZE("obstacleSize");
+static const UniformName xOBSTACLE_RADIUS("obstacleRadius");
+static const UniformName xEXTRA_WANDER("extraWander");
+static const UniformName xDELTA_TIME("deltaTime");
+static const UniformName xSEED("seed");
+static const UniformName xMODEL_SCALE("modelScale");
+
+// constructor
+GpuFlock::GpuFlock() : m_bValid(true), m_uCount(0), m_uBoidCapacity(0), m_uCellCapacity(0), m_uSeed(1),
+	m_uCellsPerAxis(1), m_uCellCount(1), m_fCellSize(1.0f), m_fGridMin(0.0f)
+{
+	for (unsigned int i = 0; i < PASS_COUNT; i++)
+	{
+		m_apPasses[i] = new ComputeShader(szFLOCK_SHADER, aszPASS_DEFINES[i]);
+		m_bValid = m_bValid && m_apPasses[i]->isValid();
+	}
+	if (!m_bValid)
+	{
+		std::cout << "Failed to build the GPU flock compute shaders" << std::endl;
+	}
+
+	glGenBuffers(BUFFER_COUNT, m_auBuffers);
+}
+
+// destructor
+GpuFlock::~GpuFlock()
+{
+	for (unsigned int i = 0; i < PASS_COUNT; i++)
+	{
+		glDeleteProgram(m_apPasses[i]->ID);
+		delete m_apPasses[i];
+	}
+	glDeleteBuffers(BUFFER_COUNT, m_auBuffers);
+}
+
+/// <summary>
+/// Reallocating loses what the buffers held, so the boid buffers only grow on upload, before they are filled
+/// </summary>
+void GpuFlock::Reserve(unsigned int a_uBoidCount, unsigned int a_uCellCount)
+{
+	if (a_uBoidCount > m_uBoidCapacity)
+	{
+		m_uBoidCapacity = a_uBoidCount;
+		const size_t uVectorBytes = m_uBoidCapacity * sizeof(glm::vec4);
+		const size_t auBytes[] = { uVectorBytes, uVectorBytes, uVectorBytes, uVectorBytes, m_uBoidCapacity * sizeof(unsigned int) };
+		for (unsigned int i = BUFFER_POSITIONS; i <= BUFFER_BOID_CELLS; i++)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[i]);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, auBytes[i], nullptr, GL_DYNAMIC_DRAW);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_SORTED_BOIDS]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_uBoidCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_INSTANCE_MATRICES]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_uBoidCapacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	if (a_uCellCount > m_uCellCapacity)
+	{
+		m_uCellCapacity = a_uCellCount;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_CELL_COUNTS]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_uCellCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+		// one more than the cells so the end of the last cell can be read like any other
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_CELL_START]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (m_uCellCapacity + 1) * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::Upload(const std::vector<glm::vec3>& a_av3Positions, const std::vector<glm::vec3>& a_av3Velocities)
+{
+	m_uCount = static_cast<unsigned int>(std::min(a_av3Positions.size(), a_av3Velocities.size()));
+	Reserve(m_uCount, 1);
+	if (m_uCount == 0)
+	{
+		return; // early out
+	}
+
+	// the shaders read vec4s, so the vectors are padded out
+	std::vector<glm::vec4> av4Data(m_uCount);
+	for (unsigned int i = 0; i < m_uCount; i++)
+	{
+		av4Data[i] = glm::vec4(a_av3Positions[i], 1.0f);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_POSITIONS]);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_uCount * sizeof(glm::vec4), av4Data.data());
+
+	for (unsigned int i = 0; i < m_uCount; i++)
+	{
+		av4Data[i] = glm::vec4(a_av3Velocities[i], 0.0f);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_VELOCITIES]);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_uCount * sizeof(glm::vec4), av4Data.data());
+
+	// a zero wander point makes the boid pick a new one
+	std::fill(av4Data.begin(), av4Data.end(), glm::vec4(0.0f));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_WANDER_POINTS]);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_uCount * sizeof(glm::vec4), av4Data.data());
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::Download(std::vector<glm::vec3>& a_av3Positions, std::vector<glm::vec3>& a_av3Velocities) const
+{
+	a_av3Positions.resize(m_uCount);
+	a_av3Velocities.resize(m_uCount);
+	if (m_uCount == 0)
+	{
+		return; // early out
+	}
+
+	std::vector<glm::vec4> av4Data(m_uCount);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_POSITIONS]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_uCount * sizeof(glm::vec4), av4Data.data());
+	for (unsigned int i = 0; i < m_uCount; i++)
+	{
+		a_av3Positions[i] = glm::vec3(av4Data[i]);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_VELOCITIES]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_uCount * sizeof(glm::vec4), av4Data.data());
+	for (unsigned int i = 0; i < m_uCount; i++)
+	{
+		a_av3Velocities[i] = glm::vec3(av4Data[i]);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::SetUniforms(ComputeShader* a_pPass, float a_fDeltaTime, const FlockSettings& a_xSettings, float a_fModelScale) const
+{
+	a_pPass->setUint(xBOID_COUNT, m_uCount);
+	a_pPass->setUint(xCELLS_PER_AXIS, m_uCellsPerAxis);
+	a_pPass->setUint(xCELL_COUNT, m_uCellCount);
+	a_pPass->setFloat(xCELL_SIZE, m_fCellSize);
+	a_pPass->setFloat(xGRID_MIN, m_fGridMin);
+
+	a_pPass->setVec4(xWEIGHTS, a_xSettings.xWeights.fWander, a_xSettings.xWeights.fSeparation, a_xSettings.xWeights.fAlignment, a_xSettings.xWeights.fCohesion);
+	a_pPass->setFloat(xNEIGHBOURHOOD_RADIUS, a_xSettings.fNeighbourhoodRadius);
+	a_pPass->setFloat(xBOUNDS_SIZE, a_xSettings.fBoundsSize);
+	a_pPass->setFloat(xEARLY_SEPARATION_DIST, a_xSettings.fEarlySeparationDist);
+	a_pPass->setFloat(xBOUNDS_FLEE_FORCE, a_xSettings.fBoundsFleeForce);
+	a_pPass->setFloat(xMAX_SPEED, a_xSettings.fMaxSpeed);
+	a_pPass->setVec3(xOBSTACLE, a_xSettings.v3Obstacle);
+	a_pPass->setFloat(xOBSTACLE_SIZE, a_xSettings.fObstacleSize);
+	a_pPass->setFloat(xOBSTACLE_RADIUS, a_xSettings.fObstacleRadius);
+	a_pPass->setBool(xEXTRA_WANDER, a_xSettings.bExtraWander);
+	a_pPass->setFloat(xDELTA_TIME, a_fDeltaTime);
+	a_pPass->setUint(xSEED, m_uSeed);
+	a_pPass->setFloat(xMODEL_SCALE, a_fModelScale);
+}
+
+/// <summary>
+/// Each pass reads what the last one wrote, so there is a barrier between them. The last barrier also covers
+/// the model shader reading the matrices as vertex attributes and anything reading the buffers back
+/// </summary>
+void GpuFlock::Step(float a_fDeltaTime, const FlockSettings& a_xSettings, float a_fModelScale)
+{
+	if (!m_bValid || m_uCount == 0 || !GridLayout::IsValid(a_xSettings))
+	{
+		return; // early out
+	}
+
+	m_fCellSize = GridLayout::CellSize(a_xSettings);
+	m_fGridMin = -(a_xSettings.fBoundsSize + a_xSettings.fEarlySeparationDist);
+	m_uCellsPerAxis = GridLayout::CellsPerAxis(a_xSettings);
+	m_uCellCount = GridLayout::GridCellCount(a_xSettings);
+	Reserve(m_uCount, m_uCellCount);
+
+	for (unsigned int i = 0; i < BUFFER_COUNT; i++)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, m_auBuffers[i]);
+	}
+
+	// the bin pass counts up from zero
+	const unsigned int uZero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_auBuffers[BUFFER_CELL_COUNTS]);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &uZero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	const unsigned int uBoidGroups = (m_uCount + uBOID_GROUP_SIZE - 1) / uBOID_GROUP_SIZE;
+	for (unsigned int i = 0; i < PASS_COUNT; i++)
+	{
+		m_apPasses[i]->use();
+		SetUniforms(m_apPasses[i], a_fDeltaTime, a_xSettings, a_fModelScale);
+		// the scan is a single work group whatever the size of the grid
+		m_apPasses[i]->dispatch(i == PASS_SCAN ? 1 : uBoidGroups);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	glUseProgram(0);
+
+	m_uSeed++;
+}
+
+/// <summary>
+/// With the wander switched off a step has no randomness, so the only difference left is the order neighbours
+/// are summed in (the GPU fills each cell in whatever order its threads get there)
+/// </summary>
+float GpuFlock::CompareWithCpu(unsigned int a_uBoidCount, unsigned int a_uSteps)
+{
+	GpuFlock xGpuFlock;
+	if (!xGpuFlock.IsValid())
+	{
+		return -1.0f;
+	}
+
+	FlockSettings xSettings;
+	xSettings.xWeights.fWander = 0.0f;
+	xSettings.bExtraWander = false;
+	const float fDeltaTime = 1.0f / 60.0f;
+
+	// the same flock every run
+	std::mt19937 xRandom(1234u);
+	std::uniform_real_distribution<float> xPositionRange(-xSettings.fBoundsSize, xSettings.fBoundsSize);
+	std::uniform_real_distribution<float> xVelocityRange(-0.02f, 0.02f);
+
+	std::vector<glm::vec3> av3Positions(a_uBoidCount);
+	std::vector<glm::vec3> av3Velocities(a_uBoidCount);
+	FlockCore3f xCpuFlock;
+	xCpuFlock.Resize(a_uBoidCount);
+	for (unsigned int i = 0; i < a_uBoidCount; i++)
+	{
+		av3Positions[i] = glm::vec3(xPositionRange(xRandom), xPositionRange(xRandom), xPositionRange(xRandom));
+		av3Velocities[i] = glm::vec3(xVelocityRange(xRandom), xVelocityRange(xRandom), xVelocityRange(xRandom));
+		xCpuFlock.SetBoid(i, av3Positions[i], av3Velocities[i]);
+	}
+	xGpuFlock.Upload(av3Positions, av3Velocities);
+
+	for (unsigned int uStep = 0; uStep < a_uSteps; uStep++)
+	{
+		xCpuFlock.Step(fDeltaTime, xSettings);
+		xGpuFlock.Step(fDeltaTime, xSettings);
+	}
+	xGpuFlock.Download(av3Positions, av3Velocities);
+
+	float fMaxError = 0.0f;
+	for (unsigned int i = 0; i < a_uBoidCount; i++)
+	{
+		fMaxError = std::max(fMaxError, glm::distance(av3Positions[i], xCpuFlock.GetPosition(i)));
+	}
+	return fMaxError;
+}
@@ -0,0 +1,191 @@
+// This files header
+#include "GpuProfiler.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// typedefs
+typedef std::chrono::high_resolution_clock Clock;
+
+// constants
+// how many frames can be waiting on their queries. the GPU is rarely more than two behind, a frame still
+// waiting after this many is dropped rather than waited on
+static const unsigned int uFRAME_SLOTS = 4;
+// queries are made this many at a time when the pool runs out
+static const unsigned int uQUERY_BATCH = 16;
+
+// constructor
+GpuProfiler::GpuProfiler() : m_axSlots(uFRAME_SLOTS), m_uCurrentSlot(0), m_bInFrame(false), m_bInPass(false), m_uFrame(0),
+	m_xEpoch(Clock::now()), m_dGpuOffsetUs(0.0), m_uDroppedFrames(0)
+{
+	Calibrate();
+}
+
+// destructor
+GpuProfiler::~GpuProfiler()
+{
+	if (!m_auAllQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(m_auAllQueries.size()), m_auAllQueries.data());
+	}
+}
+
+/// <summary>
+/// GL_TIMESTAMP is the GPU's clock now, so taking it alongside the CPU clock gives the offset between them
+/// </summary>
+void GpuProfiler::Calibrate()
+{
+	GLint64 iGpuNs = 0;
+	glGetInteger64v(GL_TIMESTAMP, &iGpuNs);
+	m_dGpuOffsetUs = NowUs() - static_cast<double>(iGpuNs) / 1000.0;
+}
+
+/// <summary>
+/// Reads back whatever the GPU has finished, oldest first, then starts the new frame in the next slot.
+/// If that slot's frame still isn't done it is thrown away, as waiting on it would stall the frame
+/// </summary>
+void GpuProfiler::BeginFrame()
+{
+	if (m_bInFrame)
+	{
+		EndFrame();
+	}
+
+	m_axResolved.clear();
+	const unsigned int uSlotCount = static_cast<unsigned int>(m_axSlots.size());
+	for (unsigned int i = 1; i <= uSlotCount; i++)
+	{
+		FrameSlot& xSlot = m_axSlots[(m_uCurrentSlot + i) % uSlotCount];
+		// the GPU finishes frames in order, so nothing newer is done either
+		if (xSlot.bPending && !Resolve(xSlot))
+		{
+			break;
+		}
+	}
+
+	m_uCurrentSlot = (m_uCurrentSlot + 1) % uSlotCount;
+	FrameSlot& xSlot = m_axSlots[m_uCurrentSlot];
+	if (xSlot.bPending)
+	{
+		Release(xSlot);
+		m_uDroppedFrames++;
+	}
+
+	xSlot.xTimings.uFrame = m_uFrame++;
+	xSlot.xTimings.xFrame.sName = "Frame";
+	xSlot.xTimings.xFrame.dCpuStartUs = NowUs();
+	xSlot.xTimings.axPasses.clear();
+	xSlot.auQueries.push_back(Timestamp());
+	// the end of the frame, filled in by EndFrame
+	xSlot.auQueries.push_back(0);
+	m_bInFrame = true;
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!m_bInFrame)
+	{
+		return; // early out
+	}
+	EndPass();
+
+	FrameSlot& xSlot = m_axSlots[m_uCurrentSlot];
+	xSlot.auQueries[1] = Timestamp();
+	xSlot.xTimings.xFrame.dCpuUs = NowUs() - xSlot.xTimings.xFrame.dCpuStartUs;
+	xSlot.bPending = true;
+	m_bInFrame = false;
+}
+
+void GpuProfiler::BeginPass(const char* a_szName)
+{
+	if (!m_bInFrame)
+	{
+		return; // early out
+	}
+	EndPass();
+
+	FrameSlot& xSlot = m_axSlots[m_uCurrentSlot];
+	PassTiming xPass;
+	xPass.sName = a_szName;
+	xPass.dCpuStartUs = NowUs();
+	xSlot.xTimings.axPasses.push_back(xPass);
+	xSlot.auQueries.push_back(Timestamp());
+	m_bInPass = true;
+}
+
+void GpuProfiler::EndPass()
+{
+	if (!m_bInPass)
+	{
+		return; // early out
+	}
+
+	FrameSlot& xSlot = m_axSlots[m_uCurrentSlot];
+	PassTiming& xPass = xSlot.xTimings.axPasses.back();
+	xPass.dCpuUs = NowUs() - xPass.dCpuStartUs;
+	xSlot.auQueries.push_back(Timestamp());
+	m_bInPass = false;
+}
+
+/// <summary>
+/// The frame's last timestamp is checked, as the GPU writes them in order the rest are done if it is
+/// </summary>
+bool GpuProfiler::Resolve(FrameSlot& a_xSlot)
+{
+	GLint iAvailable = 0;
+	glGetQueryObjectiv(a_xSlot.auQueries[1], GL_QUERY_RESULT_AVAILABLE, &iAvailable);
+	if (!iAvailable)
+	{
+		return false;
+	}
+
+	std::vector<double> adTimesUs(a_xSlot.auQueries.size());
+	for (unsigned int i = 0; i < a_xSlot.auQueries.size(); i++)
+	{
+		GLuint64 uGpuNs = 0;
+		glGetQueryObjectui64v(a_xSlot.auQueries[i], GL_QUERY_RESULT, &uGpuNs);
+		adTimesUs[i] = static_cast<double>(uGpuNs) / 1000.0 + m_dGpuOffsetUs;
+	}
+
+	FrameTimings& xTimings = a_xSlot.xTimings;
+	xTimings.xFrame.dGpuStartUs = adTimesUs[0];
+	xTimings.xFrame.dGpuUs = adTimesUs[1] - adTimesUs[0];
+	for (unsigned int i = 0; i < xTimings.axPasses.size(); i++)
+	{
+		xTimings.axPasses[i].dGpuStartUs = adTimesUs[2 + i * 2];
+		xTimings.axPasses[i].dGpuUs = adTimesUs[3 + i * 2] - adTimesUs[2 + i * 2];
+	}
+
+	m_xLatest = xTimings;
+	m_axResolved.push_back(xTimings);
+	Release(a_xSlot);
+	return true;
+}
+
+void GpuProfiler::Release(FrameSlot& a_xSlot)
+{
+	m_auFreeQueries.insert(m_auFreeQueries.end(), a_xSlot.auQueries.begin(), a_xSlot.auQueries.end());
+	a_xSlot.auQueries.clear();
+	a_xSlot.bPending = false;
+}
+
+unsigned int GpuProfiler::Timestamp()
+{
+	if (m_auFreeQueries.empty())
+	{
+		GLuint auQueries[uQUERY_BATCH];
+		glGenQueries(uQUERY_BATCH, auQueries);
+		m_auFreeQueries.insert(m_auFreeQueries.end(), auQueries, auQueries + uQUERY_BATCH);
+		m_auAllQueries.insert(m_auAllQueries.end(), auQueries, auQueries + uQUERY_BATCH);
+	}
+
+	unsigned int uQuery = m_auFreeQueries.back();
+	m_auFreeQueries.pop_back();
+	glQueryCounter(uQuery, GL_TIMESTAMP);
+	return uQuery;
+}
+
+double GpuProfiler::NowUs() const
+{
+	return std::chrono::duration<double, std::micro>(Clock::now() - m_xEpoch).count();
+}
@@ -0,0 +1,309 @@
+// This files header
+#include "HeadlessContext.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+#if defined(_WIN32)
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// std includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// constants
+// the most a stored deflate block can hold
+static const unsigned int uPNG_BLOCK_SIZE = 65535;
+
+// constructor
+HeadlessContext::HeadlessContext() : m_pDisplay(nullptr), m_pContext(nullptr), m_uFramebuffer(0), m_uColourBuffer(0), m_uDepthBuffer(0),
+	m_uWidth(0), m_uHeight(0)
+{
+}
+
+// destructor
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+bool HeadlessContext::Create(unsigned int a_uWidth, unsigned int a_uHeight)
+{
+#if defined(_WIN32)
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialise GLFW" << std::endl;
+		return false;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* pWindow = glfwCreateWindow(64, 64, "Headless", NULL, NULL);
+	if (!pWindow)
+	{
+		std::cout << "Failed to create a GL 4.4 context" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	m_pContext = pWindow;
+	glfwMakeContextCurrent(pWindow);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		Destroy();
+		return false;
+	}
+#else
+	// Mesa's surfaceless platform needs no display server, other drivers get their default display
+	EGLDisplay pDisplay = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC pGetPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (pGetPlatformDisplay)
+	{
+		pDisplay = pGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (pDisplay == EGL_NO_DISPLAY)
+	{
+		pDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint iMajor = 0;
+	EGLint iMinor = 0;
+	if (pDisplay == EGL_NO_DISPLAY || !eglInitialize(pDisplay, &iMajor, &iMinor))
+	{
+		std::cout << "Failed to initialise EGL" << std::endl;
+		return false;
+	}
+	m_pDisplay = pDisplay;
+
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint aiConfigAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig pConfig = nullptr;
+	EGLint iConfigCount = 0;
+	eglChooseConfig(pDisplay, aiConfigAttributes, &pConfig, 1, &iConfigCount);
+
+	// nothing is ever drawn to a surface, so the context is made current without one
+	const EGLint aiContextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 4,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+	EGLContext pContext = eglCreateContext(pDisplay, iConfigCount > 0 ? pConfig : nullptr, EGL_NO_CONTEXT, aiContextAttributes);
+	if (pContext == EGL_NO_CONTEXT || !eglMakeCurrent(pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, pContext))
+	{
+		std::cout << "Failed to create a surfaceless GL 4.4 context (EGL error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+		if (pContext != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(pDisplay, pContext);
+		}
+		Destroy();
+		return false;
+	}
+	m_pContext = pContext;
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		Destroy();
+		return false;
+	}
+#endif
+
+	m_uWidth = a_uWidth;
+	m_uHeight = a_uHeight;
+
+	glGenRenderbuffers(1, &m_uColourBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uColourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_uWidth, m_uHeight);
+	glGenRenderbuffers(1, &m_uDepthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uDepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_uWidth, m_uHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_uFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_uColourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_uDepthBuffer);
+	bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!bComplete)
+	{
+		std::cout << "Headless framebuffer is incomplete" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	Bind();
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (m_pContext && m_uFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_uFramebuffer);
+		glDeleteRenderbuffers(1, &m_uColourBuffer);
+		glDeleteRenderbuffers(1, &m_uDepthBuffer);
+	}
+	m_uFramebuffer = 0;
+	m_uColourBuffer = 0;
+	m_uDepthBuffer = 0;
+
+#if defined(_WIN32)
+	if (m_pContext)
+	{
+		glfwDestroyWindow(static_cast<GLFWwindow*>(m_pContext));
+		glfwTerminate();
+	}
+#else
+	if (m_pDisplay)
+	{
+		eglMakeCurrent(m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_pContext)
+		{
+			eglDestroyContext(m_pDisplay, m_pContext);
+		}
+		eglTerminate(m_pDisplay);
+	}
+#endif
+	m_pDisplay = nullptr;
+	m_pContext = nullptr;
+}
+
+void HeadlessContext::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glViewport(0, 0, m_uWidth, m_uHeight);
+}
+
+/// <summary>
+/// GL reads from the bottom row up, so the rows are flipped to match how images are stored
+/// </summary>
+void HeadlessContext::ReadPixels(std::vector<unsigned char>& a_aucPixels) const
+{
+	const size_t uRowBytes = m_uWidth * 4;
+	a_aucPixels.resize(uRowBytes * m_uHeight);
+	if (a_aucPixels.empty())
+	{
+		return; // early out
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_uFramebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_uWidth, m_uHeight, GL_RGBA, GL_UNSIGNED_BYTE, a_aucPixels.data());
+
+	std::vector<unsigned char> aucRow(uRowBytes);
+	for (unsigned int uRow = 0; uRow < m_uHeight / 2; uRow++)
+	{
+		unsigned char* pTop = &a_aucPixels[uRow * uRowBytes];
+		unsigned char* pBottom = &a_aucPixels[(m_uHeight - 1 - uRow) * uRowBytes];
+		std::memcpy(aucRow.data(), pTop, uRowBytes);
+		std::memcpy(pTop, pBottom, uRowBytes);
+		std::memcpy(pBottom, aucRow.data(), uRowBytes);
+	}
+}
+
+/// <summary>
+/// Each row gets a filter byte of 0 (none), and the rows go into a zlib stream of stored deflate blocks
+/// </summary>
+bool HeadlessContext::WritePng(const std::string& a_sPath, unsigned int a_uWidth, unsigned int a_uHeight, const std::vector<unsigned char>& a_aucPixels)
+{
+	const size_t uRowBytes = a_uWidth * 4;
+	if (a_aucPixels.size() < uRowBytes * a_uHeight)
+	{
+		return false;
+	}
+
+	// built the first time a PNG is written
+	static const std::vector<unsigned int> auCrcTable = []()
+	{
+		std::vector<unsigned int> auTable(256);
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int uCrc = i;
+			for (unsigned int uBit = 0; uBit < 8; uBit++)
+			{
+				uCrc = (uCrc & 1) ? 0xEDB88320u ^ (uCrc >> 1) : uCrc >> 1;
+			}
+			auTable[i] = uCrc;
+		}
+		return auTable;
+	}();
+
+	auto xAppend32 = [](std::vector<unsigned char>& a_aucOut, unsigned int a_uValue)
+	{
+		a_aucOut.push_back(static_cast<unsigned char>(a_uValue >> 24));
+		a_aucOut.push_back(static_cast<unsigned char>(a_uValue >> 16));
+		a_aucOut.push_back(static_cast<unsigned char>(a_uValue >> 8));
+		a_aucOut.push_back(static_cast<unsigned char>(a_uValue));
+	};
+	// a chunk is its length, type, data and the CRC of the type and data
+	std::vector<unsigned char> aucFile = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	auto xAppendChunk = [&](const char* a_szType, const std::vector<unsigned char>& a_aucData)
+	{
+		xAppend32(aucFile, static_cast<unsigned int>(a_aucData.size()));
+		size_t uTypeStart = aucFile.size();
+		aucFile.insert(aucFile.end(), a_szType, a_szType + 4);
+		aucFile.insert(aucFile.end(), a_aucData.begin(), a_aucData.end());
+		unsigned int uCrc = 0xFFFFFFFFu;
+		for (size_t i = uTypeStart; i < aucFile.size(); i++)
+		{
+			uCrc = auCrcTable[(uCrc ^ aucFile[i]) & 0xFF] ^ (uCrc >> 8);
+		}
+		xAppend32(aucFile, uCrc ^ 0xFFFFFFFFu);
+	};
+
+	// 8 bit RGBA, no interlacing
+	std::vector<unsigned char> aucHeader;
+	xAppend32(aucHeader, a_uWidth);
+	xAppend32(aucHeader, a_uHeight);
+	aucHeader.insert(aucHeader.end(), { 8, 6, 0, 0, 0 });
+	xAppendChunk("IHDR", aucHeader);
+
+	std::vector<unsigned char> aucRaw;
+	aucRaw.reserve((uRowBytes + 1) * a_uHeight);
+	for (unsigned int uRow = 0; uRow < a_uHeight; uRow++)
+	{
+		aucRaw.push_back(0);
+		aucRaw.insert(aucRaw.end(), a_aucPixels.begin() + uRow * uRowBytes, a_aucPixels.begin() + (uRow + 1) * uRowBytes);
+	}
+
+	std::vector<unsigned char> aucData = { 0x78, 0x01 };
+	unsigned int uAdlerA = 1;
+	unsigned int uAdlerB = 0;
+	for (size_t uStart = 0; uStart < aucRaw.size() || uStart == 0; uStart += uPNG_BLOCK_SIZE)
+	{
+		unsigned int uLength = static_cast<unsigned int>(std::min<size_t>(uPNG_BLOCK_SIZE, aucRaw.size() - uStart));
+		bool bLast = uStart + uLength >= aucRaw.size();
+		aucData.push_back(bLast ? 1 : 0);
+		aucData.push_back(static_cast<unsigned char>(uLength));
+		aucData.push_back(static_cast<unsigned char>(uLength >> 8));
+		aucData.push_back(static_cast<unsigned char>(~uLength));
+		aucData.push_back(static_cast<unsigned char>(~uLength >> 8));
+		for (size_t i = uStart; i < uStart + uLength; i++)
+		{
+			aucData.push_back(aucRaw[i]);
+			uAdlerA = (uAdlerA + aucRaw[i]) % 65521;
+			uAdlerB = (uAdlerB + uAdlerA) % 65521;
+		}
+		if (bLast)
+		{
+			break;
+		}
+	}
+	xAppend32(aucData, (uAdlerB << 16) | uAdlerA);
+	xAppendChunk("IDAT", aucData);
+	xAppendChunk("IEND", std::vector<unsigned char>());
+
+	std::ofstream xFile(a_sPath, std::ios::binary);
+	if (!xFile)
+	{
+		std::cout << "Failed to open " << a_sPath << " for writing" << std::endl;
+		return false;
+	}
+	xFile.write(reinterpret_cast<const char*>(aucFile.data()), aucFile.size());
+	return static_cast<bool>(xFile);
+}
@@ -0,0 +1,374 @@
+// This files header
+#include "ImpostorAtlas.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// LearnOpenGL includes
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+
+// Project Includes
+#include "FrameUniforms.h"
+
+// third party include
+#include <glm/gtc/matrix_transform.hpp>
+
+// std includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// constants
+static const UniformName xBAKE_VIEW_PROJECTION_UNIFORM("bakeViewProjection");
+static const UniformName xFRAMES_UNIFORM("impostorFrames");
+static const UniformName xRADIUS_UNIFORM("impostorRadius");
+static const UniformName xBAKED_ATLAS_UNIFORM("bakedAtlas");
+static const UniformName xSEEDS_UNIFORM("seeds");
+static const UniformName xDILATE_STEP_UNIFORM("dilateStep");
+static const UniformName xFRAME_SIZE_UNIFORM("impostorFrameSize");
+// rows of frames baked by each update, a 16 by 16 atlas bakes over 8 frames and then dilates a pass a frame
+static const unsigned int uBAKE_ROWS_PER_UPDATE = 2;
+
+// constructor
+ImpostorAtlas::ImpostorAtlas(Model* a_pModel, AssetManager* a_pAssetManager, unsigned int a_uFramesPerSide, unsigned int a_uFrameSize) : m_pModel(a_pModel),
+	m_uFramesPerSide(a_uFramesPerSide > 0 ? a_uFramesPerSide : 1), m_uFrameSize(a_uFrameSize > 0 ? a_uFrameSize : 1), m_fRadius(0.0f), m_eState(ATLAS_FAILED),
+	m_uNextRow(0), m_uNextPass(0), m_uBakeTexture(0), m_uBakeDepth(0), m_uFramebuffer(0), m_uVertexArray(0), m_uTexture(0), m_pQuad(nullptr)
+{
+	m_auSeeds[0] = 0;
+	m_auSeeds[1] = 0;
+	if (!a_pModel || a_pModel->meshes.empty() || a_pModel->boundingRadius <= 0.0f)
+	{
+		std::cout << "Impostor atlas needs a loaded model" << std::endl;
+		return;
+	}
+	m_fRadius = a_pModel->boundingRadius;
+
+	m_xShader = a_pAssetManager->LoadShader("shaders/impostor.vs", "shaders/impostor.fs");
+	m_xBakeShader = a_pAssetManager->LoadShader("shaders/impostor_bake.vs", "shaders/impostor_bake.fs");
+	m_xDilateShader = a_pAssetManager->LoadShader("shaders/impostor_dilate.vs", "shaders/impostor_dilate.fs");
+	m_eState = ATLAS_WAITING;
+}
+
+// destructor
+ImpostorAtlas::~ImpostorAtlas()
+{
+	EndBake();
+	delete m_pQuad;
+	if (m_uTexture)
+	{
+		glDeleteTextures(1, &m_uTexture);
+	}
+}
+
+/// <summary>
+/// Everything the bake changes is put back before returning, as the rest of the frame is drawn after it
+/// </summary>
+bool ImpostorAtlas::Update()
+{
+	if (m_eState == ATLAS_WAITING)
+	{
+		const ShaderHandle axShaders[3] = { m_xShader, m_xBakeShader, m_xDilateShader };
+		for (const ShaderHandle& xShader : axShaders)
+		{
+			if (xShader->GetState() == Asset::ASSET_FAILED)
+			{
+				std::cout << "Impostor atlas shader " << xShader->GetPath() << " failed to load" << std::endl;
+				m_eState = ATLAS_FAILED;
+			}
+			else if (!xShader->IsResident() && m_eState == ATLAS_WAITING)
+			{
+				return false; // early out
+			}
+		}
+	}
+	if (m_eState != ATLAS_WAITING && m_eState != ATLAS_BAKING)
+	{
+		return false; // early out
+	}
+
+	GLint aiViewport[4];
+	GLint iFramebuffer = 0;
+	GLfloat afClearColour[4];
+	glGetIntegerv(GL_VIEWPORT, aiViewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &iFramebuffer);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, afClearColour);
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+
+	if (m_eState == ATLAS_WAITING)
+	{
+		m_eState = BeginBake() ? ATLAS_BAKING : ATLAS_FAILED;
+	}
+	if (m_eState == ATLAS_BAKING && m_uNextRow < m_uFramesPerSide)
+	{
+		unsigned int uRowCount = std::min(uBAKE_ROWS_PER_UPDATE, m_uFramesPerSide - m_uNextRow);
+		BakeRows(m_uNextRow, uRowCount);
+		m_uNextRow += uRowCount;
+		if (m_uNextRow == m_uFramesPerSide)
+		{
+			BeginDilation();
+		}
+	}
+	else if (m_eState == ATLAS_BAKING)
+	{
+		DilatePass(m_uNextPass++);
+		if (m_uNextPass == GetDilatePassCount())
+		{
+			FinishBake();
+			EndBake();
+			m_eState = ATLAS_READY;
+		}
+	}
+	if (m_eState == ATLAS_FAILED)
+	{
+		EndBake();
+	}
+
+	// put back everything the bake changed
+	glBindFramebuffer(GL_FRAMEBUFFER, iFramebuffer);
+	glViewport(aiViewport[0], aiViewport[1], aiViewport[2], aiViewport[3]);
+	glClearColor(afClearColour[0], afClearColour[1], afClearColour[2], afClearColour[3]);
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	else
+	{
+		glDisable(GL_DEPTH_TEST);
+	}
+	glUseProgram(0);
+	return m_eState == ATLAS_READY;
+}
+
+/// <summary>
+/// Unfolds a point of the square onto the octahedron |x| + |y| + |z| = 1, with the top half of the sphere in
+/// the middle diamond and the bottom half folded out into the corners, then pushes it out onto the sphere
+/// </summary>
+glm::vec3 ImpostorAtlas::OctahedralDecode(const glm::vec2& a_v2Point)
+{
+	glm::vec2 v2Point = a_v2Point * 2.0f - 1.0f;
+	glm::vec3 v3Direction(v2Point.x, 1.0f - std::abs(v2Point.x) - std::abs(v2Point.y), v2Point.y);
+	if (v3Direction.y < 0.0f)
+	{
+		float fX = (1.0f - std::abs(v3Direction.z)) * (v3Direction.x >= 0.0f ? 1.0f : -1.0f);
+		float fZ = (1.0f - std::abs(v3Direction.x)) * (v3Direction.z >= 0.0f ? 1.0f : -1.0f);
+		v3Direction.x = fX;
+		v3Direction.z = fZ;
+	}
+	return glm::normalize(v3Direction);
+}
+
+/// <summary>
+/// The frames are rendered into a texture of their own, the atlas is only written by the dilation
+/// </summary>
+bool ImpostorAtlas::BeginBake()
+{
+	const unsigned int uAtlasSize = m_uFramesPerSide * m_uFrameSize;
+
+	glGenTextures(1, &m_uBakeTexture);
+	glBindTexture(GL_TEXTURE_2D, m_uBakeTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, uAtlasSize, uAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &m_uFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uBakeTexture, 0);
+	glGenRenderbuffers(1, &m_uBakeDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uBakeDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, uAtlasSize, uAtlasSize);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uBakeDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Impostor atlas framebuffer is incomplete" << std::endl;
+		return false;
+	}
+
+	// clear to nothing, the alpha is what tells the impostor which texels the model covers
+	glViewport(0, 0, uAtlasSize, uAtlasSize);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+/// <summary>
+/// Each frame is an orthographic view of the whole model from the centre of its cell of the atlas. The up
+/// vector matches the one the impostor shader builds its quad from, or the frames would be drawn rotated
+/// </summary>
+void ImpostorAtlas::BakeRows(unsigned int a_uFirstRow, unsigned int a_uRowCount)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glEnable(GL_DEPTH_TEST);
+	Shader* pBakeShader = m_xBakeShader->Get();
+	pBakeShader->use();
+
+	// the camera sits outside the bounding sphere, so the whole model fits between the near and far planes
+	const glm::mat4 m4Projection = glm::ortho(-m_fRadius, m_fRadius, -m_fRadius, m_fRadius, m_fRadius, m_fRadius * 3.0f);
+	for (unsigned int y = a_uFirstRow; y < a_uFirstRow + a_uRowCount; y++)
+	{
+		for (unsigned int x = 0; x < m_uFramesPerSide; x++)
+		{
+			glm::vec3 v3Direction = OctahedralDecode((glm::vec2(x, y) + 0.5f) / static_cast<float>(m_uFramesPerSide));
+			glm::vec3 v3Up = std::abs(v3Direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			glm::mat4 m4View = glm::lookAt(v3Direction * m_fRadius * 2.0f, glm::vec3(0.0f), v3Up);
+
+			glViewport(x * m_uFrameSize, y * m_uFrameSize, m_uFrameSize, m_uFrameSize);
+			pBakeShader->setMat4(xBAKE_VIEW_PROJECTION_UNIFORM, m4Projection * m4View);
+			m_pModel->Draw(*pBakeShader);
+		}
+	}
+}
+
+/// <summary>
+/// The frames are dilated with a jump flood on the GPU, so they never come back to the CPU. Without it the mips
+/// would average the model with the clear colour and leave a dark edge on it
+/// </summary>
+void ImpostorAtlas::BeginDilation()
+{
+	const unsigned int uAtlasSize = m_uFramesPerSide * m_uFrameSize;
+
+	glGenTextures(1, &m_uTexture);
+	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, uAtlasSize, uAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glGenTextures(2, m_auSeeds);
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, m_auSeeds[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, uAtlasSize, uAtlasSize, 0, GL_RG_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the bake's framebuffer is reused, with the seeds and the atlas in place of the baked frames and depth
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_uTexture, 0);
+
+	// the triangle is made in the vertex shader, but a vertex array still has to be bound to draw
+	glGenVertexArrays(1, &m_uVertexArray);
+}
+
+/// <summary>
+/// Each pass looks a step away in every direction for a covered texel nearer than the one each texel has,
+/// halving the step each time, with one more single texel pass to catch what the halving misses
+/// </summary>
+void ImpostorAtlas::DilatePass(unsigned int a_uPass)
+{
+	const unsigned int uAtlasSize = m_uFramesPerSide * m_uFrameSize;
+	const unsigned int uStep = a_uPass == 0 ? 0 : std::max(m_uFrameSize >> a_uPass, 1u);
+	// only the last pass has every texel's nearest seed, so it is the only one that writes the atlas
+	const bool bLast = a_uPass + 1 == GetDilatePassCount();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_auSeeds[a_uPass % 2], 0);
+	const GLenum aeBuffers[2] = { GL_COLOR_ATTACHMENT0, static_cast<GLenum>(bLast ? GL_COLOR_ATTACHMENT1 : GL_NONE) };
+	glDrawBuffers(2, aeBuffers);
+	glDisable(GL_DEPTH_TEST);
+	glViewport(0, 0, uAtlasSize, uAtlasSize);
+
+	Shader* pDilateShader = m_xDilateShader->Get();
+	pDilateShader->use();
+	pDilateShader->setInt(xBAKED_ATLAS_UNIFORM, 0);
+	pDilateShader->setInt(xSEEDS_UNIFORM, 1);
+	pDilateShader->setInt(xFRAME_SIZE_UNIFORM, static_cast<int>(m_uFrameSize));
+	pDilateShader->setInt(xDILATE_STEP_UNIFORM, static_cast<int>(uStep));
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_uBakeTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_auSeeds[(a_uPass + 1) % 2]);
+	glBindVertexArray(m_uVertexArray);
+
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	const GLenum eBuffer = GL_COLOR_ATTACHMENT0;
+	glDrawBuffers(1, &eBuffer);
+}
+
+// the first pass, one for each halving of the frame size and the last single texel one
+unsigned int ImpostorAtlas::GetDilatePassCount() const
+{
+	unsigned int uPassCount = 2;
+	for (unsigned int uStep = m_uFrameSize / 2; uStep > 0; uStep /= 2)
+	{
+		uPassCount++;
+	}
+	return uPassCount;
+}
+
+/// <summary>
+/// The program is shared through the asset manager, so the frame layout is set on it here rather than when
+/// it's drawn. Only one layout can be drawn with it at a time
+/// </summary>
+void ImpostorAtlas::FinishBake()
+{
+	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	Shader* pShader = m_xShader->Get();
+	pShader->bindUniformBlock(szFRAME_UNIFORMS_BLOCK, uFRAME_UNIFORMS_BINDING);
+	pShader->use();
+	pShader->setInt(xFRAMES_UNIFORM, static_cast<int>(m_uFramesPerSide));
+	pShader->setFloat(xRADIUS_UNIFORM, m_fRadius);
+
+	// a unit quad in x and y, the shader turns it to face the frame being drawn and scales it to the model
+	std::vector<Vertex> axVertices(4);
+	const glm::vec2 av2Corners[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		axVertices[i].Position = glm::vec3(av2Corners[i] * 2.0f - 1.0f, 0.0f);
+		axVertices[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+		axVertices[i].TexCoords = av2Corners[i];
+		axVertices[i].Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+		axVertices[i].Bitangent = glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+	std::vector<unsigned int> auIndices = { 0, 1, 2, 0, 2, 3 };
+
+	Texture xAtlas;
+	xAtlas.id = m_uTexture;
+	xAtlas.type = "texture_diffuse";
+	xAtlas.path = "impostor";
+	m_pQuad = new Mesh(axVertices, auIndices, std::vector<Texture>(1, xAtlas));
+}
+
+void ImpostorAtlas::EndBake()
+{
+	if (m_uFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_uFramebuffer);
+		m_uFramebuffer = 0;
+	}
+	if (m_uBakeDepth)
+	{
+		glDeleteRenderbuffers(1, &m_uBakeDepth);
+		m_uBakeDepth = 0;
+	}
+	if (m_uBakeTexture)
+	{
+		glDeleteTextures(1, &m_uBakeTexture);
+		m_uBakeTexture = 0;
+	}
+	if (m_auSeeds[0])
+	{
+		glDeleteTextures(2, m_auSeeds);
+		m_auSeeds[0] = 0;
+		m_auSeeds[1] = 0;
+	}
+	if (m_uVertexArray)
+	{
+		glDeleteVertexArrays(1, &m_uVertexArray);
+		m_uVertexArray = 0;
+	}
+}
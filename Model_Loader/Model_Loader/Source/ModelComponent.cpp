@@ -8,11 +8,16 @@
 // Project Includes
 #include "TransformComponent.h"
 #include "Entity.h"
+#include "RenderQueue.h"
 
 // TypeDef
 typedef Component PARENT;
 
-ModelComponent::ModelComponent(Entity* a_pOwner) : PARENT(a_pOwner), m_pModelData(nullptr), m_fModelScale(0.0f)
+// constants
+// interned once so setting it each draw is a pointer lookup
+static const UniformName xMODEL_UNIFORM("model");
+
+ModelComponent::ModelComponent(Entity* a_pOwner) : PARENT(a_pOwner), m_fModelScale(0.0f)
 {
 
 }
@@ -30,21 +35,56 @@ void ModelComponent::Draw(Shader* a_pShader)
         return; // Early out
     }
 
-    if (!m_pModelData)
+    Model* pModel = GetModel();
+    if (!pModel)
+    {
+        return; // Early Out
+    }
+
+    glm::mat4 m4ModelMatrix;
+    if (!GetModelMatrix(m4ModelMatrix))
+    {
+        return; // Early Out
+    }
+
+    // render the loaded model
+    a_pShader->setMat4(xMODEL_UNIFORM, m4ModelMatrix);
+    pModel->Draw(*a_pShader);
+}
+
+void ModelComponent::Submit(Shader* a_pShader, RenderQueue& a_xQueue) const
+{
+    Model* pModel = GetModel();
+    if (!a_pShader || !pModel)
+    {
+        return; // Early out
+    }
+
+    glm::mat4 m4ModelMatrix;
+    if (!GetModelMatrix(m4ModelMatrix))
     {
         return; // Early Out
     }
 
+    for (Mesh& xMesh : pModel->meshes)
+    {
+        a_xQueue.Submit(a_pShader, &xMesh, m4ModelMatrix);
+    }
+}
+
+/// <summary>
+/// The entity matrix scaled by the model scale
+/// </summary>
+bool ModelComponent::GetModelMatrix(glm::mat4& a_m4ModelMatrix) const
+{
     // get Transform component
     TransformComponent* pTransformComponent = static_cast<TransformComponent*>(m_pOwnerEntity->FindComponentOfType(TRANSFORM));
     if (!pTransformComponent)
     {
-        return; // Early Out
+        return false; // Early Out
     }
 
-    // render the loaded model
-    glm::mat4 m4ModelMatrix = pTransformComponent->GetEntityMatrix();
-    m4ModelMatrix = glm::scale(m4ModelMatrix, glm::vec3(m_fModelScale, m_fModelScale, m_fModelScale));
-    a_pShader->setMat4("model", m4ModelMatrix);
-    m_pModelData->Draw(*a_pShader);
+    a_m4ModelMatrix = pTransformComponent->GetEntityMatrix();
+    a_m4ModelMatrix = glm::scale(a_m4ModelMatrix, glm::vec3(m_fModelScale, m_fModelScale, m_fModelScale));
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+// This files header
+#include "RenderBenchmark.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// GLM includes
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Project includes
+#include "Scene.h"
+#include "HeadlessContext.h"
+
+// std includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// typedefs
+typedef std::chrono::high_resolution_clock Clock;
+
+// constants
+// the camera circles the bounding box once over the measured frames
+static const float fORBIT_RADIUS = 10.0f;
+static const float fORBIT_HEIGHT = 3.0f;
+
+/// <summary>
+/// Options are a name and a value, "--frames 600"
+/// </summary>
+bool RenderBenchmark::ParseArguments(int a_iArgCount, char** a_aszArgs, Options& a_xOptions)
+{
+	for (int i = 0; i < a_iArgCount; i++)
+	{
+		const char* szArg = a_aszArgs[i];
+		if (std::strcmp(szArg, "--serial") == 0)
+		{
+			a_xOptions.bThreadedSimulation = false;
+			continue;
+		}
+
+		const char* szValue = i + 1 < a_iArgCount ? a_aszArgs[i + 1] : nullptr;
+		if (!szValue)
+		{
+			std::cout << "No value given for " << szArg << std::endl;
+			return false;
+		}
+		i++;
+
+		if (std::strcmp(szArg, "--frames") == 0)
+		{
+			a_xOptions.uFrames = static_cast<unsigned int>(std::max(1, std::atoi(szValue)));
+		}
+		else if (std::strcmp(szArg, "--warmup") == 0)
+		{
+			a_xOptions.uWarmupFrames = static_cast<unsigned int>(std::max(0, std::atoi(szValue)));
+		}
+		else if (std::strcmp(szArg, "--boids") == 0)
+		{
+			a_xOptions.iBoids = std::max(1, std::atoi(szValue));
+		}
+		else if (std::strcmp(szArg, "--csv") == 0)
+		{
+			a_xOptions.sCsvPath = szValue;
+		}
+		else if (std::strcmp(szArg, "--png-dir") == 0)
+		{
+			a_xOptions.sPngDirectory = szValue;
+			a_xOptions.uPngInterval = std::max(a_xOptions.uPngInterval, 1u);
+		}
+		else if (std::strcmp(szArg, "--trace") == 0)
+		{
+			a_xOptions.sTracePath = szValue;
+		}
+		else if (std::strcmp(szArg, "--png-interval") == 0)
+		{
+			a_xOptions.uPngInterval = static_cast<unsigned int>(std::max(0, std::atoi(szValue)));
+		}
+		else
+		{
+			std::cout << "Unknown benchmark option " << szArg << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Each frame is timed three ways. Update is the CPU work before drawing (the GPU flock step, the gizmos),
+/// submit is Scene::Render, everything the CPU does to get the frame to GL, and the frame time carries on
+/// through glFinish so it includes the GPU finishing the frame. The GPU time of each frame comes from the
+/// profiler's timestamp queries, so it leaves out the time the GPU sat idle waiting on the CPU
+/// </summary>
+int RenderBenchmark::Run(const Options& a_xOptions)
+{
+	std::ofstream xCsv(a_xOptions.sCsvPath);
+	if (!xCsv)
+	{
+		std::cout << "Failed to open " << a_xOptions.sCsvPath << " for writing" << std::endl;
+		return 1;
+	}
+
+	Scene* pScene = Scene::GetInstance();
+	if (!pScene->Initialise(true))
+	{
+		std::cout << "Failed to set up the headless scene" << std::endl;
+		delete pScene;
+		return 1;
+	}
+	std::cout << "Benchmarking on " << glGetString(GL_RENDERER) << ", " << a_xOptions.iBoids << " boids, "
+		<< (a_xOptions.bThreadedSimulation ? "threaded" : "serial") << " simulation" << std::endl;
+
+	pScene->SetThreadedSimulation(a_xOptions.bThreadedSimulation);
+	pScene->SetBoidCount(a_xOptions.iBoids);
+
+	const HeadlessContext* pContext = pScene->GetHeadlessContext();
+	std::vector<unsigned char> aucPixels;
+	std::vector<float> afFrameMs;
+	afFrameMs.reserve(a_xOptions.uFrames);
+	double dTotalUpdateMs = 0.0;
+	double dTotalSubmitMs = 0.0;
+	double dTotalFrameMs = 0.0;
+	unsigned long long uTotalDrawCalls = 0;
+
+	xCsv << "frame,update_ms,submit_ms,frame_ms,draw_calls,boids,visible_boids,sim_step_ms,gpu_ms\n";
+	const unsigned int uTotalFrames = a_xOptions.uWarmupFrames + a_xOptions.uFrames;
+	for (unsigned int uFrame = 0; uFrame < uTotalFrames; uFrame++)
+	{
+		float fAngle = glm::two_pi<float>() * static_cast<float>(uFrame) / static_cast<float>(a_xOptions.uFrames);
+		pScene->SetCamera(glm::vec3(std::sin(fAngle) * fORBIT_RADIUS, fORBIT_HEIGHT, std::cos(fAngle) * fORBIT_RADIUS), glm::vec3(0.0f));
+
+		if (uFrame == a_xOptions.uWarmupFrames && !a_xOptions.sTracePath.empty())
+		{
+			pScene->StartTrace(a_xOptions.sTracePath, a_xOptions.uFrames);
+		}
+
+		Clock::time_point xStart = Clock::now();
+		pScene->Update();
+		Clock::time_point xUpdated = Clock::now();
+		pScene->Render();
+		Clock::time_point xSubmitted = Clock::now();
+		glFinish();
+		Clock::time_point xFinished = Clock::now();
+
+		if (uFrame < a_xOptions.uWarmupFrames)
+		{
+			continue;
+		}
+
+		unsigned int uMeasured = uFrame - a_xOptions.uWarmupFrames;
+		float fUpdateMs = std::chrono::duration<float, std::milli>(xUpdated - xStart).count();
+		float fSubmitMs = std::chrono::duration<float, std::milli>(xSubmitted - xUpdated).count();
+		float fFrameMs = std::chrono::duration<float, std::milli>(xFinished - xStart).count();
+		xCsv << uMeasured << ',' << fUpdateMs << ',' << fSubmitMs << ',' << fFrameMs << ',' << pScene->GetDrawCallCount() << ','
+			<< pScene->GetBoidCount() << ',' << pScene->GetVisibleBoidCount() << ',' << pScene->GetSimulationStepMs() << ','
+			<< pScene->GetGpuFrameMs() << '\n';
+
+		afFrameMs.push_back(fFrameMs);
+		dTotalUpdateMs += fUpdateMs;
+		dTotalSubmitMs += fSubmitMs;
+		dTotalFrameMs += fFrameMs;
+		uTotalDrawCalls += pScene->GetDrawCallCount();
+
+		if (!a_xOptions.sPngDirectory.empty() && a_xOptions.uPngInterval > 0 && uMeasured % a_xOptions.uPngInterval == 0)
+		{
+			char szName[32];
+			std::snprintf(szName, sizeof(szName), "/frame_%05u.png", uMeasured);
+			pContext->ReadPixels(aucPixels);
+			HeadlessContext::WritePng(a_xOptions.sPngDirectory + szName, pContext->GetWidth(), pContext->GetHeight(), aucPixels);
+		}
+	}
+
+	pScene->Deinitialise();
+	delete pScene;
+
+	// the 99th percentile shows the hitches the average hides
+	std::sort(afFrameMs.begin(), afFrameMs.end());
+	const double dFrames = static_cast<double>(afFrameMs.size());
+	float fP99 = afFrameMs[std::min(afFrameMs.size() - 1, static_cast<size_t>(dFrames * 0.99))];
+	std::cout << "Frames: " << afFrameMs.size() << ", average update " << dTotalUpdateMs / dFrames << " ms, submit " << dTotalSubmitMs / dFrames
+		<< " ms, frame " << dTotalFrameMs / dFrames << " ms (99th percentile " << fP99 << " ms), " << uTotalDrawCalls / afFrameMs.size()
+		<< " draw calls" << std::endl;
+	std::cout << "Per frame timings written to " << a_xOptions.sCsvPath << std::endl;
+	return 0;
+}
@@ -0,0 +1,172 @@
+// This files header
+#include "RenderQueue.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// LearnOpenGL includes
+#include <learnopengl/shader.h>
+#include <learnopengl/mesh.h>
+
+// std includes
+#include <algorithm>
+
+// constants
+// bits of the sort key given to each part, the program is the most significant
+static const unsigned int uMATERIAL_BITS = 24;
+static const unsigned int uVERTEX_ARRAY_BITS = 24;
+static const unsigned long long uMATERIAL_MASK = (1ull << uMATERIAL_BITS) - 1;
+static const unsigned long long uVERTEX_ARRAY_MASK = (1ull << uVERTEX_ARRAY_BITS) - 1;
+static const unsigned int uNO_MATERIAL = ~0u;
+// the model shaders uniforms
+static const UniformName xMODEL_UNIFORM("model");
+static const UniformName xINSTANCED_UNIFORM("instanced");
+
+// constructor
+RenderQueue::RenderQueue() : m_uDrawCallCount(0)
+{
+}
+
+void RenderQueue::BeginFrame()
+{
+	m_xState.Invalidate();
+	m_xState.ResetCounts();
+	m_uDrawCallCount = 0;
+}
+
+unsigned int RenderQueue::GetMaterialId(const Mesh* a_pMesh)
+{
+	m_auTextures.clear();
+	for (const Texture& xTexture : a_pMesh->textures)
+	{
+		m_auTextures.push_back(xTexture.id);
+	}
+
+	std::map<std::vector<unsigned int>, unsigned int>::const_iterator xFound = m_xMaterialIds.find(m_auTextures);
+	if (xFound != m_xMaterialIds.end())
+	{
+		return xFound->second;
+	}
+
+	// first time these textures have been queued this flush
+	unsigned int uMaterialId = static_cast<unsigned int>(m_xMaterialIds.size());
+	m_xMaterialIds.insert(std::make_pair(m_auTextures, uMaterialId));
+	return uMaterialId;
+}
+
+unsigned long long RenderQueue::MakeSortKey(const Shader* a_pShader, const Mesh* a_pMesh)
+{
+	unsigned long long uProgram = a_pShader->ID;
+	unsigned long long uMaterial = GetMaterialId(a_pMesh) & uMATERIAL_MASK;
+	unsigned long long uVertexArray = a_pMesh->VAO & uVERTEX_ARRAY_MASK;
+	return (uProgram << (uMATERIAL_BITS + uVERTEX_ARRAY_BITS)) | (uMaterial << uVERTEX_ARRAY_BITS) | uVertexArray;
+}
+
+void RenderQueue::Submit(Shader* a_pShader, Mesh* a_pMesh, const glm::mat4& a_m4Model)
+{
+	if (!a_pShader || !a_pMesh)
+	{
+		return; // early out
+	}
+
+	DrawItem xItem = { a_pShader, a_pMesh, a_m4Model, 0, 0, 0, 0 };
+	m_axOrder.push_back(std::make_pair(MakeSortKey(a_pShader, a_pMesh), static_cast<unsigned int>(m_axItems.size())));
+	m_axItems.push_back(xItem);
+}
+
+void RenderQueue::SubmitInstanced(Shader* a_pShader, Mesh* a_pMesh, unsigned int a_uInstanceBuffer, unsigned int a_uInstanceCount, unsigned int a_uBaseInstance, unsigned int a_uLod)
+{
+	if (!a_pShader || !a_pMesh || a_uInstanceCount == 0)
+	{
+		return; // early out
+	}
+
+	DrawItem xItem = { a_pShader, a_pMesh, glm::mat4(1.0f), a_uInstanceBuffer, a_uInstanceCount, a_uBaseInstance, a_uLod };
+	m_axOrder.push_back(std::make_pair(MakeSortKey(a_pShader, a_pMesh), static_cast<unsigned int>(m_axItems.size())));
+	m_axItems.push_back(xItem);
+}
+
+/// <summary>
+/// Walks the queue in key order. Textures and samplers are only set when the material changes, and
+/// the program, vertex array and texture binds are skipped by the render state when they match
+/// </summary>
+void RenderQueue::Flush()
+{
+	// the index breaks ties so draws with the same key keep the order they were submitted in
+	std::sort(m_axOrder.begin(), m_axOrder.end());
+
+	const Shader* pLastShader = nullptr;
+	const Mesh* pLastMesh = nullptr;
+	unsigned int uLastMaterial = uNO_MATERIAL;
+	// -1 until the instanced uniform has been set on the current program
+	int iLastInstanced = -1;
+
+	for (const std::pair<unsigned long long, unsigned int>& xEntry : m_axOrder)
+	{
+		const DrawItem& xItem = m_axItems[xEntry.second];
+		Mesh* pMesh = xItem.pMesh;
+
+		m_xState.UseProgram(xItem.pShader->ID);
+		if (xItem.pShader != pLastShader)
+		{
+			// uniforms belong to the program, so anything set on the last one has to be set again
+			pLastShader = xItem.pShader;
+			pLastMesh = nullptr;
+			uLastMaterial = uNO_MATERIAL;
+			iLastInstanced = -1;
+		}
+
+		unsigned int uMaterial = static_cast<unsigned int>((xEntry.first >> uVERTEX_ARRAY_BITS) & uMATERIAL_MASK);
+		if (uMaterial != uLastMaterial)
+		{
+			uLastMaterial = uMaterial;
+			const std::vector<UniformName>& axSamplers = pMesh->getSamplerNames();
+			for (unsigned int i = 0; i < pMesh->textures.size(); i++)
+			{
+				m_xState.BindTexture2D(i, pMesh->textures[i].id);
+				xItem.pShader->setInt(axSamplers[i], i);
+			}
+		}
+
+		int iInstanced = xItem.uInstanceCount > 0 ? 1 : 0;
+		if (iInstanced != iLastInstanced)
+		{
+			xItem.pShader->setBool(xINSTANCED_UNIFORM, iInstanced != 0);
+			iLastInstanced = iInstanced;
+		}
+
+		// every level of detail lives in the same element buffer, so picking one is just a different range
+		GLsizei iIndexCount = static_cast<GLsizei>(pMesh->getLodIndexCount(xItem.uLod));
+		const void* pIndexOffset = reinterpret_cast<const void*>(pMesh->getLodIndexOffset(xItem.uLod));
+
+		// packed meshes each have their own position bounds
+		if (pMesh != pLastMesh)
+		{
+			xItem.pShader->setVec4(Mesh::meshBoundsName(), pMesh->getPositionBounds());
+			pLastMesh = pMesh;
+		}
+
+		m_xState.BindVertexArray(pMesh->VAO);
+		if (iInstanced)
+		{
+			pMesh->useInstanceBuffer(xItem.uInstanceBuffer);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, iIndexCount, GL_UNSIGNED_INT, pIndexOffset, xItem.uInstanceCount, xItem.uBaseInstance);
+		}
+		else
+		{
+			xItem.pShader->setMat4(xMODEL_UNIFORM, xItem.m4Model);
+			glDrawElements(GL_TRIANGLES, iIndexCount, GL_UNSIGNED_INT, pIndexOffset);
+		}
+		m_uDrawCallCount++;
+	}
+
+	// leave no vertex array bound, so nothing drawn after the queue can change one by accident
+	if (!m_axOrder.empty())
+	{
+		m_xState.BindVertexArray(0);
+	}
+
+	m_axItems.clear();
+	m_axOrder.clear();
+	m_xMaterialIds.clear();
+}
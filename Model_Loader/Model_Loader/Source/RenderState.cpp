@@ -0,0 +1,85 @@
+// This files header
+#include "RenderState.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// constants
+static const unsigned int uUNKNOWN = ~0u;
+
+// constructor
+RenderState::RenderState()
+{
+	Invalidate();
+	ResetCounts();
+}
+
+void RenderState::UseProgram(unsigned int a_uProgram)
+{
+	if (m_uProgram == a_uProgram)
+	{
+		m_xCounts.uSkippedChanges++;
+		return; // early out
+	}
+
+	glUseProgram(a_uProgram);
+	m_uProgram = a_uProgram;
+	m_xCounts.uProgramChanges++;
+}
+
+void RenderState::BindVertexArray(unsigned int a_uVertexArray)
+{
+	if (m_uVertexArray == a_uVertexArray)
+	{
+		m_xCounts.uSkippedChanges++;
+		return; // early out
+	}
+
+	glBindVertexArray(a_uVertexArray);
+	m_uVertexArray = a_uVertexArray;
+	m_xCounts.uVertexArrayChanges++;
+}
+
+/// <summary>
+/// Binds a texture to a unit, only switching the active unit when the bind actually has to happen
+/// </summary>
+void RenderState::BindTexture2D(unsigned int a_uUnit, unsigned int a_uTexture)
+{
+	bool bTracked = a_uUnit < uTRACKED_TEXTURE_UNITS;
+	if (bTracked && m_auTextures[a_uUnit] == a_uTexture)
+	{
+		m_xCounts.uSkippedChanges++;
+		return; // early out
+	}
+
+	if (m_uActiveUnit != a_uUnit)
+	{
+		glActiveTexture(GL_TEXTURE0 + a_uUnit);
+		m_uActiveUnit = a_uUnit;
+	}
+	glBindTexture(GL_TEXTURE_2D, a_uTexture);
+	if (bTracked)
+	{
+		m_auTextures[a_uUnit] = a_uTexture;
+	}
+	m_xCounts.uTextureChanges++;
+}
+
+void RenderState::Invalidate()
+{
+	m_uProgram = uUNKNOWN;
+	m_uVertexArray = uUNKNOWN;
+	m_uActiveUnit = uUNKNOWN;
+	for (unsigned int i = 0; i < uTRACKED_TEXTURE_UNITS; i++)
+	{
+		m_auTextures[i] = uUNKNOWN;
+	}
+}
+
+void RenderState::ResetCounts()
+{
+	m_xCounts.uProgramChanges = 0;
+	m_xCounts.uVertexArrayChanges = 0;
+	m_xCounts.uTextureChanges = 0;
+	m_xCounts.uSkippedChanges = 0;
+}
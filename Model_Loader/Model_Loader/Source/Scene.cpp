@@ -21,6 +21,21 @@
 #include "ModelComponent.h"
 #include "BrainComponent.h"
 #include "Gizmos.h"
+#include "ThreadPool.h"
+#include "SystemScheduler.h"
+#include "BoidSystems.h"
+#include "CommandBuffer.h"
+#include "BoidRenderer.h"
+#include "StreamingBuffer.h"
+#include "FrameUniforms.h"
+#include "RenderQueue.h"
+#include "GpuFlock.h"
+#include "ImpostorAtlas.h"
+#include "FlockDebugDraw.h"
+#include "HeadlessContext.h"
+#include "GpuProfiler.h"
+#include "TraceRecorder.h"
+#include "AssetManager.h"
 
 // IMGUI include
 #include <imgui/imgui.h>
@@ -28,6 +43,8 @@
 #include <imgui/backends/imgui_impl_glfw.h>
 
 // Std includes
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 
 
@@ -35,7 +52,24 @@
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 800;
 int NUM_OF_BOIDS = 100;
-const unsigned int NUM_OF_BOID_GROUPS = 50;
+const int NUM_OF_BOID_GROUPS = 50;
+const float BOID_MODEL_SCALE = 0.01f;
+// the model the boids start with, and the size of the octahedron they are drawn as while a model loads, in model units
+const char* const BOID_MODEL_PATH = "models/fish/Guppy.obj";
+const float BOID_PLACEHOLDER_RADIUS = 40.0f;
+// what the loaded models and shaders may take between memory and the GPU before loads are held back
+const size_t ASSET_MEMORY_BUDGET = 256 * 1024 * 1024;
+// the fraction of the triangles kept by each of the boid model's simplified levels of detail
+const std::vector<float> BOID_LOD_RATIOS = { 0.5f, 0.25f, 0.1f };
+// how far past the impostor distance the meshes take to fade out
+const float IMPOSTOR_FADE_BAND = 2.0f;
+// edits from the panels waiting on the simulation thread, only a few are ever sent a frame
+const unsigned int SIM_COMMAND_CAPACITY = 64;
+// a headless scene has no clock to follow, so every frame is the same length
+const float HEADLESS_DELTA_TIME = 1.0f / 60.0f;
+// how many frames the trace button records, and where it writes them
+const unsigned int TRACE_FRAMES = 300;
+const char* const TRACE_PATH = "trace.json";
 
 glm::vec3 boxPos = glm::vec3(0);
 
@@ -56,12 +90,24 @@ Scene* Scene::GetInstance()
 }
 
 // constructor
-Scene::Scene() : m_window(nullptr), m_camera(nullptr), m_lastX(SCR_WIDTH / 2.0f), m_lastY(SCR_HEIGHT / 2.0f), m_firstMouse(true), m_deltaTime(0.0f), m_lastFrame(0.0f)
+Scene::Scene() : m_window(nullptr), m_pHeadlessContext(nullptr), m_camera(nullptr), m_pAssetManager(nullptr), m_pScheduler(nullptr), m_pForceSystem(nullptr), m_pMovementSystem(nullptr), m_pPlanarSystem(nullptr), m_pGizmoSystem(nullptr), m_xSimCommands(SIM_COMMAND_CAPACITY), m_pGpuFlock(nullptr), m_pBoidRenderer(nullptr), m_pImpostorAtlas(nullptr), m_pImpostorModel(nullptr), m_pFlockDebugDraw(nullptr), m_pFrameUniforms(nullptr), m_pRenderQueue(nullptr), m_pGpuProfiler(nullptr), m_pTraceRecorder(nullptr), m_lastX(SCR_WIDTH / 2.0f), m_lastY(SCR_HEIGHT / 2.0f), m_firstMouse(true), m_deltaTime(0.0f), m_lastFrame(0.0f)
 {
+    std::snprintf(m_szModelPath, sizeof(m_szModelPath), "%s", BOID_MODEL_PATH);
 }
 
-bool Scene::Initialise() 
+bool Scene::Initialise(bool a_bHeadless)
 {
+    if (a_bHeadless)
+    {
+        m_pHeadlessContext = new HeadlessContext();
+        if (!m_pHeadlessContext->Create(SCR_WIDTH, SCR_HEIGHT))
+        {
+            return false;
+        }
+        glEnable(GL_DEPTH_TEST);
+        return InitialiseScene();
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -108,166 +154,277 @@ bool Scene::Initialise()
     ImGui_ImplGlfw_InitForOpenGL(m_window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
+    return InitialiseScene();
+}
 
+/// <summary>
+/// Everything after the context, the same for a window or headless
+/// </summary>
+bool Scene::InitialiseScene()
+{
     // build and compile shaders
     // -------------------------
-    m_shader = new Shader("shaders/model_loading.vs", "shaders/model_loading.fs");
+    m_pAssetManager = new AssetManager(ASSET_MEMORY_BUDGET);
+    m_xShader = m_pAssetManager->LoadShader("shaders/model_loading.vs", "shaders/model_loading.fs");
+    // the model is laid out for what the shader reads, so nothing can start without it
+    m_pAssetManager->Wait(m_xShader);
+    if (!m_xShader->IsResident())
+    {
+        return false;
+    }
+    m_pFrameUniforms = new FrameUniforms();
+    if (!m_xShader->Get()->bindUniformBlock(szFRAME_UNIFORMS_BLOCK, uFRAME_UNIFORMS_BINDING))
+    {
+        std::cout << "Model shader has no " << szFRAME_UNIFORMS_BLOCK << " block" << std::endl;
+    }
 
     // load models
     // -----------
-    m_model = new Model("models/fish/Guppy.obj");
+    // the boids draw a placeholder until the model has loaded, far away ones are drawn as billboards baked
+    // from it once it has
+    SwapBoidModel(BOID_MODEL_PATH);
+    m_xSimModel = m_xModel;
+    // a headless run is timing the model, not the placeholder
+    if (!m_window)
+    {
+        m_pAssetManager->Wait(m_xModel);
+    }
+    m_pBoidRenderer = new BoidRenderer();
+    m_pRenderQueue = new RenderQueue();
+    m_pGpuProfiler = new GpuProfiler();
+    m_pTraceRecorder = new TraceRecorder();
 
     // Camera
     m_camera = new Camera(glm::vec3(0.0f, 1.0f, 10.0f));
 
-    //---------- Creating Entity and adding components--------------\\
-
-    // seed the random
-    srand(time(nullptr));
+    // set up the systems run each frame, in the order they would run if they all conflicted
+    m_pScheduler = new SystemScheduler(ThreadPool::GetInstance());
+    m_pForceSystem = new BoidForceSystem();
+    m_pMovementSystem = new BoidMovementSystem();
+    m_pPlanarSystem = new PlanarFlockSystem();
+    m_pGizmoSystem = new SceneGizmoSystem();
+    m_pScheduler->AddSystem(m_pForceSystem);
+    m_pScheduler->AddSystem(m_pMovementSystem);
+    m_pScheduler->AddSystem(m_pPlanarSystem);
 
     // set the value of num boids
     numBoids = NUM_OF_BOIDS;
 
-    // Create entities
-    for (int i = 0; i < NUM_OF_BOIDS; i++)
-    {
-        Entity* pEntity = new Entity();
+    // the simulation starts with what the panels show, after this it only hears about changes
+    m_xSentSettings = GetPanelSettings();
+    ApplySettings(m_xSentSettings);
 
-        // Transform Component
-        TransformComponent* pTransformComponent = new TransformComponent(pEntity);
-        pTransformComponent->SetEntityMatrixRow(POSITION_VECTOR, glm::vec3( RandomFloatBetweenRange(-2, 2),
-                                                                            RandomFloatBetweenRange(-2, 2),
-                                                                            RandomFloatBetweenRange(-2, 2)));
-        pEntity->AddComponent(pTransformComponent);
+    // the compute shader flock, only offered if its shaders build
+    m_pGpuFlock = new GpuFlock();
+    // the debug drawing shows the neighbourhood the flocks use
+    m_pFlockDebugDraw = new FlockDebugDraw();
+    m_pFlockDebugDraw->SetNeighbourhoodRadius(FlockSettings().fNeighbourhoodRadius);
 
-        // Model Component
-        ModelComponent* pModelComponent = new ModelComponent(pEntity);
-        pModelComponent->SetModel(m_model);
-        pModelComponent->SetScale(0.01f);
-        pEntity->AddComponent(pModelComponent);
+    //---------- Creating Entity and adding components--------------\\
 
-        // Brain COmponent
-        BrainComponent* pBrainComponent = new BrainComponent(pEntity);
-        pEntity->AddComponent(pBrainComponent);
+    // seed the random
+    srand(time(nullptr));
 
+    // Create entities
+    for (int i = 0; i < NUM_OF_BOIDS; i++)
+    {
+        SetupBoid(new Entity());
     }
 
-    // do initial update of values for the boids
-    UpdateBoidWeights();
-    UpdateBoidNumber();
-
     m_boundingBoxSize = 4.0f;
 
     // create instance of gizmos
     Gizmos::create();
 
+    // the first snapshot, so there is something to draw before the simulation thread publishes
+    StepSimulation(0.0f);
+    if (m_bThreadedSimulation)
+    {
+        StartSimulationThread();
+    }
+
 	return true;
 }
 
 bool Scene::Update()
 {
-    // start imgui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
-
-    // Imgui window
-    showFrameData(true);
-    changeBehaviourWeights(true);
+    if (m_window)
+    {
+        // start imgui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        // Imgui window, any edits are sent to the simulation
+        showFrameData(true);
+        changeBehaviourWeights(true);
+    }
 
     // per-frame time logic
     // --------------------
-    float currentFrame = glfwGetTime();
+    float currentFrame = m_window ? static_cast<float>(glfwGetTime()) : m_lastFrame + HEADLESS_DELTA_TIME;
     m_deltaTime = currentFrame - m_lastFrame;
     m_lastFrame = currentFrame;
 
     // input
     // -----
-    m_camera->processInput(m_window, m_deltaTime);
-
-    // update the values for the boids
-    UpdateBoidWeights();
-    UpdateBoidNumber();
+    if (m_window)
+    {
+        m_camera->processInput(m_window, m_deltaTime);
+    }
 
-    // Update Entities
-    // Entities are processed in groups so that they are not all processed at once
-    // this makes it less intensive on processing so performs faster
-    m_iSizeOfGroup = NUM_OF_BOIDS / NUM_OF_BOID_GROUPS;
+    // the simulation thread steps while this frame is drawn from the last step it finished, so a frame
+    // takes as long as the slower of the two rather than both
+    if (m_bThreadedSimulation)
+    {
+        {
+            std::lock_guard<std::mutex> xLock(m_xTickMutex);
+            m_uTicks++;
+            m_fTickDeltaTime += m_deltaTime;
+        }
+        m_xTickCondition.notify_one();
+    }
+    else
+    {
+        StepSimulation(m_deltaTime);
+    }
+    m_xSnapshots.Acquire();
+    const BoidSnapshot& xSnapshot = m_xSnapshots.GetReadBuffer();
 
-    if (m_iSizeOfGroup == 0) m_iSizeOfGroup++;
+    // at most one finished load is uploaded a frame, so a load never hitches more than that
+    m_pAssetManager->Update();
+    UpdateBoidModel(xSnapshot);
 
-    m_iCurrentGroupNum++;
-    if (m_iCurrentGroupNum > NUM_OF_BOID_GROUPS)
+    if (m_window)
     {
-        m_iCurrentGroupNum = 1;
+        m_pScheduler->ShowDebugWindow(&m_bShowSystemGraph);
     }
 
-    std::map<const unsigned int, Entity*>::const_iterator xIter;
-    for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++)
+    m_pGizmoSystem->SetBoxPosition(boxPos);
+    m_pGizmoSystem->Update(m_deltaTime, m_boundingBoxSize);
+
+    if (m_bGpuFlock)
     {
-        Entity* pEntity = xIter->second;
-        if (pEntity)
+        // boids added or removed since the last step are picked up from the snapshot again
+        if (xSnapshot.auEntityIDs != m_auGpuEntityIDs)
         {
-            if (pEntity->GetEntityID() + 1 > ((m_iCurrentGroupNum * m_iSizeOfGroup) - m_iSizeOfGroup) && 
-                pEntity->GetEntityID() + 1 <= (m_iCurrentGroupNum * m_iSizeOfGroup))
-            {
-                BrainComponent* pBrainComp = static_cast<BrainComponent*>(pEntity->FindComponentOfType(BRAIN));
-                // process the forces in groups for the boids
-                pBrainComp->UpdateForces(m_deltaTime);
-            }
-            // other update functions are called for all of the boids each frame rather than just the groups
-            pEntity->Update(m_deltaTime, m_boundingBoxSize);
+            StartGpuFlock(xSnapshot);
         }
-    }
 
-    Gizmos::clear();
-    // create the bounding box
-    Gizmos::addBox(glm::vec3(0), glm::vec3(m_boundingBoxSize), false, glm::vec4(1, 0, 0, 1));
-    // create the box that the boids avoid
-    Gizmos::addBox(glm::vec3(boxPos), glm::vec3(0.25f), true, glm::vec4(1, 0, 0, 1));
+        FlockSettings xSettings;
+        xSettings.xWeights = GetPanelSettings().xWeights;
+        xSettings.fBoundsSize = m_boundingBoxSize;
+        xSettings.v3Obstacle = boxPos;
+        m_pGpuFlock->Step(m_deltaTime, xSettings, BOID_MODEL_SCALE);
+    }
 
     // return whether to close or not
-	return glfwWindowShouldClose(m_window);
+	return m_window && glfwWindowShouldClose(m_window);
 }
 
 void Scene::Render()
 {
     // render
     // ------
+    if (m_pHeadlessContext)
+    {
+        m_pHeadlessContext->Bind();
+    }
     glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (m_model == nullptr || m_shader == nullptr)
+    Shader* pShader = m_xShader ? m_xShader->Get() : nullptr;
+    if (!m_xModel || pShader == nullptr)
     {
         return; // early out
     }
 
-    // don't forget to enable shader before setting uniforms
-    m_shader->use();
+    // frames come back from the GPU a few frames after they were drawn, the trace takes them as they arrive
+    m_pGpuProfiler->BeginFrame();
+    for (const GpuProfiler::FrameTimings& xFrame : m_pGpuProfiler->GetResolvedFrames())
+    {
+        m_pTraceRecorder->AddFrame(xFrame);
+    }
 
     // view/projection transformations
     glm::mat4 projection = glm::perspective(glm::radians(m_camera->Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
     glm::mat4 view = m_camera->GetViewMatrix();
-    m_shader->setMat4("projection", projection);
-    m_shader->setMat4("view", view);
+    // the GPU flock is still drawn after it is switched off, until the simulation has its boids back
+    const BoidSnapshot& xSnapshot = m_xSnapshots.GetReadBuffer();
+    bool bGpuFlock = m_bGpuFlock || xSnapshot.bGpuFlock;
+    // only the boid renderer draws impostors, so every other path leaves the meshes unfaded
+    bool bImpostors = m_bImpostors && m_bInstancedRendering && !bGpuFlock && m_pImpostorAtlas && m_pImpostorAtlas->IsValid();
+    float fImpostorFadeEnd = bImpostors ? m_fImpostorDistance + IMPOSTOR_FADE_BAND : 0.0f;
+    m_pFrameUniforms->SetImpostorFade(m_fImpostorDistance, fImpostorFadeEnd);
+    m_pFrameUniforms->Update(view, projection);
 
     // Render Enities
-    std::map<const unsigned int, Entity*>::const_iterator xIter;
-    for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++)
+    m_pGpuProfiler->BeginPass("Boids");
+    m_pRenderQueue->BeginFrame();
+    if (bGpuFlock)
     {
-        Entity* pEntity = xIter->second;
-        if (pEntity)
+        // the compute shaders wrote the model matrices, so the flock is drawn without coming back to the CPU
+        for (Mesh& xMesh : m_xModel->Get()->meshes)
         {
-            pEntity->Draw(m_shader);
+            m_pRenderQueue->SubmitInstanced(pShader, &xMesh, m_pGpuFlock->GetInstanceBuffer(), m_pGpuFlock->GetCount(), 0);
         }
     }
+    else if (m_bInstancedRendering)
+    {
+        // every boid in one draw per mesh
+        m_pBoidRenderer->SetCulling(m_bFrustumCulling);
+        m_pBoidRenderer->SetParallelCulling(m_bParallelCulling);
+        m_pBoidRenderer->SetLodSelection(m_bLodSelection);
+        m_pBoidRenderer->SetImpostorFade(m_fImpostorDistance, fImpostorFadeEnd);
+        m_pBoidRenderer->Gather(xSnapshot);
+        m_pBoidRenderer->Submit(pShader, *m_pRenderQueue, view, projection);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < xSnapshot.GetBoidCount(); i++)
+        {
+            if (!xSnapshot.apModels[i])
+            {
+                continue;
+            }
+            for (Mesh& xMesh : xSnapshot.apModels[i]->meshes)
+            {
+                m_pRenderQueue->Submit(pShader, &xMesh, xSnapshot.am4Models[i]);
+            }
+        }
+    }
+    m_pRenderQueue->Flush();
+    m_pBoidRenderer->EndFrame();
+
+    m_pGpuProfiler->BeginPass("Debug Draw");
+    // what is steering the boids, read straight from the storage buffers when the GPU is running the flock
+    unsigned int uShow = (m_bShowVelocities ? FlockDebugDraw::SHOW_VELOCITY : 0) | (m_bShowNeighbourhoods ? FlockDebugDraw::SHOW_NEIGHBOURHOOD : 0) |
+        (m_bShowForces ? FlockDebugDraw::SHOW_FORCES : 0);
+    if (bGpuFlock)
+    {
+        m_pFlockDebugDraw->Draw(*m_pGpuFlock, uShow);
+    }
+    else
+    {
+        m_pFlockDebugDraw->Draw(xSnapshot, uShow);
+    }
+    m_pFlockDebugDraw->EndFrame();
 
     // render the gizmos items (bounding box and box to avoid)
-    Gizmos::draw(view, projection);
+    m_pGpuProfiler->BeginPass("Gizmos");
+    Gizmos::draw();
+
+    if (!m_window)
+    {
+        m_pGpuProfiler->EndFrame();
+        return; // nothing to present
+    }
 
     // renders the ImGui frames
+    m_pGpuProfiler->BeginPass("ImGui");
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    m_pGpuProfiler->EndFrame();
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
     // -------------------------------------------------------------------------------
@@ -277,10 +434,27 @@ void Scene::Render()
 
 void Scene::Deinitialise()
 {
+    // the simulation has to stop before anything it uses is deleted
+    StopSimulationThread();
+
     // delete the values of items in the scene
+    delete m_pScheduler;
+    delete m_pGizmoSystem;
+    ThreadPool::DestroyInstance();
+    delete m_pBoidRenderer;
+    delete m_pImpostorAtlas;
+    delete m_pFlockDebugDraw;
+    delete m_pFrameUniforms;
+    delete m_pRenderQueue;
+    // a trace still recording keeps what it has
+    if (m_pTraceRecorder)
+    {
+        m_pTraceRecorder->Stop();
+    }
+    delete m_pTraceRecorder;
+    delete m_pGpuProfiler;
+    delete m_pGpuFlock;
     delete m_camera;
-    delete m_shader;
-    delete m_model;
 
     // remove all entities from memory
     std::map<const unsigned int, Entity*>::const_iterator xIter;
@@ -290,9 +464,23 @@ void Scene::Deinitialise()
         delete pEntity;
     }
 
+    // the boids held the model too, so with them gone the assets can go
+    m_xShader.reset();
+    m_xModel.reset();
+    m_xSimModel.reset();
+    m_axRetiredModels.clear();
+    delete m_pAssetManager;
+
     // clear the gizmos
     Gizmos::destroy();
 
+    if (m_pHeadlessContext)
+    {
+        delete m_pHeadlessContext;
+        m_pHeadlessContext = nullptr;
+        return; // no window or ImGui to close
+    }
+
     // Clean up IMGUI
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -303,6 +491,344 @@ void Scene::Deinitialise()
     glfwTerminate();
 }
 
+void Scene::SetCamera(const glm::vec3& a_v3Position, const glm::vec3& a_v3Target)
+{
+    m_camera->LookAt(a_v3Position, a_v3Target);
+}
+
+/// <summary>
+/// Goes to the simulation like a change on the slider would, so the boids appear after its next step
+/// </summary>
+void Scene::SetBoidCount(int a_iCount)
+{
+    numBoids = a_iCount;
+    SendSettings();
+}
+
+void Scene::SetThreadedSimulation(bool a_bThreaded)
+{
+    m_bThreadedSimulation = a_bThreaded;
+    if (m_bThreadedSimulation)
+    {
+        StartSimulationThread();
+    }
+    else
+    {
+        StopSimulationThread();
+    }
+}
+
+unsigned int Scene::GetDrawCallCount() const
+{
+    return m_pRenderQueue->GetDrawCallCount() + m_pFlockDebugDraw->GetDrawCallCount();
+}
+
+unsigned int Scene::GetVisibleBoidCount() const
+{
+    return m_pBoidRenderer->GetVisibleCount();
+}
+
+float Scene::GetGpuFrameMs() const
+{
+    return static_cast<float>(m_pGpuProfiler->GetLatestTimings().xFrame.dGpuUs / 1000.0);
+}
+
+/// <summary>
+/// The profiler's clocks are lined up again first, so the CPU and GPU tracks line up in the trace
+/// </summary>
+void Scene::StartTrace(const std::string& a_sPath, unsigned int a_uFrames)
+{
+    m_pGpuProfiler->Calibrate();
+    m_pTraceRecorder->Start(a_sPath, a_uFrames);
+}
+
+/// <summary>
+/// Runs the commands sent since the last step, then the systems, then copies the result out for the render thread
+/// </summary>
+void Scene::StepSimulation(float a_fDeltaTime)
+{
+    std::chrono::high_resolution_clock::time_point xStart = std::chrono::high_resolution_clock::now();
+
+    SimulationCommand xCommand;
+    while (m_xSimCommands.Pop(xCommand))
+    {
+        xCommand();
+    }
+
+    // Update Entities
+    // Entities are processed in groups so that they are not all processed at once
+    // this makes it less intensive on processing so performs faster
+    m_iSizeOfGroup = NUM_OF_BOIDS / NUM_OF_BOID_GROUPS;
+
+    if (m_iSizeOfGroup == 0) m_iSizeOfGroup++;
+
+    m_iCurrentGroupNum++;
+    if (m_iCurrentGroupNum > NUM_OF_BOID_GROUPS)
+    {
+        m_iCurrentGroupNum = 1;
+    }
+
+    m_pForceSystem->SetGroup(m_iCurrentGroupNum, m_iSizeOfGroup);
+
+    // run the systems, any that don't share data run at the same time
+    m_pScheduler->Run(a_fDeltaTime, m_boundingBoxSize);
+
+    BoidSnapshot& xSnapshot = m_xSnapshots.GetWriteBuffer();
+    WriteSnapshot(xSnapshot);
+    xSnapshot.bGpuFlock = m_xSimSettings.bGpuFlock;
+    xSnapshot.uStep = ++m_uSimStep;
+    xSnapshot.uModelSwaps = m_uSimModelSwaps;
+    xSnapshot.fStepMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - xStart).count();
+    m_xSnapshots.Publish();
+}
+
+/// <summary>
+/// Every entity goes in, in entity order, with zeros for the components it doesn't have
+/// </summary>
+void Scene::WriteSnapshot(BoidSnapshot& a_xSnapshot) const
+{
+    a_xSnapshot.Clear();
+
+    std::map<const unsigned int, Entity*>::const_iterator xIter;
+    for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++)
+    {
+        Entity* pEntity = xIter->second;
+        TransformComponent* pTransComp = pEntity ? static_cast<TransformComponent*>(pEntity->FindComponentOfType(TRANSFORM)) : nullptr;
+        ModelComponent* pModelComp = pEntity ? static_cast<ModelComponent*>(pEntity->FindComponentOfType(MODEL)) : nullptr;
+        BrainComponent* pBrainComp = pEntity ? static_cast<BrainComponent*>(pEntity->FindComponentOfType(BRAIN)) : nullptr;
+
+        glm::mat4 m4ModelMatrix(1.0f);
+        bool bHasMatrix = pModelComp && pModelComp->GetModelMatrix(m4ModelMatrix);
+
+        a_xSnapshot.auEntityIDs.push_back(xIter->first);
+        a_xSnapshot.apModels.push_back(bHasMatrix ? pModelComp->GetModel() : nullptr);
+        a_xSnapshot.am4Models.push_back(m4ModelMatrix);
+        a_xSnapshot.av3Positions.push_back(pTransComp ? pTransComp->GetEntityMatrixRow(POSITION_VECTOR) : glm::vec3(0.0f));
+        a_xSnapshot.av3Velocities.push_back(pBrainComp ? pBrainComp->GetCurrentVelocity() : glm::vec3(0.0f));
+        for (unsigned int i = 0; i < BEHAVIOUR_COUNT; i++)
+        {
+            a_xSnapshot.av3BehaviourForces.push_back(pBrainComp ? pBrainComp->GetBehaviourForce(static_cast<BEHAVIOUR_SLOT>(i)) : glm::vec3(0.0f));
+        }
+    }
+}
+
+/// <summary>
+/// Steps once for every frame the render thread starts. If the render thread starts several while a step
+/// runs they are taken as one, the next step just covers the longer time
+/// </summary>
+void Scene::SimulationLoop()
+{
+    // the systems' command buffers are per thread, so this thread can't share the render thread's
+    ThreadPool::GetInstance()->ClaimThreadIndex();
+
+    unsigned int uSeenTicks = 0;
+    while (true)
+    {
+        float fDeltaTime = 0.0f;
+        {
+            std::unique_lock<std::mutex> xLock(m_xTickMutex);
+            m_xTickCondition.wait(xLock, [&]() { return m_uTicks != uSeenTicks || !m_bSimRunning; });
+            if (!m_bSimRunning)
+            {
+                return;
+            }
+            uSeenTicks = m_uTicks;
+            fDeltaTime = m_fTickDeltaTime;
+            m_fTickDeltaTime = 0.0f;
+        }
+
+        StepSimulation(fDeltaTime);
+    }
+}
+
+void Scene::StartSimulationThread()
+{
+    if (m_xSimThread.joinable())
+    {
+        return; // already running
+    }
+
+    {
+        std::lock_guard<std::mutex> xLock(m_xTickMutex);
+        m_bSimRunning = true;
+        m_uTicks = 0;
+        m_fTickDeltaTime = 0.0f;
+    }
+    m_xSimThread = std::thread(&Scene::SimulationLoop, this);
+}
+
+/// <summary>
+/// Waits for the step in progress to finish, after that the calling thread owns the simulation
+/// </summary>
+void Scene::StopSimulationThread()
+{
+    if (!m_xSimThread.joinable())
+    {
+        return; // not running
+    }
+
+    {
+        std::lock_guard<std::mutex> xLock(m_xTickMutex);
+        m_bSimRunning = false;
+    }
+    m_xTickCondition.notify_one();
+    m_xSimThread.join();
+}
+
+Scene::SimulationSettings Scene::GetPanelSettings() const
+{
+    SimulationSettings xSettings;
+    xSettings.xWeights = { wanderWeight, separationWeight, allignmentWeight, cohesionWeight };
+    xSettings.v3BoxPos = boxPos;
+    xSettings.iBoidCount = numBoids;
+    xSettings.bPlanarFlock = m_bPlanarFlock;
+    xSettings.bGpuFlock = m_bGpuFlock;
+    return xSettings;
+}
+
+/// <summary>
+/// Sends the panels' values to the simulation if any changed. If the queue is full they are left unsent,
+/// and go with the next frame's changes
+/// </summary>
+void Scene::SendSettings()
+{
+    SimulationSettings xSettings = GetPanelSettings();
+    const FlockWeights& xWeights = xSettings.xWeights;
+    const FlockWeights& xSentWeights = m_xSentSettings.xWeights;
+    bool bChanged = xWeights.fWander != xSentWeights.fWander || xWeights.fSeparation != xSentWeights.fSeparation ||
+        xWeights.fAlignment != xSentWeights.fAlignment || xWeights.fCohesion != xSentWeights.fCohesion ||
+        xSettings.v3BoxPos != m_xSentSettings.v3BoxPos || xSettings.iBoidCount != m_xSentSettings.iBoidCount ||
+        xSettings.bPlanarFlock != m_xSentSettings.bPlanarFlock || xSettings.bGpuFlock != m_xSentSettings.bGpuFlock;
+    if (!bChanged)
+    {
+        return; // early out
+    }
+
+    if (m_xSimCommands.Push([this, xSettings]() { ApplySettings(xSettings); }))
+    {
+        m_xSentSettings = xSettings;
+    }
+}
+
+/// <summary>
+/// Only does the work for what changed, the weights are pushed to every brain and the boids spawned or despawned
+/// </summary>
+void Scene::ApplySettings(const SimulationSettings& a_xSettings)
+{
+    m_xSimSettings = a_xSettings;
+
+    UpdateBoidWeights();
+    UpdateBoidNumber();
+    m_pPlanarSystem->SetWeights(m_xSimSettings.xWeights);
+    m_pPlanarSystem->SetBoxPosition(m_xSimSettings.v3BoxPos);
+    UpdateFlockSystems();
+}
+
+/// <summary>
+/// Only one flock moves the boids at a time, the brains, the planar flock or the GPU flock. The planar flock
+/// takes the boids from their transforms again whenever the flock in use changes
+/// </summary>
+void Scene::UpdateFlockSystems()
+{
+    bool bPlanar = !m_xSimSettings.bGpuFlock && m_xSimSettings.bPlanarFlock;
+    bool bBrains = !m_xSimSettings.bGpuFlock && !m_xSimSettings.bPlanarFlock;
+    if (m_pPlanarSystem->IsEnabled() != bPlanar || m_pForceSystem->IsEnabled() != bBrains)
+    {
+        m_pPlanarSystem->Reset();
+    }
+    m_pPlanarSystem->SetEnabled(bPlanar);
+    m_pForceSystem->SetEnabled(bBrains);
+    m_pMovementSystem->SetEnabled(bBrains);
+}
+
+/// <summary>
+/// Uploads every boid in the snapshot, remembering which entity each one came from. Boids already on the GPU
+/// are read back and keep where they got to, only new ones start from the snapshot
+/// </summary>
+void Scene::StartGpuFlock(const BoidSnapshot& a_xSnapshot)
+{
+    std::vector<glm::vec3> av3Positions(a_xSnapshot.av3Positions);
+    std::vector<glm::vec3> av3Velocities(a_xSnapshot.av3Velocities);
+
+    if (!m_auGpuEntityIDs.empty())
+    {
+        m_pGpuFlock->Download(m_av3GpuPositions, m_av3GpuVelocities);
+        // both lists are in entity order, so they are walked together
+        unsigned int uGpu = 0;
+        for (unsigned int i = 0; i < a_xSnapshot.GetBoidCount(); i++)
+        {
+            while (uGpu < m_auGpuEntityIDs.size() && m_auGpuEntityIDs[uGpu] < a_xSnapshot.auEntityIDs[i])
+            {
+                uGpu++;
+            }
+            if (uGpu < m_auGpuEntityIDs.size() && uGpu < m_av3GpuPositions.size() && m_auGpuEntityIDs[uGpu] == a_xSnapshot.auEntityIDs[i])
+            {
+                av3Positions[i] = m_av3GpuPositions[uGpu];
+                av3Velocities[i] = m_av3GpuVelocities[uGpu];
+            }
+        }
+    }
+
+    m_auGpuEntityIDs = a_xSnapshot.auEntityIDs;
+    m_pGpuFlock->Upload(av3Positions, av3Velocities);
+}
+
+/// <summary>
+/// Reads the flock back and sends it to the simulation thread to put back into the entities
+/// </summary>
+bool Scene::StopGpuFlock()
+{
+    m_pGpuFlock->Download(m_av3GpuPositions, m_av3GpuVelocities);
+
+    std::vector<unsigned int> auEntityIDs(m_auGpuEntityIDs);
+    std::vector<glm::vec3> av3Positions(m_av3GpuPositions);
+    std::vector<glm::vec3> av3Velocities(m_av3GpuVelocities);
+    if (!m_xSimCommands.Push([this, auEntityIDs, av3Positions, av3Velocities]() { WriteBackGpuFlock(auEntityIDs, av3Positions, av3Velocities); }))
+    {
+        return false;
+    }
+
+    m_auGpuEntityIDs.clear();
+    return true;
+}
+
+/// <summary>
+/// Puts each boid back into its entity, if the entity is still there
+/// </summary>
+void Scene::WriteBackGpuFlock(const std::vector<unsigned int>& a_auEntityIDs, const std::vector<glm::vec3>& a_av3Positions,
+    const std::vector<glm::vec3>& a_av3Velocities)
+{
+    const glm::vec3 v3Up(0.0f, 1.0f, 0.0f);
+    for (unsigned int i = 0; i < a_av3Positions.size() && i < a_auEntityIDs.size(); i++)
+    {
+        Entity* pEntity = Entity::FindEntity(a_auEntityIDs[i]);
+        TransformComponent* pTransComp = pEntity ? static_cast<TransformComponent*>(pEntity->FindComponentOfType(TRANSFORM)) : nullptr;
+        BrainComponent* pBrainComp = pEntity ? static_cast<BrainComponent*>(pEntity->FindComponentOfType(BRAIN)) : nullptr;
+        if (!pTransComp)
+        {
+            continue;
+        }
+
+        // face the way the boid is going, the brain straightens this out on its next update
+        if (glm::length(a_av3Velocities[i]) > 0.0f)
+        {
+            glm::vec3 v3Forward = glm::normalize(a_av3Velocities[i]);
+            glm::vec3 v3Right = glm::cross(v3Up, v3Forward);
+            if (glm::length(v3Right) > 0.0f)
+            {
+                pTransComp->SetEntityMatrixRow(RIGHT_VECTOR, glm::normalize(v3Right));
+                pTransComp->SetEntityMatrixRow(UP_VECTOR, glm::normalize(glm::cross(v3Forward, v3Right)));
+            }
+            pTransComp->SetEntityMatrixRow(FORWARD_VECTOR, v3Forward);
+        }
+        pTransComp->SetEntityMatrixRow(POSITION_VECTOR, a_av3Positions[i]);
+        if (pBrainComp)
+        {
+            pBrainComp->SetCurrentVelocity(a_av3Velocities[i]);
+        }
+    }
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void Scene::framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -385,67 +911,153 @@ void Scene::UpdateBoidWeights()
         BrainComponent* pTargetBrain = static_cast<BrainComponent*>(pTarget->FindComponentOfType(BRAIN));
 
         // update the values in the brain component
-        pTargetBrain->allignmentWeight = allignmentWeight;
-        pTargetBrain->cohesionWeight = cohesionWeight;
-        pTargetBrain->separationWeight = separationWeight;
-        pTargetBrain->wanderWeight = wanderWeight;
-        pTargetBrain->boxPos = boxPos;
+        pTargetBrain->allignmentWeight = m_xSimSettings.xWeights.fAlignment;
+        pTargetBrain->cohesionWeight = m_xSimSettings.xWeights.fCohesion;
+        pTargetBrain->separationWeight = m_xSimSettings.xWeights.fSeparation;
+        pTargetBrain->wanderWeight = m_xSimSettings.xWeights.fWander;
+        pTargetBrain->boxPos = m_xSimSettings.v3BoxPos;
     }
 }
 
 void Scene::UpdateBoidNumber()
 {
     // increase or decrease number of boids based on slider value
-    int boidsToAdd = numBoids - NUM_OF_BOIDS;
+    int boidsToAdd = m_xSimSettings.iBoidCount - NUM_OF_BOIDS;
 
     // if the boids to add is a positive value
     if (boidsToAdd > 0)
     {
-        // Create entities
-        while (numBoids > NUM_OF_BOIDS)
+        // queue up the new entities, they are created when the scheduler next flushes its commands
+        CommandBuffer& xCommands = m_pScheduler->GetCommandQueue()->GetThreadBuffer();
+        while (m_xSimSettings.iBoidCount > NUM_OF_BOIDS)
         {
-            Entity* pEntity = new Entity();
-
-            // Transform Component
-            TransformComponent* pTransformComponent = new TransformComponent(pEntity);
-            pTransformComponent->SetEntityMatrixRow(POSITION_VECTOR, glm::vec3(RandomFloatBetweenRange(-2, 2),
-                                                                               RandomFloatBetweenRange(-2, 2),
-                                                                               RandomFloatBetweenRange(-2, 2)));
-            pEntity->AddComponent(pTransformComponent);
-
-            // Model Component
-            ModelComponent* pModelComponent = new ModelComponent(pEntity);
-            pModelComponent->SetModel(m_model);
-            pModelComponent->SetScale(0.01f);
-            pEntity->AddComponent(pModelComponent);
-
-            // Brain COmponent
-            BrainComponent* pBrainComponent = new BrainComponent(pEntity);
-            pEntity->AddComponent(pBrainComponent);
+            xCommands.Spawn([this](Entity* pEntity) { SetupBoid(pEntity); });
             NUM_OF_BOIDS++;
         }
     }
     // if the boids to add is negative
     else if (boidsToAdd < 0)
     {
-        // for each boid to remove
-        while (numBoids < NUM_OF_BOIDS)
+        // queue up the removals from the front of the list, they are removed when the scheduler next flushes its commands
+        CommandBuffer& xCommands = m_pScheduler->GetCommandQueue()->GetThreadBuffer();
+        std::map<const unsigned int, Entity*>::const_iterator xIter = Entity::GetEntityList().begin();
+        while (m_xSimSettings.iBoidCount < NUM_OF_BOIDS && xIter != Entity::GetEntityList().end())
         {
-            // make the iterator
-            std::map<const unsigned int, Entity*>::const_iterator xIter;
-            xIter = Entity::GetEntityList().begin();
-            // get the second value in the iterator (the entity value not key)
-            Entity* pEntity = xIter->second;
-            // remove the entity from the map
-            Entity::RemoveEntity(xIter);
-            // clear the entity from memory
-            delete pEntity;
+            xCommands.Despawn(xIter->first);
+            xIter++;
             // reduce number of boids
             NUM_OF_BOIDS--;
         }
     }
 }
 
+/// <summary>
+/// adds the components that make an entity into a boid
+/// </summary>
+void Scene::SetupBoid(Entity* a_pEntity)
+{
+    // Transform Component
+    TransformComponent* pTransformComponent = new TransformComponent(a_pEntity);
+    pTransformComponent->SetEntityMatrixRow(POSITION_VECTOR, glm::vec3(RandomFloatBetweenRange(-2, 2),
+                                                                       RandomFloatBetweenRange(-2, 2),
+                                                                       RandomFloatBetweenRange(-2, 2)));
+    a_pEntity->AddComponent(pTransformComponent);
+
+    // Model Component
+    ModelComponent* pModelComponent = new ModelComponent(a_pEntity);
+    pModelComponent->SetModel(m_xSimModel);
+    pModelComponent->SetScale(BOID_MODEL_SCALE);
+    a_pEntity->AddComponent(pModelComponent);
+
+    // Brain COmponent
+    BrainComponent* pBrainComponent = new BrainComponent(a_pEntity);
+    a_pEntity->AddComponent(pBrainComponent);
+
+    // give the new boid the current behaviour weights
+    pBrainComponent->allignmentWeight = m_xSimSettings.xWeights.fAlignment;
+    pBrainComponent->cohesionWeight = m_xSimSettings.xWeights.fCohesion;
+    pBrainComponent->separationWeight = m_xSimSettings.xWeights.fSeparation;
+    pBrainComponent->wanderWeight = m_xSimSettings.xWeights.fWander;
+    pBrainComponent->boxPos = m_xSimSettings.v3BoxPos;
+}
+
+/// <summary>
+/// The simulation changes the boids over before its next step. The old model is held here until a snapshot
+/// written after the swap is drawn, as any number of steps can run before the command is picked up
+/// </summary>
+void Scene::SwapBoidModel(const std::string& a_sPath)
+{
+    // the meshes only keep what the model shader reads, packed
+    ModelHandle xModel = m_pAssetManager->LoadModel(a_sPath, BOID_LOD_RATIOS, m_xShader->Get()->attributeMask(), true, BOID_PLACEHOLDER_RADIUS);
+    if (xModel == m_xModel)
+    {
+        return; // early out
+    }
+    if (!m_xSimCommands.Push([this, xModel]() { SetBoidModel(xModel); }))
+    {
+        return; // the simulation is too far behind, the button can be pressed again
+    }
+
+    m_uModelSwaps++;
+    if (m_xModel)
+    {
+        RetiredModel xRetired = { m_xModel, m_uModelSwaps };
+        m_axRetiredModels.push_back(xRetired);
+    }
+    m_xModel = xModel;
+}
+
+void Scene::SetBoidModel(const ModelHandle& a_xModel)
+{
+    m_xSimModel = a_xModel;
+    m_uSimModelSwaps++;
+    std::map<const unsigned int, Entity*>::const_iterator xIter;
+    for (xIter = Entity::GetEntityList().begin(); xIter != Entity::GetEntityList().end(); xIter++)
+    {
+        ModelComponent* pModelComp = xIter->second ? static_cast<ModelComponent*>(xIter->second->FindComponentOfType(MODEL)) : nullptr;
+        if (pModelComp)
+        {
+            pModelComp->SetModel(a_xModel);
+        }
+    }
+}
+
+/// <summary>
+/// The atlas of a model swapped out is dropped straight away, so the renderer never keeps one for a model
+/// that could be freed before the new one is resident. A new atlas bakes over the next few frames, the boids
+/// are drawn without impostors until it is done
+/// </summary>
+void Scene::UpdateBoidModel(const BoidSnapshot& a_xSnapshot)
+{
+    const Model* pResident = m_xModel ? m_xModel->GetResident() : nullptr;
+    if (m_pImpostorModel != pResident)
+    {
+        if (m_pImpostorAtlas)
+        {
+            m_pBoidRenderer->SetImpostor(m_pImpostorModel, nullptr);
+            delete m_pImpostorAtlas;
+            m_pImpostorAtlas = nullptr;
+        }
+        m_pImpostorModel = pResident;
+        if (pResident)
+        {
+            // far away boids are drawn as billboards baked from the model
+            m_pImpostorAtlas = new ImpostorAtlas(m_xModel->GetResident(), m_pAssetManager);
+        }
+    }
+    if (m_pImpostorAtlas && !m_pImpostorAtlas->IsValid() && m_pImpostorAtlas->Update())
+    {
+        m_pBoidRenderer->SetImpostor(m_pImpostorModel, m_pImpostorAtlas);
+    }
+
+    // older snapshots are never drawn again, so once one written after a swap is drawn the model it let go of is done with
+    std::vector<RetiredModel>::iterator xRetired = m_axRetiredModels.begin();
+    while (xRetired != m_axRetiredModels.end())
+    {
+        xRetired = a_xSnapshot.uModelSwaps >= xRetired->uSwap ? m_axRetiredModels.erase(xRetired) : std::next(xRetired);
+    }
+}
+
 // function to show the frame data on the gui
 void Scene::showFrameData(bool a_bShowFrameData)
 {
@@ -466,6 +1078,86 @@ void Scene::showFrameData(bool a_bShowFrameData)
         ImGui::Separator();
         // displays the average time per frame and the average frames per second so the user can see the performance of the program
         ImGui::Text("Scene Average: %.3f ms/frame (%.1f FPS)", 1000.f / io.Framerate, io.Framerate);
+        // toggles the view of the systems run last frame
+        ImGui::Checkbox("Show System Graph", &m_bShowSystemGraph);
+        // steps the simulation on its own thread while the last step is drawn
+        bool bThreadedSimulation = m_bThreadedSimulation;
+        if (ImGui::Checkbox("Threaded Simulation", &bThreadedSimulation))
+        {
+            SetThreadedSimulation(bThreadedSimulation);
+        }
+        const BoidSnapshot& xSnapshot = m_xSnapshots.GetReadBuffer();
+        ImGui::Text("Simulation step: %.3f ms (drawing step %u)", xSnapshot.fStepMs, xSnapshot.uStep);
+        // switches between drawing every boid on its own and drawing them all instanced
+        ImGui::Checkbox("Instanced Rendering", &m_bInstancedRendering);
+        if (m_bInstancedRendering)
+        {
+            ImGui::Text("Boid draw calls: %u for %u boids", m_pBoidRenderer->GetDrawCallCount(), m_pBoidRenderer->GetInstanceCount());
+            // times the cpu had to wait for the gpu to finish with the instance data
+            const StreamingBuffer* pInstanceBuffer = m_pBoidRenderer->GetInstanceBuffer();
+            ImGui::Text("Instance buffer stalls: %u (%.3f ms)", pInstanceBuffer->GetStallCount(), pInstanceBuffer->GetStallMs());
+            // only the boids the camera can see are drawn
+            ImGui::Checkbox("Frustum Culling", &m_bFrustumCulling);
+            if (m_bFrustumCulling)
+            {
+                ImGui::SameLine();
+                ImGui::Checkbox("Parallel", &m_bParallelCulling);
+            }
+            ImGui::Text("Visible boids: %u / %u (culling %.3f ms)", m_pBoidRenderer->GetVisibleCount(), m_pBoidRenderer->GetInstanceCount(), m_pBoidRenderer->GetCullMs());
+            // boids further away draw with fewer triangles
+            ImGui::Checkbox("Level Of Detail", &m_bLodSelection);
+            const Model* pBoidModel = m_xModel->Get();
+            ImGui::Text("Boid vertex size: %u bytes (%u unpacked)", pBoidModel->meshes.empty() ? 0 : pBoidModel->meshes[0].getVertexStride(), static_cast<unsigned int>(sizeof(Vertex)));
+            const std::vector<unsigned int>& auLodCounts = m_pBoidRenderer->GetLodCounts();
+            for (unsigned int i = 0; i < auLodCounts.size(); i++)
+            {
+                ImGui::Text("LOD %u: %u boids, %u triangles each", i, auLodCounts[i], pBoidModel->meshes.empty() ? 0 : pBoidModel->meshes[0].getLodIndexCount(i) / 3);
+            }
+            // and the furthest as two triangle billboards
+            if (m_pImpostorAtlas && m_pImpostorAtlas->IsValid())
+            {
+                ImGui::Checkbox("Impostors", &m_bImpostors);
+                if (m_bImpostors)
+                {
+                    ImGui::SliderFloat("Impostor Distance", &m_fImpostorDistance, 1.0f, 50.0f);
+                    ImGui::Text("Impostors: %u", m_pBoidRenderer->GetImpostorCount());
+                }
+            }
+        }
+        // what the render queue sent to GL last frame, and how many binds it could skip
+        const RenderStateCounts& xCounts = m_pRenderQueue->GetStateCounts();
+        ImGui::Text("Draw calls: %u", m_pRenderQueue->GetDrawCallCount());
+        ImGui::Text("State changes: %u programs, %u vertex arrays, %u textures (%u skipped)", xCounts.uProgramChanges,
+            xCounts.uVertexArrayChanges, xCounts.uTextureChanges, xCounts.uSkippedChanges);
+
+        // each pass on the cpu and the gpu, from the newest frame the gpu has finished
+        ImGui::Separator();
+        const GpuProfiler::FrameTimings& xTimings = m_pGpuProfiler->GetLatestTimings();
+        ImGui::Text("Render passes (frame %llu): cpu %.3f ms, gpu %.3f ms", xTimings.uFrame, xTimings.xFrame.dCpuUs / 1000.0, xTimings.xFrame.dGpuUs / 1000.0);
+        for (const GpuProfiler::PassTiming& xPass : xTimings.axPasses)
+        {
+            ImGui::Text("  %-10s cpu %7.3f ms  gpu %7.3f ms", xPass.sName.c_str(), xPass.dCpuUs / 1000.0, xPass.dGpuUs / 1000.0);
+        }
+        ImGui::Text("Timings dropped waiting on the gpu: %u", m_pGpuProfiler->GetDroppedFrameCount());
+        if (m_pTraceRecorder->IsRecording())
+        {
+            ImGui::Text("Recording trace: %u / %u frames", m_pTraceRecorder->GetRecordedFrames(), m_pTraceRecorder->GetFrameLimit());
+        }
+        else if (ImGui::Button("Record Trace"))
+        {
+            StartTrace(TRACE_PATH, TRACE_FRAMES);
+        }
+
+        // what the asset manager holds, and who holds it
+        ImGui::Separator();
+        ImGui::Text("Assets (%u loading), %.1f / %.0f MB%s", m_pAssetManager->GetLoadingCount(), m_pAssetManager->GetMemoryUsed() / (1024.0f * 1024.0f),
+            m_pAssetManager->GetMemoryBudget() / (1024.0f * 1024.0f), m_pAssetManager->IsOverBudget() ? " (over budget)" : "");
+        static const char* const aszSTATES[] = { "queued", "loading", "uploading", "resident", "failed" };
+        for (const AssetManager::AssetInfo& xAsset : m_pAssetManager->GetAssetInfo())
+        {
+            ImGui::Text("  %s: %s, %ld handles, %.1f ms, %u KB RAM, %u KB VRAM", xAsset.sPath.c_str(), aszSTATES[xAsset.eState], xAsset.lHandles,
+                xAsset.fLoadMs, static_cast<unsigned int>(xAsset.uCpuBytes / 1024), static_cast<unsigned int>(xAsset.uGpuBytes / 1024));
+        }
     }
     ImGui::End();
 }
@@ -491,6 +1183,12 @@ void Scene::changeBehaviourWeights(bool a_bShowBehaviour)
         ImGui::Separator();
         // slider to change number of boids
         ImGui::SliderInt("Number Of Boids", &numBoids, minBoids, maxBoids);
+        // loads another model for the boids, they keep drawing while it loads
+        ImGui::InputText("Boid Model", m_szModelPath, sizeof(m_szModelPath));
+        if (ImGui::Button("Load Model"))
+        {
+            SwapBoidModel(m_szModelPath);
+        }
         ImGui::Separator();
         // slider to change the weighting of the behaviour forces on the boids
         ImGui::SliderFloat("Wander Weight", &wanderWeight, minWeight, maxWeight);
@@ -500,8 +1198,37 @@ void Scene::changeBehaviourWeights(bool a_bShowBehaviour)
 
         // float input to change the position of the box in the scene
         ImGui::InputFloat3("Box Position", pos, "%.3f");
+        ImGui::Separator();
+        // switches between the 3D brains and the flat 2D flock
+        if (!m_bGpuFlock)
+        {
+            ImGui::Checkbox("Planar Flock", &m_bPlanarFlock);
+        }
+        // runs the 3D flock with compute shaders, the simulation is told along with the other settings
+        if (m_pGpuFlock->IsValid() && ImGui::Checkbox("GPU Flock", &m_bGpuFlock))
+        {
+            if (m_bGpuFlock)
+            {
+                StartGpuFlock(m_xSnapshots.GetReadBuffer());
+            }
+            else if (!StopGpuFlock())
+            {
+                // the simulation is too far behind to take the boids back yet
+                m_bGpuFlock = true;
+            }
+        }
+        ImGui::Separator();
+        // draws what is steering each boid, the GPU flock only keeps the total force
+        ImGui::Checkbox("Show Velocities", &m_bShowVelocities);
+        ImGui::Checkbox("Show Neighbourhoods", &m_bShowNeighbourhoods);
+        ImGui::Checkbox("Show Forces", &m_bShowForces);
+        if (m_bShowVelocities || m_bShowNeighbourhoods || m_bShowForces)
+        {
+            ImGui::Text("Debug draw calls: %u for %u boids", m_pFlockDebugDraw->GetDrawCallCount(), m_pFlockDebugDraw->GetBoidCount());
+        }
     }
     ImGui::End();
 
     boxPos = glm::vec3(pos[0], pos[1], pos[2]);
+    SendSettings();
 }
@@ -0,0 +1,141 @@
+// This files header
+#include "StreamingBuffer.h"
+
+// OpenGL includes
+#include <glad/glad.h>
+
+// std includes
+#include <chrono>
+#include <iostream>
+
+// typedefs
+typedef std::chrono::high_resolution_clock Clock;
+
+// constants
+static const GLbitfield uSTORAGE_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+// how long to wait on a fence before checking again, in nanoseconds
+static const GLuint64 uFENCE_TIMEOUT = 1000000;
+// regions start on this many bytes so any element up to it lines up with the region start
+static const size_t uREGION_ALIGNMENT = 256;
+
+// rounds a size up to the region alignment
+static size_t AlignRegionSize(size_t a_uBytes)
+{
+	return ((a_uBytes + uREGION_ALIGNMENT - 1) / uREGION_ALIGNMENT) * uREGION_ALIGNMENT;
+}
+
+// constructor
+StreamingBuffer::StreamingBuffer(size_t a_uRegionSize, unsigned int a_uRegionCount) : m_uBuffer(0), m_pMapped(nullptr), m_uRegionSize(AlignRegionSize(a_uRegionSize > 0 ? a_uRegionSize : 1)),
+	m_uRegionCount(a_uRegionCount > 0 ? a_uRegionCount : 1), m_uCurrentRegion(0), m_apFences(m_uRegionCount, nullptr), m_uStallCount(0), m_fStallMs(0.0f)
+{
+	CreateStorage();
+}
+
+// destructor
+StreamingBuffer::~StreamingBuffer()
+{
+	for (void*& pFence : m_apFences)
+	{
+		if (pFence)
+		{
+			glDeleteSync(static_cast<GLsync>(pFence));
+			pFence = nullptr;
+		}
+	}
+
+	if (m_uBuffer)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_uBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &m_uBuffer);
+	}
+}
+
+/// <summary>
+/// Buffer storage is immutable, so growing means making a new buffer. The new one is made before the
+/// old one is deleted so it never gets the same name, which lets anything caching the name see the change
+/// </summary>
+void StreamingBuffer::CreateStorage()
+{
+	unsigned int uNewBuffer = 0;
+	glGenBuffers(1, &uNewBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, uNewBuffer);
+	glBufferStorage(GL_ARRAY_BUFFER, m_uRegionSize * m_uRegionCount, nullptr, uSTORAGE_FLAGS);
+	m_pMapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_uRegionSize * m_uRegionCount, uSTORAGE_FLAGS));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!m_pMapped)
+	{
+		std::cout << "Failed to map streaming buffer" << std::endl;
+	}
+
+	if (m_uBuffer)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_uBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &m_uBuffer);
+	}
+	m_uBuffer = uNewBuffer;
+}
+
+void StreamingBuffer::WaitForRegion(unsigned int a_uRegion)
+{
+	GLsync pFence = static_cast<GLsync>(m_apFences[a_uRegion]);
+	if (!pFence)
+	{
+		return; // nothing is reading it
+	}
+
+	// a fence that has already passed costs nothing, anything else is a stall
+	GLenum eResult = glClientWaitSync(pFence, 0, 0);
+	if (eResult == GL_TIMEOUT_EXPIRED)
+	{
+		Clock::time_point xStart = Clock::now();
+		m_uStallCount++;
+		do
+		{
+			eResult = glClientWaitSync(pFence, GL_SYNC_FLUSH_COMMANDS_BIT, uFENCE_TIMEOUT);
+		} while (eResult == GL_TIMEOUT_EXPIRED);
+		m_fStallMs += std::chrono::duration<float, std::milli>(Clock::now() - xStart).count();
+	}
+
+	glDeleteSync(pFence);
+	m_apFences[a_uRegion] = nullptr;
+}
+
+/// <summary>
+/// Moves on to the next region and hands back where to write. The pointer stays valid until EndRegion,
+/// and can be written from worker threads as the mapping is coherent
+/// </summary>
+void* StreamingBuffer::BeginRegion(size_t a_uBytes)
+{
+	m_uCurrentRegion = (m_uCurrentRegion + 1) % m_uRegionCount;
+
+	if (a_uBytes > m_uRegionSize)
+	{
+		// everything in flight has to finish before the old storage goes
+		for (unsigned int i = 0; i < m_uRegionCount; i++)
+		{
+			WaitForRegion(i);
+		}
+		// leave room to grow so a few more boids don't reallocate every frame
+		m_uRegionSize = AlignRegionSize(a_uBytes + a_uBytes / 2);
+		CreateStorage();
+		m_uCurrentRegion = 0;
+	}
+
+	WaitForRegion(m_uCurrentRegion);
+
+	return m_pMapped ? m_pMapped + GetRegionOffset() : nullptr;
+}
+
+void StreamingBuffer::EndRegion()
+{
+	if (m_apFences[m_uCurrentRegion])
+	{
+		glDeleteSync(static_cast<GLsync>(m_apFences[m_uCurrentRegion]));
+	}
+	m_apFences[m_uCurrentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,27 @@
+// This files header
+#include "System.h"
+
+// Project Includes
+#include "CommandBuffer.h"
+
+// constructor
+System::System(const char* a_szName) : m_sName(a_szName), m_pCommandQueue(nullptr), m_uReadMask(0), m_uWriteMask(0), m_bEnabled(true)
+{
+
+}
+
+/// <summary>
+/// Two systems conflict when one writes something the other reads or writes
+/// </summary>
+bool System::ConflictsWith(const System& a_xOther) const
+{
+	AccessMask uTouched = m_uReadMask | m_uWriteMask;
+	AccessMask uOtherTouched = a_xOther.m_uReadMask | a_xOther.m_uWriteMask;
+
+	return (m_uWriteMask & uOtherTouched) != 0 || (a_xOther.m_uWriteMask & uTouched) != 0;
+}
+
+CommandBuffer& System::GetCommandBuffer()
+{
+	return m_pCommandQueue->GetThreadBuffer();
+}
@@ -0,0 +1,279 @@
+// This files header
+#include "SystemScheduler.h"
+
+// Project Includes
+#include "System.h"
+#include "ThreadPool.h"
+#include "CommandBuffer.h"
+
+// IMGUI include
+#include <imgui/imgui.h>
+
+// std includes
+#include <algorithm>
+#include <string>
+
+// typedefs
+typedef std::chrono::high_resolution_clock Clock;
+
+// constructor
+SystemScheduler::SystemScheduler(ThreadPool* a_pThreadPool) : m_pThreadPool(a_pThreadPool), m_pCommandQueue(nullptr), m_uRemainingCapacity(0), m_pFrameGroup(nullptr), m_fFrameMs(0.0f), m_fCriticalPathMs(0.0f)
+{
+	// one command buffer for every thread that could run a system
+	m_pCommandQueue = new CommandQueue(m_pThreadPool ? m_pThreadPool->GetThreadIndexCount() : 1);
+}
+
+// destructor
+SystemScheduler::~SystemScheduler()
+{
+	for (System* pSystem : m_apSystems)
+	{
+		delete pSystem;
+	}
+	delete m_pCommandQueue;
+}
+
+/// <summary>
+/// Adds a system to the frame. Registration order decides which of two conflicting systems runs first
+/// </summary>
+void SystemScheduler::AddSystem(System* a_pSystem)
+{
+	if (a_pSystem)
+	{
+		a_pSystem->m_pCommandQueue = m_pCommandQueue;
+		m_apSystems.push_back(a_pSystem);
+	}
+}
+
+/// <summary>
+/// Builds the frame graph and runs all the enabled systems on the thread pool
+/// </summary>
+/// <param name="a_fDeltaTime"> time between frames </param>
+/// <param name="a_fBoundingBoxSize"> size of the bounding box </param>
+void SystemScheduler::Run(float a_fDeltaTime, float a_fBoundingBoxSize)
+{
+	BuildGraph();
+
+	m_xFrameStart = Clock::now();
+
+	if (!m_pThreadPool)
+	{
+		// no pool to run on, so just go through the systems in order
+		for (unsigned int i = 0; i < m_axNodes.size(); i++)
+		{
+			RunNode(i, a_fDeltaTime, a_fBoundingBoxSize);
+		}
+	}
+	else
+	{
+		TaskGroup xFrameGroup;
+		m_pFrameGroup = &xFrameGroup;
+
+		// start with every system that isn't waiting on anything
+		for (unsigned int i = 0; i < m_axNodes.size(); i++)
+		{
+			if (m_axNodes[i].auDependencies.empty())
+			{
+				m_pThreadPool->Submit([this, i, a_fDeltaTime, a_fBoundingBoxSize]() { RunNode(i, a_fDeltaTime, a_fBoundingBoxSize); }, &xFrameGroup);
+			}
+		}
+
+		m_pThreadPool->Wait(xFrameGroup);
+		m_pFrameGroup = nullptr;
+	}
+
+	m_fFrameMs = std::chrono::duration<float, std::milli>(Clock::now() - m_xFrameStart).count();
+
+	// sync point, nothing is running so the entity list is safe to change
+	ThreadPool::SetTaskTag(0);
+	m_pCommandQueue->Flush();
+
+	FindCriticalPath();
+
+	// the debug window may be drawn on another thread, so it is handed a copy of the finished frame
+	GraphReport& xReport = m_xReports.GetWriteBuffer();
+	xReport.axNodes = m_axNodes;
+	xReport.fFrameMs = m_fFrameMs;
+	xReport.fCriticalPathMs = m_fCriticalPathMs;
+	m_xReports.Publish();
+}
+
+/// <summary>
+/// A system depends on every earlier enabled system it conflicts with
+/// </summary>
+void SystemScheduler::BuildGraph()
+{
+	m_axNodes.clear();
+
+	for (System* pSystem : m_apSystems)
+	{
+		if (!pSystem->IsEnabled())
+		{
+			continue;
+		}
+
+		SystemNode xNode;
+		xNode.pSystem = pSystem;
+		xNode.fStartMs = 0.0f;
+		xNode.fEndMs = 0.0f;
+		xNode.uThreadIndex = 0;
+		xNode.bOnCriticalPath = false;
+
+		unsigned int uNodeIndex = static_cast<unsigned int>(m_axNodes.size());
+		for (unsigned int i = 0; i < uNodeIndex; i++)
+		{
+			if (pSystem->ConflictsWith(*m_axNodes[i].pSystem))
+			{
+				xNode.auDependencies.push_back(i);
+				m_axNodes[i].auDependants.push_back(uNodeIndex);
+			}
+		}
+
+		m_axNodes.push_back(xNode);
+	}
+
+	// only reallocate the counters when the number of systems grows
+	if (m_uRemainingCapacity < m_axNodes.size())
+	{
+		m_uRemainingCapacity = static_cast<unsigned int>(m_axNodes.size());
+		m_auRemainingDependencies.reset(new std::atomic<unsigned int>[m_uRemainingCapacity]);
+	}
+
+	for (unsigned int i = 0; i < m_axNodes.size(); i++)
+	{
+		m_auRemainingDependencies[i].store(static_cast<unsigned int>(m_axNodes[i].auDependencies.size()), std::memory_order_relaxed);
+	}
+}
+
+void SystemScheduler::RunNode(unsigned int a_uNodeIndex, float a_fDeltaTime, float a_fBoundingBoxSize)
+{
+	SystemNode& xNode = m_axNodes[a_uNodeIndex];
+
+	// tag the work with the node so its commands flush in system order, 0 is left for the scene. the thread
+	// goes back to its own tag after, as it may be the scene's thread running the nodes in order
+	unsigned int uPreviousTag = ThreadPool::GetTaskTag();
+	ThreadPool::SetTaskTag(a_uNodeIndex + 1);
+
+	xNode.uThreadIndex = ThreadPool::GetThreadIndex();
+	xNode.fStartMs = std::chrono::duration<float, std::milli>(Clock::now() - m_xFrameStart).count();
+	xNode.pSystem->Update(a_fDeltaTime, a_fBoundingBoxSize);
+	xNode.fEndMs = std::chrono::duration<float, std::milli>(Clock::now() - m_xFrameStart).count();
+
+	ThreadPool::SetTaskTag(uPreviousTag);
+
+	if (!m_pFrameGroup)
+	{
+		return; // running in order, nothing to release
+	}
+
+	// the last dependency to finish is the one that queues the dependant
+	for (unsigned int uDependant : xNode.auDependants)
+	{
+		if (m_auRemainingDependencies[uDependant].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_pThreadPool->Submit([this, uDependant, a_fDeltaTime, a_fBoundingBoxSize]() { RunNode(uDependant, a_fDeltaTime, a_fBoundingBoxSize); }, m_pFrameGroup);
+		}
+	}
+}
+
+/// <summary>
+/// Finds the chain of dependant systems with the longest total run time. This is the part of the
+/// frame that extra threads can't speed up, so it's where optimisation should be aimed
+/// </summary>
+void SystemScheduler::FindCriticalPath()
+{
+	m_fCriticalPathMs = 0.0f;
+	if (m_axNodes.empty())
+	{
+		return; // early out
+	}
+
+	// nodes are already in dependency order so a single pass is enough
+	std::vector<float> afPathMs(m_axNodes.size(), 0.0f);
+	std::vector<int> aiPrevious(m_axNodes.size(), -1);
+	unsigned int uLongestEnd = 0;
+
+	for (unsigned int i = 0; i < m_axNodes.size(); i++)
+	{
+		for (unsigned int uDependency : m_axNodes[i].auDependencies)
+		{
+			if (afPathMs[uDependency] > afPathMs[i])
+			{
+				afPathMs[i] = afPathMs[uDependency];
+				aiPrevious[i] = static_cast<int>(uDependency);
+			}
+		}
+		afPathMs[i] += m_axNodes[i].fEndMs - m_axNodes[i].fStartMs;
+
+		if (afPathMs[i] > afPathMs[uLongestEnd])
+		{
+			uLongestEnd = i;
+		}
+	}
+
+	m_fCriticalPathMs = afPathMs[uLongestEnd];
+	for (int iNode = static_cast<int>(uLongestEnd); iNode >= 0; iNode = aiPrevious[iNode])
+	{
+		m_axNodes[iNode].bOnCriticalPath = true;
+	}
+}
+
+/// <summary>
+/// Lists the systems run in the last finished frame, what they waited on, and draws them on a per thread timeline
+/// </summary>
+void SystemScheduler::ShowDebugWindow(bool* a_pbOpen)
+{
+	if (!a_pbOpen || !*a_pbOpen)
+	{
+		return; // early out
+	}
+
+	m_xReports.Acquire();
+	const GraphReport& xReport = m_xReports.GetReadBuffer();
+	const ImVec4 xCriticalColour(1.0f, 0.45f, 0.2f, 1.0f);
+
+	if (ImGui::Begin("System Graph", a_pbOpen, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings))
+	{
+		ImGui::Text("Systems: %.3f ms, critical path: %.3f ms", xReport.fFrameMs, xReport.fCriticalPathMs);
+		ImGui::Separator();
+
+		for (const SystemNode& xNode : xReport.axNodes)
+		{
+			std::string sWaitsOn;
+			for (unsigned int uDependency : xNode.auDependencies)
+			{
+				sWaitsOn += (sWaitsOn.empty() ? "" : ", ") + xReport.axNodes[uDependency].pSystem->GetName();
+			}
+
+			if (xNode.bOnCriticalPath)
+			{
+				ImGui::PushStyleColor(ImGuiCol_Text, xCriticalColour);
+			}
+			ImGui::Text("%-16s thread %u  %7.3f -> %7.3f ms  after: %s", xNode.pSystem->GetName().c_str(), xNode.uThreadIndex,
+				xNode.fStartMs, xNode.fEndMs, sWaitsOn.empty() ? "-" : sWaitsOn.c_str());
+			if (xNode.bOnCriticalPath)
+			{
+				ImGui::PopStyleColor();
+			}
+		}
+
+		// timeline, one row per thread that ran something
+		ImGui::Separator();
+		const float fRowHeight = 16.0f;
+		const float fWidth = 420.0f;
+		unsigned int uThreadRows = m_pThreadPool ? m_pThreadPool->GetThreadIndexCount() : 1;
+		float fScale = xReport.fFrameMs > 0.0f ? fWidth / xReport.fFrameMs : 0.0f;
+
+		ImVec2 xOrigin = ImGui::GetCursorScreenPos();
+		ImDrawList* pDrawList = ImGui::GetWindowDrawList();
+		for (const SystemNode& xNode : xReport.axNodes)
+		{
+			ImVec2 xMin(xOrigin.x + xNode.fStartMs * fScale, xOrigin.y + xNode.uThreadIndex * fRowHeight);
+			ImVec2 xMax(xOrigin.x + std::max(xNode.fEndMs * fScale, xNode.fStartMs * fScale + 2.0f), xMin.y + fRowHeight - 2.0f);
+			pDrawList->AddRectFilled(xMin, xMax, xNode.bOnCriticalPath ? ImGui::GetColorU32(xCriticalColour) : IM_COL32(90, 150, 220, 255));
+			pDrawList->AddText(ImVec2(xMin.x + 2.0f, xMin.y), IM_COL32_WHITE, xNode.pSystem->GetName().c_str());
+		}
+		ImGui::Dummy(ImVec2(fWidth, uThreadRows * fRowHeight));
+	}
+	ImGui::End();
+}
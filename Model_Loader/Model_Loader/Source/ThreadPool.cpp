@@ -0,0 +1,217 @@
+// This files header
+#include "ThreadPool.h"
+
+// std includes
+#include <algorithm>
+
+// Statics
+ThreadPool* ThreadPool::s_pInstance = nullptr;
+
+// index of the thread the code is currently running on, 0 for threads the pool does not own
+static thread_local unsigned int s_uThreadIndex = 0;
+// tag of the work the thread is currently doing
+static thread_local unsigned int s_uTaskTag = 0;
+
+/// <summary>
+/// Returns the instance of the thread pool, creating it with one worker per spare hardware thread
+/// </summary>
+ThreadPool* ThreadPool::GetInstance()
+{
+	if (s_pInstance == nullptr)
+	{
+		unsigned int uHardwareThreads = std::thread::hardware_concurrency();
+		// leave the calling thread its own core, it helps out whenever it waits
+		s_pInstance = new ThreadPool(uHardwareThreads > 1 ? uHardwareThreads - 1 : 1);
+	}
+
+	return s_pInstance;
+}
+
+void ThreadPool::DestroyInstance()
+{
+	delete s_pInstance;
+	s_pInstance = nullptr;
+}
+
+unsigned int ThreadPool::GetThreadIndex()
+{
+	return s_uThreadIndex;
+}
+
+void ThreadPool::ClaimThreadIndex()
+{
+	s_uThreadIndex = GetWorkerCount() + 1;
+}
+
+void ThreadPool::SetTaskTag(unsigned int a_uTag)
+{
+	s_uTaskTag = a_uTag;
+}
+
+unsigned int ThreadPool::GetTaskTag()
+{
+	return s_uTaskTag;
+}
+
+// constructor
+ThreadPool::ThreadPool(unsigned int a_uWorkerCount) : m_bShuttingDown(false)
+{
+	for (unsigned int i = 0; i < a_uWorkerCount; i++)
+	{
+		m_axWorkers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i + 1));
+	}
+}
+
+// destructor
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> xLock(m_xQueueMutex);
+		m_bShuttingDown = true;
+	}
+	m_xWakeCondition.notify_all();
+
+	for (std::thread& xWorker : m_axWorkers)
+	{
+		xWorker.join();
+	}
+}
+
+/// <summary>
+/// Adds a task to the queue and wakes a worker to run it
+/// </summary>
+/// <param name="a_xTask"> the work to do </param>
+/// <param name="a_pGroup"> optional group the task counts towards </param>
+void ThreadPool::Submit(std::function<void()> a_xTask, TaskGroup* a_pGroup)
+{
+	if (a_pGroup)
+	{
+		a_pGroup->m_iPendingTasks.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> xLock(m_xQueueMutex);
+		m_axTaskQueue.push_back({ std::move(a_xTask), a_pGroup, s_uTaskTag });
+	}
+	m_xWakeCondition.notify_one();
+	if (a_pGroup)
+	{
+		m_xWaitCondition.notify_all();
+	}
+}
+
+/// <summary>
+/// Waits for a group to finish. The calling thread runs the group's queued tasks in the meantime so that
+/// tasks which wait on other tasks can never starve the pool. Tasks from other groups are left to the workers,
+/// so the render thread never ends up running a step of the simulation, or the other way round
+/// </summary>
+void ThreadPool::Wait(TaskGroup& a_xGroup)
+{
+	auto xFindTask = [&]() { return std::find_if(m_axTaskQueue.begin(), m_axTaskQueue.end(), [&](const Task& xTask) { return xTask.pGroup == &a_xGroup; }); };
+	while (!a_xGroup.IsComplete())
+	{
+		Task xTask;
+		{
+			std::unique_lock<std::mutex> xLock(m_xQueueMutex);
+			std::deque<Task>::iterator xFound;
+			m_xWaitCondition.wait(xLock, [&]() { return (xFound = xFindTask()) != m_axTaskQueue.end() || a_xGroup.IsComplete(); });
+			if (xFound == m_axTaskQueue.end())
+			{
+				continue; // the group finished while we were asleep
+			}
+			xTask = std::move(*xFound);
+			m_axTaskQueue.erase(xFound);
+		}
+		RunTask(xTask);
+	}
+}
+
+/// <summary>
+/// Runs a_xBody over the range in chunks, spread over the workers and the calling thread
+/// </summary>
+/// <param name="a_uCount"> number of items </param>
+/// <param name="a_uGrainSize"> number of items handed out at a time </param>
+/// <param name="a_xBody"> function called with the [begin, end) of each chunk </param>
+void ThreadPool::ParallelFor(unsigned int a_uCount, unsigned int a_uGrainSize, const std::function<void(unsigned int, unsigned int)>& a_xBody)
+{
+	if (a_uCount == 0)
+	{
+		return; // early out
+	}
+
+	a_uGrainSize = std::max(a_uGrainSize, 1u);
+	unsigned int uChunkCount = (a_uCount + a_uGrainSize - 1) / a_uGrainSize;
+
+	// not worth waking anyone for a single chunk
+	if (uChunkCount == 1)
+	{
+		a_xBody(0, a_uCount);
+		return;
+	}
+
+	// chunks are claimed from a shared counter so fast threads pick up the slack of slow ones
+	std::atomic<unsigned int> uNextChunk(0);
+	auto xClaimChunks = [&]()
+	{
+		unsigned int uChunk;
+		while ((uChunk = uNextChunk.fetch_add(1, std::memory_order_relaxed)) < uChunkCount)
+		{
+			unsigned int uBegin = uChunk * a_uGrainSize;
+			a_xBody(uBegin, std::min(uBegin + a_uGrainSize, a_uCount));
+		}
+	};
+
+	// the helpers are submitted from here, so they work under the caller's tag
+	TaskGroup xGroup;
+	unsigned int uHelpers = std::min(GetWorkerCount(), uChunkCount - 1);
+	for (unsigned int i = 0; i < uHelpers; i++)
+	{
+		Submit(xClaimChunks, &xGroup);
+	}
+
+	xClaimChunks();
+	Wait(xGroup);
+}
+
+/// <summary>
+/// Worker threads sleep until there is a task in the queue or the pool is shutting down
+/// </summary>
+void ThreadPool::WorkerLoop(unsigned int a_uThreadIndex)
+{
+	s_uThreadIndex = a_uThreadIndex;
+
+	while (true)
+	{
+		Task xTask;
+		{
+			std::unique_lock<std::mutex> xLock(m_xQueueMutex);
+			m_xWakeCondition.wait(xLock, [this]() { return !m_axTaskQueue.empty() || m_bShuttingDown; });
+			if (m_axTaskQueue.empty())
+			{
+				return; // shutting down with nothing left to do
+			}
+			xTask = std::move(m_axTaskQueue.front());
+			m_axTaskQueue.pop_front();
+		}
+		RunTask(xTask);
+	}
+}
+
+/// <summary>
+/// The task runs under the tag it was submitted with, and the thread goes back to its own after. A thread
+/// helping out in Wait would otherwise run the task under the tag of whatever it was waiting for
+/// </summary>
+void ThreadPool::RunTask(Task& a_xTask)
+{
+	unsigned int uPreviousTag = s_uTaskTag;
+	s_uTaskTag = a_xTask.uTag;
+	a_xTask.xFunction();
+	s_uTaskTag = uPreviousTag;
+
+	if (a_xTask.pGroup && a_xTask.pGroup->m_iPendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		// take the lock so a waiter can't miss the wake up between checking the group and sleeping
+		std::lock_guard<std::mutex> xLock(m_xQueueMutex);
+		m_xWaitCondition.notify_all();
+	}
+}
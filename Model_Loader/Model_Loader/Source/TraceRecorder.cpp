@@ -0,0 +1,105 @@
+// This files header
+#include "TraceRecorder.h"
+
+// std includes
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// names of the tracks as they show in the viewer
+static const char* aszTRACK_NAMES[] = { "", "CPU (render thread)", "GPU" };
+
+// constructor
+TraceRecorder::TraceRecorder() : m_uFrameLimit(0), m_uRecordedFrames(0), m_bRecording(false)
+{
+}
+
+void TraceRecorder::Start(const std::string& a_sPath, unsigned int a_uFrames)
+{
+	m_sPath = a_sPath;
+	m_axEvents.clear();
+	m_uFrameLimit = std::max(a_uFrames, 1u);
+	m_uRecordedFrames = 0;
+	m_bRecording = true;
+}
+
+void TraceRecorder::AddFrame(const GpuProfiler::FrameTimings& a_xFrame)
+{
+	if (!m_bRecording)
+	{
+		return; // early out
+	}
+
+	const std::string sFrame = a_xFrame.xFrame.sName + " " + std::to_string(a_xFrame.uFrame);
+	AddEvent(sFrame, TRACK_CPU, a_xFrame.xFrame.dCpuStartUs, a_xFrame.xFrame.dCpuUs);
+	AddEvent(sFrame, TRACK_GPU, a_xFrame.xFrame.dGpuStartUs, a_xFrame.xFrame.dGpuUs);
+	for (const GpuProfiler::PassTiming& xPass : a_xFrame.axPasses)
+	{
+		AddEvent(xPass.sName, TRACK_CPU, xPass.dCpuStartUs, xPass.dCpuUs);
+		AddEvent(xPass.sName, TRACK_GPU, xPass.dGpuStartUs, xPass.dGpuUs);
+	}
+
+	if (++m_uRecordedFrames >= m_uFrameLimit)
+	{
+		Stop();
+	}
+}
+
+void TraceRecorder::AddEvent(const std::string& a_sName, Track a_eTrack, double a_dStartUs, double a_dDurationUs)
+{
+	Event xEvent;
+	xEvent.sName = a_sName;
+	xEvent.eTrack = a_eTrack;
+	xEvent.dStartUs = a_dStartUs;
+	xEvent.dDurationUs = a_dDurationUs;
+	m_axEvents.push_back(xEvent);
+}
+
+/// <summary>
+/// Each pass is a complete ("X") event. Times are moved to start from the first event so they read
+/// as time into the recording
+/// </summary>
+bool TraceRecorder::Stop()
+{
+	if (!m_bRecording)
+	{
+		return false;
+	}
+	m_bRecording = false;
+
+	std::ofstream xFile(m_sPath);
+	if (!xFile)
+	{
+		std::cout << "Failed to open " << m_sPath << " for writing" << std::endl;
+		return false;
+	}
+
+	double dOriginUs = 0.0;
+	if (!m_axEvents.empty())
+	{
+		dOriginUs = m_axEvents[0].dStartUs;
+		for (const Event& xEvent : m_axEvents)
+		{
+			dOriginUs = std::min(dOriginUs, xEvent.dStartUs);
+		}
+	}
+
+	// the track names first, then the events
+	xFile << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	for (unsigned int uTrack = TRACK_CPU; uTrack <= TRACK_GPU; uTrack++)
+	{
+		xFile << (uTrack == TRACK_CPU ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << uTrack
+			<< ",\"args\":{\"name\":\"" << aszTRACK_NAMES[uTrack] << "\"}}";
+	}
+	for (const Event& xEvent : m_axEvents)
+	{
+		xFile << ",\n{\"name\":\"" << xEvent.sName << "\",\"cat\":\"" << (xEvent.eTrack == TRACK_GPU ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+			<< xEvent.eTrack << ",\"ts\":" << xEvent.dStartUs - dOriginUs << ",\"dur\":" << xEvent.dDurationUs << "}";
+	}
+	xFile << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	std::cout << "Trace of " << m_uRecordedFrames << " frames written to " << m_sPath << std::endl;
+	m_axEvents.clear();
+	return true;
+}
@@ -1,14 +1,64 @@
 // Main.cpp
 #include "Scene.h"
+#include "GpuFlock.h"
+#include "HeadlessContext.h"
+#include "RenderBenchmark.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <glad/glad.h>
+
+#include <cstring>
+#include <iostream>
+
+// the GPU flock validation runs this many boids for this many steps, and fails if any boid ends up further than the tolerance from the CPU
+static const unsigned int uVALIDATION_BOIDS = 2000;
+static const unsigned int uVALIDATION_STEPS = 60;
+static const float fVALIDATION_TOLERANCE = 1e-3f;
+
+/// <summary>
+/// Checks the compute shader flock against the CPU flock core without opening the scene, in a headless context
+/// so it can run on machines without a GPU or a display (Mesa's llvmpipe). Returns the process exit code
+/// </summary>
+static int ValidateGpuFlock()
+{
+	// the check only dispatches compute work, so the smallest framebuffer will do
+	HeadlessContext xContext;
+	if (!xContext.Create(1, 1))
+	{
+		return 1;
+	}
+
+	std::cout << "Validating the GPU flock on " << glGetString(GL_RENDERER) << std::endl;
+	float fMaxError = GpuFlock::CompareWithCpu(uVALIDATION_BOIDS, uVALIDATION_STEPS);
+	bool bPassed = fMaxError >= 0.0f && fMaxError <= fVALIDATION_TOLERANCE;
+	std::cout << (bPassed ? "PASSED" : "FAILED") << ": largest difference from the CPU " << fMaxError << std::endl;
+
+	return bPassed ? 0 : 1;
+}
+
 /// <summary>
 /// Main function called when the program is run
 /// </summary>
-int main()
+int main(int argc, char** argv)
 {
+	if (argc > 1 && std::strcmp(argv[1], "--validate-gpu-flock") == 0)
+	{
+		return ValidateGpuFlock();
+	}
+	// renders a fixed run offscreen and writes the frame timings, for machines with no display
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0)
+	{
+		RenderBenchmark::Options xOptions;
+		if (!RenderBenchmark::ParseArguments(argc - 2, argv + 2, xOptions))
+		{
+			std::cout << "Usage: --benchmark [--frames N] [--warmup N] [--boids N] [--serial] [--csv file] [--png-dir dir] [--png-interval N] [--trace file]" << std::endl;
+			return 1;
+		}
+		return RenderBenchmark::Run(xOptions);
+	}
+
 	Scene* pScene = Scene::GetInstance();
 	if (pScene)
 	{
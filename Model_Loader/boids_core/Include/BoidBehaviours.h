@@ -0,0 +1,386 @@
+#ifndef BOIDBEHAVIOURS_H
+#define BOIDBEHAVIOURS_H
+
+// third party include
+#include <glm/glm.hpp>
+#include <glm/gtc/random.hpp>
+
+// std includes
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// constants
+static const float fSPEED = 0.1f;
+// wander constant
+static const float fCIRCLE_FORWARD_MULTIPLIER = 1.0f;
+static const float fJITTER = 0.5f;
+static const float fWANDER_RADIUS = 4.0f;
+
+// what a behaviour can see of a boid, Vector is a glm::vec of any length and scalar type
+template <typename Vector>
+struct BasicBoidSample
+{
+	Vector vPosition;
+	Vector vVelocity;
+};
+
+// the weighting of each behaviour, a weight of zero switches the behaviour off
+struct FlockWeights
+{
+	float fWander;
+	float fSeparation;
+	float fAlignment;
+	float fCohesion;
+};
+
+// where each behaviour writes its force when a context asks for them, for showing what steers a boid
+enum BEHAVIOUR_SLOT
+{
+	BEHAVIOUR_WANDER,
+	BEHAVIOUR_SEPARATION,
+	BEHAVIOUR_ALIGNMENT,
+	BEHAVIOUR_COHESION,
+	BEHAVIOUR_COUNT
+};
+
+// everything the behaviours need to know about the boid being steered
+template <typename Vector>
+struct BasicBehaviourContext
+{
+	typedef Vector VectorType;
+	typedef BasicBoidSample<Vector> Sample;
+
+	Sample xSelf;
+	Vector vForward;
+	Vector* pWanderPoint;
+	FlockWeights xWeights;
+	// if set, BEHAVIOUR_COUNT vectors that each evaluated behaviour writes its weighted force into. switched off
+	// behaviours leave theirs as they were
+	Vector* pContributions = nullptr;
+};
+
+typedef BasicBoidSample<glm::vec3> BoidSample;
+typedef BasicBehaviourContext<glm::vec3> BehaviourContext;
+
+//-------------------------Shared Steering----------------------------\\
+
+// random point on a circle or sphere, depending on the length of the vector
+template <typename T, glm::qualifier Q>
+glm::vec<2, T, Q> RandomPointOnSphere(const glm::vec<2, T, Q>&, T a_Radius)
+{
+	return glm::vec<2, T, Q>(glm::circularRand(a_Radius));
+}
+
+template <typename T, glm::qualifier Q>
+glm::vec<3, T, Q> RandomPointOnSphere(const glm::vec<3, T, Q>&, T a_Radius)
+{
+	return glm::vec<3, T, Q>(glm::sphericalRand(a_Radius));
+}
+
+/// <summary>
+/// steering force towards a target
+/// </summary>
+template <typename Vector>
+Vector SeekForce(const Vector& vTarget, const Vector& vCurrentPos, const Vector& vCurrentVelocity)
+{
+	typedef typename Vector::value_type Scalar;
+
+	// Calculate target direction
+	Vector vTargetDirection(vTarget - vCurrentPos);
+	if (glm::length(vTarget) > Scalar(0))
+	{
+		vTargetDirection = glm::normalize(vTargetDirection);
+	}
+
+	// Calculate new vel
+	Vector vNewVel = vTargetDirection * Scalar(fSPEED);
+
+	return (vNewVel - vCurrentVelocity);
+}
+
+/// <summary>
+/// moves the wander point around a sphere (or circle in 2D) in front of the boid and seeks towards it
+/// </summary>
+template <typename Vector>
+Vector WanderForce(Vector& vWanderPoint, const Vector& vForward, const Vector& vCurrentPos, const Vector& vCurrentVelocity)
+{
+	typedef typename Vector::value_type Scalar;
+
+	// Project a point in front of it, for the centre of the sphere
+	Vector vSphereOrigin = vCurrentPos + (vForward * Scalar(fCIRCLE_FORWARD_MULTIPLIER));
+
+	if (glm::length(vWanderPoint) == Scalar(0))
+	{
+		// Find random point on a sphere
+		Vector vRandomPointOnSphere = RandomPointOnSphere(vWanderPoint, Scalar(fWANDER_RADIUS));
+
+		// Add the random point to the sphere origin
+		vWanderPoint = vSphereOrigin + vRandomPointOnSphere;
+	}
+
+	// Calculate
+	Vector vDirToTarget = glm::normalize(vWanderPoint - vSphereOrigin) * Scalar(fWANDER_RADIUS);
+
+	// Finding the final target point
+	vWanderPoint = vSphereOrigin + vDirToTarget;
+
+	// Add jitter vector
+	vWanderPoint += RandomPointOnSphere(vWanderPoint, Scalar(fJITTER));
+
+	return SeekForce(vWanderPoint, vCurrentPos, vCurrentVelocity);
+}
+
+//-------------------------Behaviour Policies----------------------------\\
+// Each behaviour keeps an accumulator that is fed every neighbour, then resolves it into a force.
+// Behaviours that don't look at neighbours set bUSES_NEIGHBOURS to false and never see the loop.
+
+/// <summary>
+/// wander around randomly
+/// </summary>
+template <typename Vector>
+struct BasicWanderBehaviour
+{
+	typedef BasicBoidSample<Vector> Sample;
+	typedef BasicBehaviourContext<Vector> Context;
+
+	static const unsigned int uSLOT = BEHAVIOUR_WANDER;
+	static const bool bUSES_NEIGHBOURS = false;
+	struct Accumulator {};
+
+	static float Weight(const FlockWeights& a_xWeights) { return a_xWeights.fWander; }
+	static void Accumulate(Accumulator&, const Sample&, const Sample&) {}
+	static Vector Resolve(const Accumulator&, unsigned int, Context& a_xContext)
+	{
+		return WanderForce(*a_xContext.pWanderPoint, a_xContext.vForward, a_xContext.xSelf.vPosition, a_xContext.xSelf.vVelocity);
+	}
+};
+
+/// <summary>
+/// force of separation from the other boids
+/// </summary>
+template <typename Vector>
+struct BasicSeparationBehaviour
+{
+	typedef BasicBoidSample<Vector> Sample;
+	typedef BasicBehaviourContext<Vector> Context;
+
+	static const unsigned int uSLOT = BEHAVIOUR_SEPARATION;
+	static const bool bUSES_NEIGHBOURS = true;
+	struct Accumulator { Vector vSeparationVel = Vector(0); };
+
+	static float Weight(const FlockWeights& a_xWeights) { return a_xWeights.fSeparation; }
+	static void Accumulate(Accumulator& a_xAccumulator, const Sample& a_xSelf, const Sample& a_xNeighbour)
+	{
+		a_xAccumulator.vSeparationVel += (a_xSelf.vPosition - a_xNeighbour.vPosition);
+	}
+	static Vector Resolve(const Accumulator& a_xAccumulator, unsigned int a_uNeighbourCount, Context&)
+	{
+		typedef typename Vector::value_type Scalar;
+
+		Vector vSeparationVel = a_xAccumulator.vSeparationVel;
+		if (glm::length(vSeparationVel) > Scalar(0))
+		{
+			vSeparationVel /= Scalar(a_uNeighbourCount);
+			vSeparationVel = glm::normalize(vSeparationVel);
+		}
+		return vSeparationVel;
+	}
+};
+
+/// <summary>
+/// force to keep all the boids moving in the same direction
+/// </summary>
+template <typename Vector>
+struct BasicAlignmentBehaviour
+{
+	typedef BasicBoidSample<Vector> Sample;
+	typedef BasicBehaviourContext<Vector> Context;
+
+	static const unsigned int uSLOT = BEHAVIOUR_ALIGNMENT;
+	static const bool bUSES_NEIGHBOURS = true;
+	struct Accumulator { Vector vAllignmentVel = Vector(0); };
+
+	static float Weight(const FlockWeights& a_xWeights) { return a_xWeights.fAlignment; }
+	static void Accumulate(Accumulator& a_xAccumulator, const Sample&, const Sample& a_xNeighbour)
+	{
+		a_xAccumulator.vAllignmentVel += a_xNeighbour.vVelocity;
+	}
+	static Vector Resolve(const Accumulator& a_xAccumulator, unsigned int a_uNeighbourCount, Context&)
+	{
+		typedef typename Vector::value_type Scalar;
+
+		Vector vAllignmentVel = a_xAccumulator.vAllignmentVel;
+		if (glm::length(vAllignmentVel) > Scalar(0))
+		{
+			vAllignmentVel /= Scalar(a_uNeighbourCount);
+			vAllignmentVel = glm::normalize(vAllignmentVel);
+		}
+		return vAllignmentVel;
+	}
+};
+
+/// <summary>
+/// force to keep all the boids grouped together as much as they can be
+/// </summary>
+template <typename Vector>
+struct BasicCohesionBehaviour
+{
+	typedef BasicBoidSample<Vector> Sample;
+	typedef BasicBehaviourContext<Vector> Context;
+
+	static const unsigned int uSLOT = BEHAVIOUR_COHESION;
+	static const bool bUSES_NEIGHBOURS = true;
+	struct Accumulator { Vector vCohesionVel = Vector(0); };
+
+	static float Weight(const FlockWeights& a_xWeights) { return a_xWeights.fCohesion; }
+	static void Accumulate(Accumulator& a_xAccumulator, const Sample&, const Sample& a_xNeighbour)
+	{
+		a_xAccumulator.vCohesionVel += a_xNeighbour.vPosition;
+	}
+	static Vector Resolve(const Accumulator& a_xAccumulator, unsigned int a_uNeighbourCount, Context& a_xContext)
+	{
+		typedef typename Vector::value_type Scalar;
+
+		Vector vCohesionVel = a_xAccumulator.vCohesionVel;
+		if (glm::length(vCohesionVel) > Scalar(0))
+		{
+			vCohesionVel /= Scalar(a_uNeighbourCount);
+			vCohesionVel = glm::normalize(vCohesionVel - a_xContext.xSelf.vPosition);
+		}
+		return vCohesionVel;
+	}
+};
+
+// the behaviours used by the 3D brain component
+typedef BasicWanderBehaviour<glm::vec3> WanderBehaviour;
+typedef BasicSeparationBehaviour<glm::vec3> SeparationBehaviour;
+typedef BasicAlignmentBehaviour<glm::vec3> AlignmentBehaviour;
+typedef BasicCohesionBehaviour<glm::vec3> CohesionBehaviour;
+
+//-------------------------Pipelines----------------------------\\
+
+/// <summary>
+/// A flock type made from a fixed list of behaviours. The accumulation of every behaviour is
+/// expanded inside one neighbour loop, and behaviours that aren't in the list cost nothing
+/// </summary>
+template <typename... Behaviours>
+class FlockPipeline
+{
+public:
+	// the same pipeline with one more behaviour at the front
+	template <typename Behaviour>
+	using Prepend = FlockPipeline<Behaviour, Behaviours...>;
+
+	/// <summary>
+	/// a_xForEachNeighbour(visit) must call visit(const Context::Sample&) for each of the boids neighbours
+	/// </summary>
+	template <typename Context, typename NeighbourVisitor>
+	static typename Context::VectorType Evaluate(Context& a_xContext, NeighbourVisitor& a_xForEachNeighbour)
+	{
+		return EvaluateIndexed(a_xContext, a_xForEachNeighbour, std::index_sequence_for<Behaviours...>());
+	}
+
+private:
+	template <typename Context, typename NeighbourVisitor, size_t... Indices>
+	static typename Context::VectorType EvaluateIndexed(Context& a_xContext, NeighbourVisitor& a_xForEachNeighbour, std::index_sequence<Indices...>)
+	{
+		typedef typename Context::VectorType Vector;
+		typedef typename Context::Sample Sample;
+		typedef typename Vector::value_type Scalar;
+
+		std::tuple<typename Behaviours::Accumulator...> xAccumulators;
+		unsigned int uNeighbourCount = 0;
+
+		// only walk the neighbours if something in the list wants them
+		if (AnyUsesNeighbours())
+		{
+			const Sample& xSelf = a_xContext.xSelf;
+			a_xForEachNeighbour([&](const Sample& a_xNeighbour)
+			{
+				int aiExpand[] = { 0, (Behaviours::Accumulate(std::get<Indices>(xAccumulators), xSelf, a_xNeighbour), 0)... };
+				(void)aiExpand;
+				uNeighbourCount++;
+			});
+		}
+
+		Vector avForces[] = { Vector(0), Behaviours::Resolve(std::get<Indices>(xAccumulators), uNeighbourCount, a_xContext) * Scalar(Behaviours::Weight(a_xContext.xWeights))... };
+		unsigned int auSlots[] = { 0, Behaviours::uSLOT... };
+
+		Vector vFinalForce(0);
+		for (unsigned int i = 1; i < sizeof(avForces) / sizeof(avForces[0]); i++)
+		{
+			vFinalForce += avForces[i];
+			if (a_xContext.pContributions)
+			{
+				a_xContext.pContributions[auSlots[i]] = avForces[i];
+			}
+		}
+
+		return vFinalForce;
+	}
+
+	static constexpr bool AnyUsesNeighbours()
+	{
+		bool abUses[] = { false, Behaviours::bUSES_NEIGHBOURS... };
+		for (bool bUses : abUses)
+		{
+			if (bUses) return true;
+		}
+		return false;
+	}
+};
+
+// picks the behaviours whose bit is set in uMask, bit 0 being the first behaviour in the list
+template <unsigned int uMask, typename... Behaviours>
+struct SelectBehaviours
+{
+	typedef FlockPipeline<> Type;
+};
+
+template <unsigned int uMask, typename Behaviour, typename... Rest>
+struct SelectBehaviours<uMask, Behaviour, Rest...>
+{
+	typedef typename SelectBehaviours<(uMask >> 1), Rest...>::Type Tail;
+	typedef typename std::conditional<(uMask & 1u) != 0, typename Tail::template Prepend<Behaviour>, Tail>::type Type;
+};
+
+/// <summary>
+/// For when the behaviours are switched on and off at runtime (the gui weights). Every combination of
+/// the behaviours is compiled as its own FlockPipeline, and each call jumps to the one matching the
+/// behaviours with a non zero weight, so switched off behaviours still cost nothing
+/// </summary>
+template <typename... Behaviours>
+class RuntimeFlockPipeline
+{
+public:
+	static const unsigned int uCOMBINATIONS = 1u << sizeof...(Behaviours);
+
+	// returns the bit mask of behaviours with a non zero weight
+	static unsigned int EnabledMask(const FlockWeights& a_xWeights)
+	{
+		unsigned int uMask = 0;
+		unsigned int uBit = 1;
+		int aiExpand[] = { 0, ((uMask |= (Behaviours::Weight(a_xWeights) != 0.0f ? uBit : 0u)), (uBit <<= 1), 0)... };
+		(void)aiExpand;
+		return uMask;
+	}
+
+	template <typename Context, typename NeighbourVisitor>
+	static typename Context::VectorType Evaluate(Context& a_xContext, NeighbourVisitor& a_xForEachNeighbour)
+	{
+		return Dispatch(EnabledMask(a_xContext.xWeights), a_xContext, a_xForEachNeighbour, std::make_integer_sequence<unsigned int, uCOMBINATIONS>());
+	}
+
+private:
+	template <typename Context, typename NeighbourVisitor, unsigned int... Masks>
+	static typename Context::VectorType Dispatch(unsigned int a_uMask, Context& a_xContext, NeighbourVisitor& a_xForEachNeighbour, std::integer_sequence<unsigned int, Masks...>)
+	{
+		typedef typename Context::VectorType(*EvaluateFunction)(Context&, NeighbourVisitor&);
+		static const EvaluateFunction s_apTable[] = { &SelectBehaviours<Masks, Behaviours...>::Type::template Evaluate<Context, NeighbourVisitor>... };
+
+		return s_apTable[a_uMask](a_xContext, a_xForEachNeighbour);
+	}
+};
+
+#endif // !BOIDBEHAVIOURS_H
@@ -0,0 +1,62 @@
+#ifndef BOIDSCORE_H
+#define BOIDSCORE_H
+
+// std includes
+#include <stddef.h>
+
+// C interface to the flock core, for stepping flocks from outside the app. The flock is stepped
+// in place on the callers position and velocity arrays, which may be interleaved with other data
+// as long as each boid is a fixed stride from the last. C++ callers can use FlockWorkspace directly
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum BoidsResult
+{
+	BOIDS_OK = 0,
+	BOIDS_ERROR_INVALID_ARGUMENT,
+	// the flock or the neighbour grid has outgrown the workspace
+	BOIDS_ERROR_CAPACITY,
+	BOIDS_ERROR_OUT_OF_MEMORY,
+} BoidsResult;
+
+// the values a flock is stepped with, Boids_DefaultParams fills in the same defaults as the app
+typedef struct BoidsFlockParams
+{
+	float fWanderWeight;
+	float fSeparationWeight;
+	float fAlignmentWeight;
+	float fCohesionWeight;
+	float fNeighbourhoodRadius;
+	float fBoundsSize;
+	float fMaxSpeed;
+	// the box the boids steer around, a 2D flock only uses the first two
+	float afObstacle[3];
+} BoidsFlockParams;
+
+// the memory a flock is stepped with, sized up front so stepping never allocates
+typedef struct BoidsWorkspace BoidsWorkspace;
+
+void Boids_DefaultParams(BoidsFlockParams* a_pParams);
+
+// creates a workspace for up to a_uMaxBoids boids of 2 or 3 dimensions stepped with these params.
+// returns NULL if the arguments are invalid (the radius and bounds have to be finite and above zero, and
+// not so far apart that the neighbour grid gets too big) or the memory can't be allocated
+BoidsWorkspace* Boids_CreateWorkspace(unsigned int a_uDimensions, unsigned int a_uMaxBoids, const BoidsFlockParams* a_pParams);
+void Boids_DestroyWorkspace(BoidsWorkspace* a_pWorkspace);
+
+// steps a_uCount boids in place. positions and velocities are tightly packed floats, one vector of the
+// workspace dimension per boid, with a_uPositionStride / a_uVelocityStride bytes from one boid to the next.
+// boids should keep the same index between steps as the workspace remembers each ones wander point.
+// params the workspace couldn't be created with are BOIDS_ERROR_INVALID_ARGUMENT
+BoidsResult Boids_StepFlock(BoidsWorkspace* a_pWorkspace,
+	float* a_pfPositions, size_t a_uPositionStride,
+	float* a_pfVelocities, size_t a_uVelocityStride,
+	unsigned int a_uCount, float a_fDeltaTime, const BoidsFlockParams* a_pParams);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !BOIDSCORE_H
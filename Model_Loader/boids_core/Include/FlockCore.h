@@ -0,0 +1,507 @@
+#ifndef FLOCKCORE_H
+#define FLOCKCORE_H
+
+// Project Includes
+#include "BoidBehaviours.h"
+
+// third party include
+#include <glm/glm.hpp>
+
+// std includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// the values the flock is stepped with, these match the brain component defaults
+struct FlockSettings
+{
+	FlockWeights xWeights = { 0.5f, 0.5f, 0.5f, 0.5f };
+	float fNeighbourhoodRadius = 5.0f;
+	float fBoundsSize = 4.0f;
+	float fEarlySeparationDist = 0.5f;
+	float fBoundsFleeForce = 1.25f;
+	float fMaxSpeed = 1.0f;
+	// the box the boids steer around, a 2D flock only uses x and y
+	glm::vec3 v3Obstacle = glm::vec3(0.0f);
+	float fObstacleSize = 0.5f;
+	float fObstacleRadius = 1.0f;
+	// the brain component adds an unweighted wander on top of the weighted one. turning it off (along
+	// with the wander weight) takes the randomness out of a step, so other backends can be checked against it
+	bool bExtraWander = true;
+	// the forces are worked out for one of this many groups of boids each step, in turn, and the rest keep
+	// the velocity they have. the app's boids go in 50 groups, 1 works every boid out every step
+	unsigned int uForceGroups = 1;
+};
+
+//-------------------------Movement----------------------------\\
+// Everything that moves a boid once its forces are known. FlockWorkspace and the brain component both
+// step through these, so a boid moves the same whichever of them steps it
+
+/// <summary>
+/// pushes the boid away from the wall it is furthest into, checking each axis the same way
+/// </summary>
+template <typename Vector>
+Vector BoundsFleeForce(const Vector& a_vPosition, const FlockSettings& a_xSettings)
+{
+	typedef typename Vector::value_type Scalar;
+
+	Vector vBoundsFleeForce(0);
+
+	Scalar fLimit = Scalar(a_xSettings.fBoundsSize - a_xSettings.fEarlySeparationDist);
+	int iClosestAxis = -1;
+	for (glm::length_t iAxis = 0; iAxis < Vector::length(); iAxis++)
+	{
+		// only one wall is fled from at a time, the one the boid is furthest into
+		if (std::abs(a_vPosition[iAxis]) > fLimit &&
+			(iClosestAxis < 0 || std::abs(a_vPosition[iAxis]) > std::abs(a_vPosition[iClosestAxis])))
+		{
+			iClosestAxis = static_cast<int>(iAxis);
+		}
+	}
+
+	if (iClosestAxis >= 0)
+	{
+		vBoundsFleeForce[iClosestAxis] = a_vPosition[iClosestAxis] > Scalar(0) ? -Scalar(a_xSettings.fBoundsFleeForce) : Scalar(a_xSettings.fBoundsFleeForce);
+	}
+
+	return vBoundsFleeForce;
+}
+
+/// <summary>
+/// pushes the boid away from the obstacle while it is within the obstacle's radius, as hard as it separates
+/// </summary>
+template <typename Vector>
+Vector AvoidObstacleForce(const Vector& a_vPosition, const Vector& a_vObstacle, const FlockSettings& a_xSettings)
+{
+	typedef typename Vector::value_type Scalar;
+
+	// Calculate target direction
+	Vector vTargetDirection(a_vPosition - a_vObstacle);
+	if (glm::length(a_vObstacle) > Scalar(0))
+	{
+		vTargetDirection = glm::normalize(vTargetDirection);
+	}
+
+	// if the boid is in a certain range of the obstacle, give it a force to move away
+	Scalar fDistance = glm::distance(a_vPosition, a_vObstacle);
+	if (fDistance > Scalar(a_xSettings.fObstacleSize) && fDistance < Scalar(a_xSettings.fObstacleRadius))
+	{
+		return vTargetDirection * Scalar(a_xSettings.xWeights.fSeparation);
+	}
+
+	return Vector(0);
+}
+
+// adds the behaviours' force to the velocity, on the steps the boid's forces are worked out
+template <typename Vector>
+void ApplyBehaviourForce(Vector& a_vVelocity, const Vector& a_vForce, float a_fDeltaTime)
+{
+	typedef typename Vector::value_type Scalar;
+
+	a_vVelocity += a_vForce * Scalar(a_fDeltaTime / 2);
+}
+
+/// <summary>
+/// every step, whether or not the forces were worked out: flees the bounds, avoids the obstacle, clamps the
+/// velocity to the max speed and moves the boid by it
+/// </summary>
+template <typename Vector>
+void MoveBoid(Vector& a_vPosition, Vector& a_vVelocity, const Vector& a_vObstacle, const FlockSettings& a_xSettings)
+{
+	typedef typename Vector::value_type Scalar;
+
+	// Apply force
+	a_vVelocity += BoundsFleeForce(a_vPosition, a_xSettings);
+	a_vVelocity += AvoidObstacleForce(a_vPosition, a_vObstacle, a_xSettings);
+
+	// Clamp Vel
+	const Vector vMaxVel(Scalar(0.02f * a_xSettings.fMaxSpeed));
+	a_vVelocity = glm::clamp(a_vVelocity, -vMaxVel, vMaxVel);
+
+	// Apply vel to position
+	a_vPosition += a_vVelocity;
+}
+
+// whether boid a_uIndex has its forces worked out on a step that works out group a_uGroup (from 0), with
+// a_uGroupSize boids to a group in the order they are stepped
+inline bool InForceGroup(unsigned int a_uIndex, unsigned int a_uGroup, unsigned int a_uGroupSize)
+{
+	return a_uIndex / std::max(a_uGroupSize, 1u) == a_uGroup;
+}
+
+/// <summary>
+/// A view over memory owned by someone else, where each element sits a fixed number of bytes after
+/// the last. Lets the flock step arrays of structs in place without copying the positions out
+/// </summary>
+template <typename Element>
+class StridedSpan
+{
+public:
+	StridedSpan() : m_pData(nullptr), m_uStride(sizeof(Element)), m_uCount(0) {}
+	StridedSpan(Element* a_pData, unsigned int a_uCount, size_t a_uStride = sizeof(Element)) : m_pData(reinterpret_cast<unsigned char*>(a_pData)), m_uStride(a_uStride), m_uCount(a_uCount) {}
+
+	Element& operator[](unsigned int a_uIndex) const { return *reinterpret_cast<Element*>(m_pData + a_uIndex * m_uStride); }
+	unsigned int GetCount() const { return m_uCount; }
+
+private:
+	unsigned char* m_pData;
+	size_t m_uStride;
+	unsigned int m_uCount;
+};
+
+/// <summary>
+/// Everything stepping a flock needs besides the positions and velocities: the wander points that
+/// carry over between steps, the forces, and the neighbour grid. Reserve sizes it up front so that
+/// stepping never allocates. D is the number of dimensions (2 for planar crowds, 3 for the full flock)
+/// and T the scalar type. A 2D flock moves two thirds of the data of a 3D one, and its neighbour
+/// search only has to look in 9 grid cells instead of 27
+/// </summary>
+template <glm::length_t D, typename T>
+class FlockWorkspace
+{
+public:
+	typedef glm::vec<D, T> Vector;
+	typedef BasicBehaviourContext<Vector> Context;
+	typedef BasicBoidSample<Vector> Sample;
+	typedef RuntimeFlockPipeline<BasicWanderBehaviour<Vector>, BasicSeparationBehaviour<Vector>, BasicAlignmentBehaviour<Vector>, BasicCohesionBehaviour<Vector>> Pipeline;
+
+	// vectors are read straight out of the callers buffers so they have to be tightly packed scalars
+	static_assert(sizeof(Vector) == D * sizeof(T), "flock vectors must be tightly packed");
+
+	// number of grid cells searched around each boid, 3 to the power of D
+	static const unsigned int uSTENCIL_SIZE = (D == 1 ? 3 : (D == 2 ? 9 : 27));
+	// the most cells the neighbour grid can have, settings that need more are refused rather than allocated
+	static const unsigned int uMAX_GRID_CELLS = 1u << 24;
+
+	FlockWorkspace() : m_uCapacity(0), m_uForceGroup(0), m_uCellsPerAxis(1), m_fCellSize(1.0f), m_fGridMin(0.0f) {}
+
+	/// <summary>
+	/// makes room for a flock of up to a_uMaxBoids stepped with these settings, only ever grows. Returns
+	/// false without growing anything if the settings can't be stepped
+	/// </summary>
+	bool Reserve(unsigned int a_uMaxBoids, const FlockSettings& a_xSettings)
+	{
+		if (!IsValid(a_xSettings))
+		{
+			return false; // early out
+		}
+
+		if (a_uMaxBoids > m_uCapacity)
+		{
+			m_uCapacity = a_uMaxBoids;
+			m_avWanderPoints.resize(m_uCapacity, Vector(0));
+			m_avForces.resize(m_uCapacity, Vector(0));
+			m_auBoidCells.resize(m_uCapacity, 0);
+			m_auSortedBoids.resize(m_uCapacity, 0);
+		}
+
+		unsigned int uCellCount = GridCellCount(a_xSettings);
+		if (m_auCellStart.size() < uCellCount + 1)
+		{
+			m_auCellStart.resize(uCellCount + 1, 0);
+			m_auCellFill.resize(uCellCount, 0);
+		}
+		return true;
+	}
+
+	// returns true if the workspace can step this many boids with these settings without allocating
+	bool CanStep(unsigned int a_uCount, const FlockSettings& a_xSettings) const
+	{
+		return IsValid(a_xSettings) && a_uCount <= m_uCapacity && GridCellCount(a_xSettings) + 1 <= m_auCellStart.size();
+	}
+
+	// the point each boid is wandering towards, kept between steps
+	Vector& GetWanderPoint(unsigned int a_uIndex) { return m_avWanderPoints[a_uIndex]; }
+
+	/// <summary>
+	/// Works out the forces on this step's group of boids and then moves them all in place, the same way the
+	/// brain component does. Returns false without touching anything if the workspace hasn't been reserved
+	/// big enough
+	/// </summary>
+	bool Step(const StridedSpan<Vector>& a_xPositions, const StridedSpan<Vector>& a_xVelocities, float a_fDeltaTime, const FlockSettings& a_xSettings)
+	{
+		const unsigned int uCount = a_xPositions.GetCount();
+		if (a_xVelocities.GetCount() != uCount || !CanStep(uCount, a_xSettings))
+		{
+			return false; // early out
+		}
+
+		BuildGrid(a_xPositions, a_xSettings);
+
+		Vector vObstacle;
+		for (glm::length_t iAxis = 0; iAxis < D; iAxis++)
+		{
+			vObstacle[iAxis] = T(a_xSettings.v3Obstacle[iAxis]);
+		}
+
+		// the groups split the boids the same way the app's force system does
+		const unsigned int uGroups = std::max(a_xSettings.uForceGroups, 1u);
+		const unsigned int uGroupSize = std::max(uCount / uGroups, 1u);
+		m_uForceGroup %= uGroups;
+		for (unsigned int i = 0; i < uCount; i++)
+		{
+			bool bInGroup = InForceGroup(i, m_uForceGroup, uGroupSize);
+			m_avForces[i] = bInGroup ? CalculateForces(i, a_xPositions, a_xVelocities, a_xSettings) : Vector(0);
+		}
+		m_uForceGroup++;
+
+		for (unsigned int i = 0; i < uCount; i++)
+		{
+			ApplyBehaviourForce(a_xVelocities[i], m_avForces[i], a_fDeltaTime);
+			MoveBoid(a_xPositions[i], a_xVelocities[i], vObstacle, a_xSettings);
+		}
+
+		return true;
+	}
+
+	// the direction a boid is facing, taken from its velocity
+	static Vector Forward(const Vector& a_vVelocity)
+	{
+		return glm::length(a_vVelocity) > T(0) ? glm::normalize(a_vVelocity) : Vector(0);
+	}
+
+	// the grid covers the bounds plus the flee margin, anything outside is clamped to the edge cells.
+	// these are public so other backends (GpuFlock) build the same grid
+	static unsigned int CellsPerAxis(const FlockSettings& a_xSettings)
+	{
+		// worked out in double and capped, so a huge bounds or a tiny radius can't overflow the cast
+		double dExtent = static_cast<double>(a_xSettings.fBoundsSize) + a_xSettings.fEarlySeparationDist;
+		double dCells = std::ceil((2.0 * dExtent) / CellSize(a_xSettings));
+		if (!(dCells >= 1.0))
+		{
+			return 1u;
+		}
+		return dCells > uMAX_GRID_CELLS ? uMAX_GRID_CELLS + 1 : static_cast<unsigned int>(dCells);
+	}
+
+	static float CellSize(const FlockSettings& a_xSettings)
+	{
+		return std::max(a_xSettings.fNeighbourhoodRadius, 0.001f);
+	}
+
+	// the cells in the grid, or uMAX_GRID_CELLS + 1 if there would be more than uMAX_GRID_CELLS
+	static unsigned int GridCellCount(const FlockSettings& a_xSettings)
+	{
+		unsigned long long uCellCount = 1;
+		for (glm::length_t iAxis = 0; iAxis < D; iAxis++)
+		{
+			uCellCount *= CellsPerAxis(a_xSettings);
+			if (uCellCount > uMAX_GRID_CELLS)
+			{
+				return uMAX_GRID_CELLS + 1;
+			}
+		}
+		return static_cast<unsigned int>(uCellCount);
+	}
+
+	// whether a flock can be stepped with these settings at all, the radius and the bounds have to be
+	// finite and above zero and the grid no bigger than uMAX_GRID_CELLS
+	static bool IsValid(const FlockSettings& a_xSettings)
+	{
+		return std::isfinite(a_xSettings.fNeighbourhoodRadius) && a_xSettings.fNeighbourhoodRadius > 0.0f &&
+			std::isfinite(a_xSettings.fBoundsSize) && a_xSettings.fBoundsSize > 0.0f &&
+			std::isfinite(a_xSettings.fEarlySeparationDist) && a_xSettings.fEarlySeparationDist >= 0.0f &&
+			GridCellCount(a_xSettings) <= uMAX_GRID_CELLS;
+	}
+
+private:
+	/// <summary>
+	/// Buckets the boids into a uniform grid with cells the size of the neighbourhood, using a counting
+	/// sort so the boids in each cell sit next to each other in m_auSortedBoids
+	/// </summary>
+	void BuildGrid(const StridedSpan<Vector>& a_xPositions, const FlockSettings& a_xSettings)
+	{
+		m_fCellSize = CellSize(a_xSettings);
+		m_fGridMin = -(a_xSettings.fBoundsSize + a_xSettings.fEarlySeparationDist);
+		m_uCellsPerAxis = CellsPerAxis(a_xSettings);
+
+		const unsigned int uCellCount = GridCellCount(a_xSettings);
+		std::fill(m_auCellStart.begin(), m_auCellStart.begin() + uCellCount + 1, 0u);
+
+		// count the boids in each cell
+		for (unsigned int i = 0; i < a_xPositions.GetCount(); i++)
+		{
+			m_auBoidCells[i] = CellIndex(CellCoord(a_xPositions[i]));
+			m_auCellStart[m_auBoidCells[i] + 1]++;
+		}
+
+		// turn the counts into where each cell starts
+		for (unsigned int uCell = 0; uCell < uCellCount; uCell++)
+		{
+			m_auCellStart[uCell + 1] += m_auCellStart[uCell];
+		}
+
+		// place the boids, m_auCellFill tracks how far through each cell we are
+		std::copy(m_auCellStart.begin(), m_auCellStart.begin() + uCellCount, m_auCellFill.begin());
+		for (unsigned int i = 0; i < a_xPositions.GetCount(); i++)
+		{
+			m_auSortedBoids[m_auCellFill[m_auBoidCells[i]]++] = i;
+		}
+	}
+
+	glm::vec<D, int> CellCoord(const Vector& a_vPosition) const
+	{
+		glm::vec<D, int> viCoord;
+		for (glm::length_t iAxis = 0; iAxis < D; iAxis++)
+		{
+			int iCell = static_cast<int>(std::floor((static_cast<float>(a_vPosition[iAxis]) - m_fGridMin) / m_fCellSize));
+			viCoord[iAxis] = std::min(std::max(iCell, 0), static_cast<int>(m_uCellsPerAxis) - 1);
+		}
+		return viCoord;
+	}
+
+	unsigned int CellIndex(const glm::vec<D, int>& a_viCoord) const
+	{
+		unsigned int uIndex = 0;
+		for (glm::length_t iAxis = D; iAxis-- > 0;)
+		{
+			uIndex = uIndex * m_uCellsPerAxis + static_cast<unsigned int>(a_viCoord[iAxis]);
+		}
+		return uIndex;
+	}
+
+	Vector CalculateForces(unsigned int a_uIndex, const StridedSpan<Vector>& a_xPositions, const StridedSpan<Vector>& a_xVelocities, const FlockSettings& a_xSettings)
+	{
+		Context xContext;
+		xContext.xSelf.vPosition = a_xPositions[a_uIndex];
+		xContext.xSelf.vVelocity = a_xVelocities[a_uIndex];
+		xContext.vForward = Forward(xContext.xSelf.vVelocity);
+		xContext.pWanderPoint = &m_avWanderPoints[a_uIndex];
+		xContext.xWeights = a_xSettings.xWeights;
+
+		const T fRadius = T(a_xSettings.fNeighbourhoodRadius);
+		const glm::vec<D, int> viCentre = CellCoord(xContext.xSelf.vPosition);
+
+		// visits the boids within the neighbourhood, only looking in the cells around our own
+		auto xForEachNeighbour = [&](auto&& a_xVisit)
+		{
+			for (unsigned int uStencil = 0; uStencil < uSTENCIL_SIZE; uStencil++)
+			{
+				// each digit of uStencil in base 3 is the offset along one axis
+				glm::vec<D, int> viCell;
+				bool bInside = true;
+				unsigned int uDigits = uStencil;
+				for (glm::length_t iAxis = 0; iAxis < D; iAxis++)
+				{
+					viCell[iAxis] = viCentre[iAxis] + static_cast<int>(uDigits % 3) - 1;
+					uDigits /= 3;
+					bInside = bInside && viCell[iAxis] >= 0 && viCell[iAxis] < static_cast<int>(m_uCellsPerAxis);
+				}
+				if (!bInside)
+				{
+					continue;
+				}
+
+				unsigned int uCell = CellIndex(viCell);
+				for (unsigned int uSlot = m_auCellStart[uCell]; uSlot < m_auCellStart[uCell + 1]; uSlot++)
+				{
+					unsigned int uOther = m_auSortedBoids[uSlot];
+					if (uOther == a_uIndex || glm::length(a_xPositions[uOther] - xContext.xSelf.vPosition) >= fRadius)
+					{
+						continue;
+					}
+
+					Sample xNeighbour;
+					xNeighbour.vPosition = a_xPositions[uOther];
+					xNeighbour.vVelocity = a_xVelocities[uOther];
+					a_xVisit(xNeighbour);
+				}
+			}
+		};
+
+		Vector vFinalForce = Pipeline::Evaluate(xContext, xForEachNeighbour);
+
+		// the brain component adds a second unweighted wander on top of the weighted behaviours
+		if (a_xSettings.bExtraWander)
+		{
+			vFinalForce += WanderForce(m_avWanderPoints[a_uIndex], xContext.vForward, xContext.xSelf.vPosition, xContext.xSelf.vVelocity);
+		}
+
+		return vFinalForce;
+	}
+
+	unsigned int m_uCapacity;
+	// the group whose forces are worked out next step
+	unsigned int m_uForceGroup;
+	std::vector<Vector> m_avWanderPoints;
+	std::vector<Vector> m_avForces;
+
+	// neighbour grid, rebuilt every step
+	std::vector<unsigned int> m_auBoidCells;
+	std::vector<unsigned int> m_auSortedBoids;
+	std::vector<unsigned int> m_auCellStart;
+	std::vector<unsigned int> m_auCellFill;
+	unsigned int m_uCellsPerAxis;
+	float m_fCellSize;
+	float m_fGridMin;
+};
+
+/// <summary>
+/// A flock that owns its own arrays, for when there isn't a caller buffer to step in place
+/// </summary>
+template <glm::length_t D, typename T>
+class FlockCore
+{
+public:
+	typedef glm::vec<D, T> Vector;
+
+	// changes the number of boids, new boids start at the origin and stood still
+	void Resize(unsigned int a_uCount)
+	{
+		m_avPositions.resize(a_uCount, Vector(0));
+		m_avVelocities.resize(a_uCount, Vector(0));
+		m_xWorkspace.Reserve(a_uCount, FlockSettings());
+	}
+
+	unsigned int GetCount() const { return static_cast<unsigned int>(m_avPositions.size()); }
+
+	// sets the position and velocity of a boid, its wander point starts again
+	void SetBoid(unsigned int a_uIndex, const Vector& a_vPosition, const Vector& a_vVelocity)
+	{
+		m_avPositions[a_uIndex] = a_vPosition;
+		m_avVelocities[a_uIndex] = a_vVelocity;
+		m_xWorkspace.GetWanderPoint(a_uIndex) = Vector(0);
+	}
+
+	const Vector& GetPosition(unsigned int a_uIndex) const { return m_avPositions[a_uIndex]; }
+	const Vector& GetVelocity(unsigned int a_uIndex) const { return m_avVelocities[a_uIndex]; }
+	Vector GetForward(unsigned int a_uIndex) const { return FlockWorkspace<D, T>::Forward(m_avVelocities[a_uIndex]); }
+
+	// steps the flock, growing the workspace first if the settings need a bigger grid. settings that can't
+	// be stepped leave the flock where it is
+	void Step(float a_fDeltaTime, const FlockSettings& a_xSettings)
+	{
+		if (!m_xWorkspace.Reserve(GetCount(), a_xSettings))
+		{
+			return; // early out
+		}
+		m_xWorkspace.Step(StridedSpan<Vector>(m_avPositions.data(), GetCount()), StridedSpan<Vector>(m_avVelocities.data(), GetCount()), a_fDeltaTime, a_xSettings);
+	}
+
+private:
+	std::vector<Vector> m_avPositions;
+	std::vector<Vector> m_avVelocities;
+	FlockWorkspace<D, T> m_xWorkspace;
+};
+
+typedef FlockCore<2, float> FlockCore2f;
+typedef FlockCore<3, float> FlockCore3f;
+typedef FlockCore<2, double> FlockCore2d;
+typedef FlockCore<3, double> FlockCore3d;
+
+//-------------------------Rendering----------------------------\\
+
+// puts a flock position into the 3D world, 2D flocks lie flat on the XZ plane
+template <typename T>
+glm::vec3 LiftToWorld(const glm::vec<2, T>& a_vVector)
+{
+	return glm::vec3(static_cast<float>(a_vVector.x), 0.0f, static_cast<float>(a_vVector.y));
+}
+
+template <typename T>
+glm::vec3 LiftToWorld(const glm::vec<3, T>& a_vVector)
+{
+	return glm::vec3(a_vVector);
+}
+
+#endif // !FLOCKCORE_H
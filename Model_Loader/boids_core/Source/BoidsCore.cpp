@@ -0,0 +1,150 @@
+// This files header
+#include "BoidsCore.h"
+
+// Project Includes
+#include "FlockCore.h"
+
+// std includes
+#include <new>
+
+// the C workspace is whichever of the float workspaces matches its dimensions
+struct BoidsWorkspace
+{
+	unsigned int uDimensions;
+	FlockWorkspace<2, float> x2D;
+	FlockWorkspace<3, float> x3D;
+};
+
+// converts the C params into the settings used by the flock core
+static FlockSettings ToSettings(const BoidsFlockParams& a_xParams)
+{
+	FlockSettings xSettings;
+	xSettings.xWeights.fWander = a_xParams.fWanderWeight;
+	xSettings.xWeights.fSeparation = a_xParams.fSeparationWeight;
+	xSettings.xWeights.fAlignment = a_xParams.fAlignmentWeight;
+	xSettings.xWeights.fCohesion = a_xParams.fCohesionWeight;
+	xSettings.fNeighbourhoodRadius = a_xParams.fNeighbourhoodRadius;
+	xSettings.fBoundsSize = a_xParams.fBoundsSize;
+	xSettings.fMaxSpeed = a_xParams.fMaxSpeed;
+	xSettings.v3Obstacle = glm::vec3(a_xParams.afObstacle[0], a_xParams.afObstacle[1], a_xParams.afObstacle[2]);
+	return xSettings;
+}
+
+// steps one of the workspaces over the callers buffers
+template <glm::length_t D>
+static BoidsResult StepFlock(FlockWorkspace<D, float>& a_xWorkspace, float* a_pfPositions, size_t a_uPositionStride,
+	float* a_pfVelocities, size_t a_uVelocityStride, unsigned int a_uCount, float a_fDeltaTime, const FlockSettings& a_xSettings)
+{
+	typedef glm::vec<D, float> Vector;
+
+	if (!FlockWorkspace<D, float>::IsValid(a_xSettings))
+	{
+		return BOIDS_ERROR_INVALID_ARGUMENT;
+	}
+	if (!a_xWorkspace.CanStep(a_uCount, a_xSettings))
+	{
+		return BOIDS_ERROR_CAPACITY;
+	}
+
+	StridedSpan<Vector> xPositions(reinterpret_cast<Vector*>(a_pfPositions), a_uCount, a_uPositionStride);
+	StridedSpan<Vector> xVelocities(reinterpret_cast<Vector*>(a_pfVelocities), a_uCount, a_uVelocityStride);
+	a_xWorkspace.Step(xPositions, xVelocities, a_fDeltaTime, a_xSettings);
+
+	return BOIDS_OK;
+}
+
+void Boids_DefaultParams(BoidsFlockParams* a_pParams)
+{
+	if (!a_pParams)
+	{
+		return; // early out
+	}
+
+	FlockSettings xDefaults;
+	a_pParams->fWanderWeight = xDefaults.xWeights.fWander;
+	a_pParams->fSeparationWeight = xDefaults.xWeights.fSeparation;
+	a_pParams->fAlignmentWeight = xDefaults.xWeights.fAlignment;
+	a_pParams->fCohesionWeight = xDefaults.xWeights.fCohesion;
+	a_pParams->fNeighbourhoodRadius = xDefaults.fNeighbourhoodRadius;
+	a_pParams->fBoundsSize = xDefaults.fBoundsSize;
+	a_pParams->fMaxSpeed = xDefaults.fMaxSpeed;
+	a_pParams->afObstacle[0] = 0.0f;
+	a_pParams->afObstacle[1] = 0.0f;
+	a_pParams->afObstacle[2] = 0.0f;
+}
+
+/// <summary>
+/// All of the workspace memory is allocated here so that stepping doesn't have to. Nothing is allowed to
+/// throw back through the C interface, so running out of memory gives NULL too
+/// </summary>
+BoidsWorkspace* Boids_CreateWorkspace(unsigned int a_uDimensions, unsigned int a_uMaxBoids, const BoidsFlockParams* a_pParams)
+{
+	if ((a_uDimensions != 2 && a_uDimensions != 3) || !a_pParams)
+	{
+		return nullptr;
+	}
+
+	BoidsWorkspace* pWorkspace = nullptr;
+	try
+	{
+		pWorkspace = new BoidsWorkspace();
+		pWorkspace->uDimensions = a_uDimensions;
+		bool bReserved = a_uDimensions == 2 ? pWorkspace->x2D.Reserve(a_uMaxBoids, ToSettings(*a_pParams)) : pWorkspace->x3D.Reserve(a_uMaxBoids, ToSettings(*a_pParams));
+		if (!bReserved)
+		{
+			delete pWorkspace;
+			return nullptr;
+		}
+	}
+	catch (...)
+	{
+		delete pWorkspace;
+		return nullptr;
+	}
+
+	return pWorkspace;
+}
+
+void Boids_DestroyWorkspace(BoidsWorkspace* a_pWorkspace)
+{
+	delete a_pWorkspace;
+}
+
+/// <summary>
+/// Steps the flock in place. Nothing is copied or allocated, the callers buffers are read and written
+/// through strided views
+/// </summary>
+BoidsResult Boids_StepFlock(BoidsWorkspace* a_pWorkspace, float* a_pfPositions, size_t a_uPositionStride,
+	float* a_pfVelocities, size_t a_uVelocityStride, unsigned int a_uCount, float a_fDeltaTime, const BoidsFlockParams* a_pParams)
+{
+	if (!a_pWorkspace || !a_pParams || (a_uCount > 0 && (!a_pfPositions || !a_pfVelocities)))
+	{
+		return BOIDS_ERROR_INVALID_ARGUMENT;
+	}
+
+	// each boid has to have room for a whole vector
+	size_t uVectorSize = a_pWorkspace->uDimensions * sizeof(float);
+	if (a_uPositionStride < uVectorSize || a_uVelocityStride < uVectorSize)
+	{
+		return BOIDS_ERROR_INVALID_ARGUMENT;
+	}
+
+	// stepping doesn't allocate, but nothing is allowed to throw back through the C interface either way
+	try
+	{
+		FlockSettings xSettings = ToSettings(*a_pParams);
+		if (a_pWorkspace->uDimensions == 2)
+		{
+			return StepFlock(a_pWorkspace->x2D, a_pfPositions, a_uPositionStride, a_pfVelocities, a_uVelocityStride, a_uCount, a_fDeltaTime, xSettings);
+		}
+		return StepFlock(a_pWorkspace->x3D, a_pfPositions, a_uPositionStride, a_pfVelocities, a_uVelocityStride, a_uCount, a_fDeltaTime, xSettings);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return BOIDS_ERROR_OUT_OF_MEMORY;
+	}
+	catch (...)
+	{
+		return BOIDS_ERROR_INVALID_ARGUMENT;
+	}
+}
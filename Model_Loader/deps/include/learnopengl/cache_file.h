@@ -0,0 +1,80 @@
+#ifndef CACHE_FILE_H
+#define CACHE_FILE_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+using namespace std;
+
+// Writes a cache file through a temporary file next to it, which replaces the old cache only once it is complete.
+// A crash part way through leaves the old cache or none rather than a truncated one, and two loader threads
+// writing the same cache each write their own file, the last one to finish is the one kept
+class CacheFileWriter
+{
+public:
+    CacheFileWriter(const string& path) : path(path), tempPath(path + "." + uniqueName() + ".tmp"), out(tempPath, ios::binary | ios::trunc) {}
+    ~CacheFileWriter()
+    {
+        if (!committed)
+        {
+            out.close();
+            remove(tempPath.c_str());
+        }
+    }
+
+    ofstream& stream() { return out; }
+
+    // closes the temporary file and moves it over the cache, false if anything went wrong on the way
+    bool commit()
+    {
+        out.close();
+        committed = !out.fail() && replace();
+        if (!committed)
+            remove(tempPath.c_str());
+        return committed;
+    }
+
+private:
+    CacheFileWriter(const CacheFileWriter&);
+    CacheFileWriter& operator=(const CacheFileWriter&);
+
+    bool replace()
+    {
+#ifdef _WIN32
+        return MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+    }
+
+    // the process and thread, so no two writers share a temporary file
+    static string uniqueName()
+    {
+#ifdef _WIN32
+        unsigned long long process = GetCurrentProcessId();
+#else
+        unsigned long long process = (unsigned long long)getpid();
+#endif
+        return to_string(process) + "-" + to_string(hash<thread::id>()(this_thread::get_id()));
+    }
+
+    string path;
+    string tempPath;
+    ofstream out;
+    bool committed = false;
+};
+#endif
@@ -118,6 +118,20 @@ public:
             Zoom = 45.0f;
     }
 
+    // Moves the camera to position and turns it to face target, for cameras driven by a script rather than input
+    void LookAt(glm::vec3 position, glm::vec3 target)
+    {
+        Position = position;
+        glm::vec3 direction = target - position;
+        if (glm::length(direction) > 0.0f)
+        {
+            direction = glm::normalize(direction);
+            Yaw = glm::degrees((float)atan2(direction.z, direction.x));
+            Pitch = glm::clamp(glm::degrees((float)asin(direction.y)), -89.0f, 89.0f);
+        }
+        updateCameraVectors();
+    }
+
     // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
     // ---------------------------------------------------------------------------------------------------------
     void processInput(GLFWwindow* window, float deltaTime)
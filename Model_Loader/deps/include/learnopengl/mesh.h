@@ -5,9 +5,13 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <learnopengl/shader.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -28,6 +32,49 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// which parts of Vertex go into the vertex buffer and how they're stored. bit n of attributes is attribute
+// location n (0 position, 1 normal, 2 uv, 3 tangent, 4 bitangent), see Shader::attributeMask. packed stores
+// positions as half floats relative to the mesh bounds (the shader's meshBounds uniform puts them back),
+// normals, tangents and bitangents as normalised 10:10:10:2, which a vec3 input reads as is, and uvs as 16
+// bit unorms, or half floats if they tile past 0 to 1
+struct VertexLayout {
+    static const unsigned int allAttributes = 0x1f;
+
+    unsigned int attributes;
+    bool packed;
+
+    VertexLayout(unsigned int attributes = allAttributes, bool packed = false) : attributes(attributes & allAttributes), packed(packed) {}
+};
+
+// a range of the element buffer drawing one level of detail
+struct MeshLod {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+// one attribute as it sits in the vertex buffer
+struct VertexAttribute {
+    unsigned int location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    unsigned int bytes;
+};
+
+// a mesh already in its vertex buffer format, as MeshCache stores it. the data is only read while the Mesh is
+// being made, or until upload if that is deferred, so it can point into a file mapping
+struct PackedMesh {
+    const unsigned char* vertexData = nullptr;
+    unsigned int vertexCount = 0;
+    unsigned int vertexStride = 0;
+    vector<VertexAttribute> attributes;
+    glm::vec4 positionBounds = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    // every level of detail's indices, one after the other
+    const unsigned int* elementData = nullptr;
+    unsigned int elementCount = 0;
+    vector<MeshLod> lods;
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -37,68 +84,427 @@ struct Texture {
 class Mesh {
 public:
     /*  Mesh Data  */
+    // the mesh as it was imported, empty if it came packed from a cache or once releaseCpuData has let go of it
     vector<Vertex> vertices;
     vector<unsigned int> indices;
     vector<Texture> textures;
-    unsigned int VAO;
+    unsigned int VAO = 0;
 
     /*  Functions  */
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor. with deferUpload nothing is sent to GL until upload, so the mesh can be made on any thread
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, const VertexLayout& layout = VertexLayout(), bool deferUpload = false)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->layout = layout;
+
+        // level 0 is the mesh as loaded, until setLods adds simplified ones after it
+        MeshLod full = { 0, (unsigned int)this->indices.size() };
+        lods.push_back(full);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(deferUpload);
+        setupSamplerNames();
+    }
+
+    // a mesh packed before, uploaded straight from the packed data. vertices and indices stay empty, the
+    // levels of detail come with it so setLods isn't needed. deferUpload keeps pointing at the packed data to
+    // upload it later, so it has to stay where it is until then
+    Mesh(const PackedMesh& packed, vector<Texture> textures, bool deferUpload = false)
+    {
+        this->textures = std::move(textures);
+        this->lods = packed.lods;
+        this->attributes = packed.attributes;
+        this->positionBounds = packed.positionBounds;
+        this->vertexStride = packed.vertexStride;
+        this->vertexCount = packed.vertexCount;
+
+        if (deferUpload)
+        {
+            packedVertexData = packed.vertexData;
+            packedElementData = packed.elementData;
+            packedElementCount = packed.elementCount;
+        }
+        else
+        {
+            uploadBuffers(packed.vertexData, (size_t)packed.vertexCount * packed.vertexStride, packed.elementData, packed.elementCount);
+        }
+        setupSamplerNames();
+    }
+
+    // sends a mesh made with deferUpload to GL, on the thread that owns the context. does nothing once uploaded
+    void upload()
+    {
+        if (isUploaded())
+            return;
+        if (packedVertexData)
+            uploadBuffers(packedVertexData, (size_t)vertexCount * vertexStride, packedElementData, packedElementCount);
+        else
+            uploadBuffers(pendingVertexData.data(), pendingVertexData.size(), pendingElementData.data(), (unsigned int)pendingElementData.size());
+        vector<unsigned char>().swap(pendingVertexData);
+        vector<unsigned int>().swap(pendingElementData);
+        packedVertexData = nullptr;
+        packedElementData = nullptr;
+        packedElementCount = 0;
+    }
+    bool isUploaded() const { return VAO != 0; }
+
+    // lets go of vertices and indices, the GPU has its own copy once uploaded and readBackTriangles can
+    // bring the triangles back. the levels of detail have to be set before this
+    void releaseCpuData()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
+
+    // the bytes the mesh holds in memory (what releaseCpuData frees and what is waiting on upload), in its
+    // GL buffers, and what upload will send. packed data waiting on upload belongs to whoever packed it
+    size_t getCpuBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) +
+               pendingVertexData.capacity() + pendingElementData.capacity() * sizeof(unsigned int);
+    }
+    size_t getGpuBytes() const
+    {
+        return isUploaded() ? (size_t)vertexCount * vertexStride + (size_t)getElementCount() * sizeof(unsigned int) : 0;
+    }
+    size_t getUploadBytes() const
+    {
+        if (packedVertexData)
+            return (size_t)vertexCount * vertexStride + (size_t)packedElementCount * sizeof(unsigned int);
+        return pendingVertexData.size() + pendingElementData.size() * sizeof(unsigned int);
+    }
+
+    // deletes the mesh's buffers. the textures belong to the model, which deletes them
+    void release()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
     }
 
     // render the mesh
-    void Draw(Shader shader) 
+    void Draw(Shader& shader) 
+    {
+        bindTextures(shader);
+        shader.setVec4(meshBoundsName(), positionBounds);
+        
+        // draw mesh
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // render instanceCount copies of the mesh in one call, each using the model matrix at
+    // (baseInstance + instance) in instanceBuffer (a tightly packed array of mat4s)
+    void DrawInstanced(Shader& shader, unsigned int instanceBuffer, unsigned int instanceCount, unsigned int baseInstance = 0)
+    {
+        if (instanceCount == 0)
+            return;
+
+        bindTextures(shader);
+
+        glBindVertexArray(VAO);
+        useInstanceBuffer(instanceBuffer);
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, 0, instanceCount, baseInstance);
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // points the instance attributes at instanceBuffer, the mesh's VAO has to be bound. the attributes
+    // live on the VAO, so they only need pointing at a new buffer when it changes
+    void useInstanceBuffer(unsigned int instanceBuffer)
+    {
+        if (instanceVBO != instanceBuffer)
+            setupInstanceAttributes(instanceBuffer);
+    }
+
+    // the sampler each texture is bound to, in the same order as textures, for anything issuing its own draws
+    const vector<UniformName>& getSamplerNames() const { return samplerNames; }
+    unsigned int getIndexCount() const { return lods[0].indexCount; }
+    unsigned int getVertexCount() const { return vertexCount; }
+    // the centre (xyz) and scale (w) the vertex buffer positions are relative to, for the meshBounds uniform
+    const glm::vec4& getPositionBounds() const { return positionBounds; }
+    static const UniformName& meshBoundsName()
+    {
+        static const UniformName name("meshBounds");
+        return name;
+    }
+    // the bytes each vertex takes in the vertex buffer, and how its attributes are laid out
+    unsigned int getVertexStride() const { return vertexStride; }
+    const vector<VertexAttribute>& getAttributes() const { return attributes; }
+
+    // reads the vertex and element buffers back as the mesh packed them, for writing to a cache. this waits on
+    // the GPU, so only for loading
+    PackedMesh readBack(vector<unsigned char>& vertexData, vector<unsigned int>& elementData) const
+    {
+        PackedMesh packed;
+        packed.vertexCount = vertexCount;
+        packed.vertexStride = vertexStride;
+        packed.attributes = attributes;
+        packed.positionBounds = positionBounds;
+        packed.lods = lods;
+        packed.elementCount = getElementCount();
+
+        vertexData.resize((size_t)vertexCount * vertexStride);
+        elementData.resize(packed.elementCount);
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertexData.size(), vertexData.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, elementData.size() * sizeof(unsigned int), elementData.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        packed.vertexData = vertexData.data();
+        packed.elementData = elementData.data();
+        return packed;
+    }
+
+    // reads a level's triangles back from the GPU as positions and indices into them, for anything that needs
+    // the shape after releaseCpuData (picking, baking a distance field). this waits on the GPU too
+    void readBackTriangles(vector<glm::vec3>& positions, vector<unsigned int>& triangles, unsigned int lod = 0) const
+    {
+        vector<unsigned char> vertexData;
+        vector<unsigned int> elementData;
+        readBack(vertexData, elementData);
+
+        // the attributes go in location order, so the position is first if the layout kept it
+        const bool hasPositions = !attributes.empty() && attributes[0].location == 0;
+        positions.assign(vertexCount, glm::vec3(0.0f));
+        for (unsigned int i = 0; i < vertexCount && hasPositions; i++)
+        {
+            const unsigned char* position = vertexData.data() + (size_t)i * vertexStride;
+            if (attributes[0].type == GL_FLOAT)
+                memcpy(&positions[i], position, sizeof(glm::vec3));
+            else
+            {
+                // packed, relative to the bounds
+                glm::uint16 half[3];
+                memcpy(half, position, sizeof(half));
+                glm::vec3 relative(glm::unpackHalf1x16(half[0]), glm::unpackHalf1x16(half[1]), glm::unpackHalf1x16(half[2]));
+                positions[i] = relative * positionBounds.w + glm::vec3(positionBounds);
+            }
+        }
+
+        const MeshLod& level = lods[std::min(lod, getLodCount() - 1)];
+        triangles.assign(elementData.begin() + level.firstIndex, elementData.begin() + level.firstIndex + level.indexCount);
+    }
+
+    // replaces the simplified levels of detail, lodIndices[i] becoming level i + 1. the levels index the same
+    // vertices and go after indices in the one element buffer, so every level draws with the same VAO
+    void setLods(const vector<vector<unsigned int>>& lodIndices)
+    {
+        lods.resize(1);
+        vector<unsigned int> allIndices(indices);
+        for (unsigned int i = 0; i < lodIndices.size(); i++)
+        {
+            MeshLod lod = { (unsigned int)allIndices.size(), (unsigned int)lodIndices[i].size() };
+            lods.push_back(lod);
+            allIndices.insert(allIndices.end(), lodIndices[i].begin(), lodIndices[i].end());
+        }
+
+        // not uploaded yet, upload takes the levels along with everything else
+        if (!isUploaded())
+        {
+            pendingElementData = std::move(allIndices);
+            return;
+        }
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), &allIndices[0], GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    // the number of levels of detail (at least 1), and the range of the element buffer drawing each.
+    // levels past the last are clamped to it
+    unsigned int getLodCount() const { return (unsigned int)lods.size(); }
+    unsigned int getLodIndexCount(unsigned int lod) const { return lods[std::min(lod, getLodCount() - 1)].indexCount; }
+    // the byte offset of a level within the element buffer, as glDrawElements wants it
+    size_t getLodIndexOffset(unsigned int lod) const { return lods[std::min(lod, getLodCount() - 1)].firstIndex * sizeof(unsigned int); }
+
+private:
+    /*  Render data  */
+    unsigned int VBO = 0, EBO = 0;
+    // the buffer the per instance model matrices are read from, 0 until the mesh is first drawn instanced
+    unsigned int instanceVBO = 0;
+    // the sampler each of textures is bound to, in the same order
+    vector<UniformName> samplerNames;
+    // the element buffer range of each level of detail, level 0 being indices
+    vector<MeshLod> lods;
+    // what the vertex buffer holds, and the bounds its positions are relative to
+    VertexLayout layout;
+    vector<VertexAttribute> attributes;
+    glm::vec4 positionBounds = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    unsigned int vertexStride = 0;
+    unsigned int vertexCount = 0;
+    // the packed vertices and every level's indices of a mesh waiting on upload, emptied once it is uploaded
+    vector<unsigned char> pendingVertexData;
+    vector<unsigned int> pendingElementData;
+    // or, for a packed mesh waiting on upload, where its data is, usually a mesh cache mapping
+    const unsigned char* packedVertexData = nullptr;
+    const unsigned int* packedElementData = nullptr;
+    unsigned int packedElementCount = 0;
+
+    /*  Functions    */
+    // every level's indices, as the element buffer holds them
+    unsigned int getElementCount() const { return lods.back().firstIndex + lods.back().indexCount; }
+
+    // works out the sampler (texture_diffuseN etc) each texture is bound to, once rather than every draw
+    void setupSamplerNames()
     {
-        // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        samplerNames.reserve(textures.size());
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if(name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++); // transfer unsigned int to stream
             else if(name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-             else if(name == "texture_height")
-			    number = std::to_string(heightNr++); // transfer unsigned int to stream
+                number = std::to_string(normalNr++); // transfer unsigned int to stream
+            else if(name == "texture_height")
+                number = std::to_string(heightNr++); // transfer unsigned int to stream
+            samplerNames.push_back(UniformName(name + number));
+        }
+    }
 
-													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+    // binds each texture to its own unit and points the matching sampler at it
+    void bindTextures(Shader& shader)
+    {
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            shader.setInt(samplerNames[i], i);
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    // points attributes 5-8 at the instance buffer, a mat4 takes up four vec4 attribute slots
+    void setupInstanceAttributes(unsigned int instanceBuffer)
+    {
+        instanceVBO = instanceBuffer;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(5 + column);
+            glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * column));
+            // advance once per instance rather than once per vertex
+            glVertexAttribDivisor(5 + column, 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-private:
-    /*  Render data  */
-    unsigned int VBO, EBO;
+    // works out which attributes go in the vertex buffer, how each is stored and the packed position bounds
+    vector<VertexAttribute> setupLayout()
+    {
+        bool unormTexCoords = true;
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        for (unsigned int i = 0; i < vertices.size(); i++)
+        {
+            const Vertex& vertex = vertices[i];
+            minimum = i == 0 ? vertex.Position : glm::min(minimum, vertex.Position);
+            maximum = i == 0 ? vertex.Position : glm::max(maximum, vertex.Position);
+            if (vertex.TexCoords.x < 0.0f || vertex.TexCoords.x > 1.0f || vertex.TexCoords.y < 0.0f || vertex.TexCoords.y > 1.0f)
+                unormTexCoords = false;
+        }
+        if (layout.packed)
+        {
+            // centred and scaled into -1 to 1, where half floats are most even
+            glm::vec3 extent = (maximum - minimum) * 0.5f;
+            float scale = std::max(extent.x, std::max(extent.y, extent.z));
+            positionBounds = glm::vec4((minimum + maximum) * 0.5f, scale > 0.0f ? scale : 1.0f);
+        }
 
-    /*  Functions    */
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+        vector<VertexAttribute> formats;
+        vertexStride = 0;
+        for (unsigned int location = 0; location < 5; location++)
+        {
+            if (!(layout.attributes & (1u << location)))
+                continue;
+            VertexAttribute format;
+            if (!layout.packed)
+                format = { location, location == 2 ? 2 : 3, GL_FLOAT, GL_FALSE, location == 2 ? 8u : 12u };
+            else if (location == 0)
+                format = { location, 4, GL_HALF_FLOAT, GL_FALSE, 8 };
+            else if (location == 2)
+                format = unormTexCoords ? VertexAttribute{ location, 2, GL_UNSIGNED_SHORT, GL_TRUE, 4 } : VertexAttribute{ location, 2, GL_HALF_FLOAT, GL_FALSE, 4 };
+            else
+                format = { location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4 };
+            formats.push_back(format);
+            vertexStride += format.bytes;
+        }
+        return formats;
+    }
+
+    // writes one attribute of a vertex in its vertex buffer format
+    void writeAttribute(const Vertex& vertex, const VertexAttribute& format, unsigned char* out) const
+    {
+        const glm::vec3* directions[5] = { &vertex.Position, &vertex.Normal, nullptr, &vertex.Tangent, &vertex.Bitangent };
+        if (format.type == GL_FLOAT)
+        {
+            const void* source = format.location == 2 ? (const void*)&vertex.TexCoords : (const void*)directions[format.location];
+            memcpy(out, source, format.bytes);
+        }
+        else if (format.location == 0)
+        {
+            glm::vec3 position = (vertex.Position - glm::vec3(positionBounds)) / positionBounds.w;
+            glm::uint16 half[4] = { glm::packHalf1x16(position.x), glm::packHalf1x16(position.y), glm::packHalf1x16(position.z), glm::packHalf1x16(1.0f) };
+            memcpy(out, half, sizeof(half));
+        }
+        else if (format.location == 2)
+        {
+            glm::uint packed = format.type == GL_UNSIGNED_SHORT ? glm::packUnorm2x16(vertex.TexCoords) : glm::packHalf2x16(vertex.TexCoords);
+            memcpy(out, &packed, sizeof(packed));
+        }
+        else
+        {
+            const glm::vec3& direction = *directions[format.location];
+            glm::vec3 unit = glm::dot(direction, direction) > 0.0f ? glm::normalize(direction) : glm::vec3(0.0f);
+            glm::uint packed = glm::packSnorm3x10_1x2(glm::vec4(unit, 0.0f));
+            memcpy(out, &packed, sizeof(packed));
+        }
+    }
+
+    // initializes all the buffer objects/arrays, or packs the vertices ready for upload if it is deferred
+    void setupMesh(bool deferUpload)
+    {
+        // only the attributes in the layout are kept, interleaved in the order of their locations
+        attributes = setupLayout();
+        vertexCount = (unsigned int)vertices.size();
+        vector<unsigned char> vertexData(vertices.size() * vertexStride);
+        for (unsigned int i = 0; i < vertices.size(); i++)
+        {
+            unsigned char* out = vertexData.data() + i * vertexStride;
+            for (unsigned int j = 0; j < attributes.size(); j++)
+            {
+                writeAttribute(vertices[i], attributes[j], out);
+                out += attributes[j].bytes;
+            }
+        }
+
+        if (deferUpload)
+        {
+            pendingVertexData = std::move(vertexData);
+            pendingElementData = indices;
+            return;
+        }
+        uploadBuffers(vertexData.data(), vertexData.size(), indices.data(), (unsigned int)indices.size());
+    }
+
+    // creates the buffers from packed vertices and the element data, and points the attributes at them
+    void uploadBuffers(const unsigned char* vertexData, size_t vertexBytes, const unsigned int* elementData, unsigned int elementCount)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -108,30 +514,19 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementCount * sizeof(unsigned int), elementData, GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        size_t offset = 0;
+        for (unsigned int j = 0; j < attributes.size(); j++)
+        {
+            glEnableVertexAttribArray(attributes[j].location);
+            glVertexAttribPointer(attributes[j].location, attributes[j].size, attributes[j].type, attributes[j].normalized, vertexStride, (void*)offset);
+            offset += attributes[j].bytes;
+        }
 
         glBindVertexArray(0);
     }
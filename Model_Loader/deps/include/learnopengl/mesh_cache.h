@@ -0,0 +1,381 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/cache_file.h>
+#include <learnopengl/mesh.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// a whole file mapped read only into memory, the pages are only read from disk as they are touched
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    bool open(const string& path)
+    {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            fileHandle = nullptr;
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mappingHandle ? (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat info;
+        if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+        {
+            ::close(descriptor);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        // the mapping keeps the file open on its own
+        ::close(descriptor);
+        data = mapping != MAP_FAILED ? (const unsigned char*)mapping : nullptr;
+#endif
+        if (!data)
+            close();
+        return data != nullptr;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mappingHandle)
+            CloseHandle(mappingHandle);
+        if (fileHandle)
+            CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        if (data)
+            munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const unsigned char* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = nullptr;
+    HANDLE mappingHandle = nullptr;
+#endif
+};
+
+// a texture a cached mesh uses, loaded by the model the same way as one assimp found
+struct TextureReference {
+    string type;
+    string path;
+};
+
+// Keeps a model's meshes next to it in a .mesh file, as they are after import, optimisation and level of detail
+// generation: each mesh's packed vertex buffer and element buffer, its attribute layout, bounds and textures.
+// Loading maps the file and the buffers are uploaded straight out of the mapping, so a warm start neither runs
+// assimp nor copies the meshes through vectors. The cache is keyed on the model file's path, size and modified
+// time, the vertex layout and the level of detail ratios. changes to a material file alone aren't noticed
+class MeshCache
+{
+public:
+    // bump the version if the layout of the file or of the packed vertices changes
+    static const unsigned int CACHE_MAGIC = 0x4853454d; // "MESH"
+    static const unsigned int CACHE_VERSION = 2;
+
+    static string cachePath(const string& sourcePath) { return sourcePath + ".mesh"; }
+
+    // what a cache of the model is keyed on besides its own settings, the model's level of detail cache too.
+    // FNV-1a of the path, so a cache copied next to another model with the same name isn't taken for its own
+    static unsigned long long hashPath(const string& path)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        for (size_t i = 0; i < path.size(); i++)
+            hash = (hash ^ (unsigned char)path[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    static bool sourceStamp(const string& path, unsigned long long& size, unsigned long long& time)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        size = (unsigned long long)info.st_size;
+        time = (unsigned long long)info.st_mtime;
+        return true;
+    }
+
+    // maps the cache and checks it, the meshes point into the mapping until close
+    bool open(const string& sourcePath, const VertexLayout& layout, const vector<float>& lodRatios)
+    {
+        close();
+        unsigned long long sourceSize = 0, sourceTime = 0;
+        if (!sourceStamp(sourcePath, sourceSize, sourceTime) || !file.open(cachePath(sourcePath)))
+            return false;
+
+        position = 0;
+        unsigned int magic = 0, version = 0, attributes = 0, packed = 0, ratioCount = 0, meshCount = 0;
+        unsigned long long pathHash = 0, cachedSize = 0, cachedTime = 0;
+        if (!readValue(magic) || magic != CACHE_MAGIC || !readValue(version) || version != CACHE_VERSION || !readValue(pathHash) || pathHash != hashPath(sourcePath) ||
+            !readValue(cachedSize) || cachedSize != sourceSize || !readValue(cachedTime) || cachedTime != sourceTime || !readValue(attributes) || attributes != layout.attributes ||
+            !readValue(packed) || packed != (layout.packed ? 1u : 0u) || !readValue(ratioCount) || ratioCount != lodRatios.size())
+            return fail();
+        for (unsigned int i = 0; i < ratioCount; i++)
+        {
+            float ratio = 0.0f;
+            if (!readValue(ratio) || ratio != lodRatios[i])
+                return fail();
+        }
+        // every mesh takes at least its fixed fields and one level of detail, so a count the rest of the file
+        // couldn't hold is refused before anything is sized from it
+        const size_t smallestMesh = 6 * sizeof(unsigned int) + sizeof(glm::vec4) + sizeof(MeshLod);
+        if (!readValue(boundingRadius) || !readValue(meshCount) || meshCount > (file.getSize() - position) / smallestMesh)
+            return fail();
+
+        meshes.resize(meshCount);
+        textures.resize(meshCount);
+        for (unsigned int i = 0; i < meshCount; i++)
+            if (!readMesh(layout, meshes[i], textures[i]))
+                return fail();
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        meshes.clear();
+        textures.clear();
+    }
+
+    const vector<PackedMesh>& getMeshes() const { return meshes; }
+    const vector<TextureReference>& getTextures(unsigned int mesh) const { return textures[mesh]; }
+    float getBoundingRadius() const { return boundingRadius; }
+    // the size of the mapping the meshes point into
+    size_t getMappedBytes() const { return file.getSize(); }
+
+    static void write(const string& sourcePath, const VertexLayout& layout, const vector<float>& lodRatios, float boundingRadius, const vector<Mesh>& meshes)
+    {
+        unsigned long long sourceSize = 0, sourceTime = 0;
+        if (meshes.empty() || !sourceStamp(sourcePath, sourceSize, sourceTime))
+            return;
+        CacheFileWriter writer(cachePath(sourcePath));
+        ofstream& out = writer.stream();
+        if (!out)
+        {
+            cout << "Failed to write mesh cache " << cachePath(sourcePath) << endl;
+            return;
+        }
+
+        writeValue(out, CACHE_MAGIC);
+        writeValue(out, CACHE_VERSION);
+        writeValue(out, hashPath(sourcePath));
+        writeValue(out, sourceSize);
+        writeValue(out, sourceTime);
+        writeValue(out, layout.attributes);
+        writeValue(out, layout.packed ? 1u : 0u);
+        writeValue(out, (unsigned int)lodRatios.size());
+        for (unsigned int i = 0; i < lodRatios.size(); i++)
+            writeValue(out, lodRatios[i]);
+        writeValue(out, boundingRadius);
+        writeValue(out, (unsigned int)meshes.size());
+
+        vector<unsigned char> vertexData;
+        vector<unsigned int> elementData;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            PackedMesh packed = meshes[i].readBack(vertexData, elementData);
+            writeValue(out, packed.vertexCount);
+            writeValue(out, packed.vertexStride);
+            writeValue(out, (unsigned int)packed.attributes.size());
+            for (unsigned int j = 0; j < packed.attributes.size(); j++)
+                writeValue(out, packed.attributes[j]);
+            writeValue(out, packed.positionBounds);
+            writeValue(out, (unsigned int)packed.lods.size());
+            for (unsigned int j = 0; j < packed.lods.size(); j++)
+                writeValue(out, packed.lods[j]);
+            writeValue(out, packed.elementCount);
+            writeValue(out, (unsigned int)meshes[i].textures.size());
+            for (unsigned int j = 0; j < meshes[i].textures.size(); j++)
+            {
+                writeString(out, meshes[i].textures[j].type);
+                writeString(out, meshes[i].textures[j].path);
+            }
+            // the blobs start on 4 bytes so the indices can be read in place
+            pad(out);
+            out.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+            pad(out);
+            out.write(reinterpret_cast<const char*>(elementData.data()), elementData.size() * sizeof(unsigned int));
+        }
+        if (!writer.commit())
+            cout << "Failed to write mesh cache " << cachePath(sourcePath) << endl;
+    }
+
+private:
+    bool fail()
+    {
+        close();
+        return false;
+    }
+
+    // reads a mesh's description and points it at its blobs, checking everything stays within the file, every
+    // attribute is one the layout asked for and fits the stride, and every index is a vertex the mesh has
+    bool readMesh(const VertexLayout& layout, PackedMesh& packed, vector<TextureReference>& meshTextures)
+    {
+        unsigned int attributeCount = 0, lodCount = 0, textureCount = 0;
+        if (!readValue(packed.vertexCount) || !readValue(packed.vertexStride) || !readValue(attributeCount) || attributeCount > 5)
+            return false;
+        packed.attributes.resize(attributeCount);
+        unsigned int offset = 0, locations = 0;
+        for (unsigned int i = 0; i < attributeCount; i++)
+        {
+            const VertexAttribute& attribute = packed.attributes[i];
+            // in location order, one of each, and no more bytes than its format needs
+            if (!readValue(packed.attributes[i]) || attribute.location >= 5 || (locations >> attribute.location) != 0 ||
+                attribute.bytes == 0 || attribute.bytes != attributeBytes(attribute) || attribute.bytes > packed.vertexStride - offset)
+                return false;
+            locations |= 1u << attribute.location;
+            offset += attribute.bytes;
+        }
+        if (locations != layout.attributes || offset != packed.vertexStride || !readValue(packed.positionBounds) || !readValue(lodCount) || lodCount == 0 || lodCount > 16)
+            return false;
+        packed.lods.resize(lodCount);
+        for (unsigned int i = 0; i < lodCount; i++)
+            if (!readValue(packed.lods[i]))
+                return false;
+        if (!readValue(packed.elementCount) || !readValue(textureCount) || textureCount > 64)
+            return false;
+        for (unsigned int i = 0; i < lodCount; i++)
+            if ((unsigned long long)packed.lods[i].firstIndex + packed.lods[i].indexCount > packed.elementCount)
+                return false;
+        meshTextures.resize(textureCount);
+        for (unsigned int i = 0; i < textureCount; i++)
+            if (!readString(meshTextures[i].type) || !readString(meshTextures[i].path))
+                return false;
+
+        packed.vertexData = readBlob((unsigned long long)packed.vertexCount * packed.vertexStride);
+        packed.elementData = reinterpret_cast<const unsigned int*>(readBlob((unsigned long long)packed.elementCount * sizeof(unsigned int)));
+        if (!packed.vertexData || !packed.elementData)
+            return false;
+        for (unsigned int i = 0; i < packed.elementCount; i++)
+            if (packed.elementData[i] >= packed.vertexCount)
+                return false;
+        return true;
+    }
+
+    // the reads compare against what is left of the file, so a huge length can't wrap the position past the end
+    template<typename T> bool readValue(T& value)
+    {
+        if (sizeof(T) > file.getSize() - position)
+            return false;
+        memcpy(&value, file.getData() + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    bool readString(string& value)
+    {
+        unsigned int length = 0;
+        if (!readValue(length) || length > file.getSize() - position)
+            return false;
+        value.assign(reinterpret_cast<const char*>(file.getData() + position), length);
+        position += length;
+        return true;
+    }
+
+    const unsigned char* readBlob(unsigned long long bytes)
+    {
+        size_t aligned = (position + 3) & ~(size_t)3;
+        if (aligned > file.getSize() || bytes > file.getSize() - aligned)
+            return nullptr;
+        const unsigned char* blob = file.getData() + aligned;
+        position = aligned + (size_t)bytes;
+        return blob;
+    }
+
+    // the bytes an attribute's format takes, 0 for a format the meshes never write
+    static unsigned int attributeBytes(const VertexAttribute& attribute)
+    {
+        if (attribute.size < 1 || attribute.size > 4)
+            return 0;
+        switch (attribute.type)
+        {
+        case GL_FLOAT:
+            return 4 * attribute.size;
+        case GL_HALF_FLOAT:
+        case GL_UNSIGNED_SHORT:
+            return 2 * attribute.size;
+        case GL_INT_2_10_10_10_REV:
+            return attribute.size == 4 ? 4 : 0;
+        default:
+            return 0;
+        }
+    }
+
+    template<typename T> static void writeValue(ofstream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void writeString(ofstream& out, const string& value)
+    {
+        writeValue(out, (unsigned int)value.size());
+        out.write(value.data(), value.size());
+    }
+
+    static void pad(ofstream& out)
+    {
+        static const char zeros[4] = { 0, 0, 0, 0 };
+        out.write(zeros, (4 - (size_t)out.tellp() % 4) % 4);
+    }
+
+    MappedFile file;
+    size_t position = 0;
+    vector<PackedMesh> meshes;
+    vector<vector<TextureReference>> textures;
+    float boundingRadius = 0.0f;
+};
+#endif
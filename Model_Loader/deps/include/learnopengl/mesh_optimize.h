@@ -0,0 +1,279 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// what MeshOptimizer::optimize changed, bytes counting the Vertex array and the indices
+struct MeshOptimizeStats {
+    size_t verticesBefore;
+    size_t verticesAfter;
+    float acmrBefore;
+    float acmrAfter;
+    size_t bytesBefore;
+    size_t bytesAfter;
+};
+
+// Reorders a mesh for the GPU at import. Identical vertices are welded, the triangles are put in an order that
+// reuses the post transform cache (Tipsify, Sander, Nehab and Barczak 2007), the clusters that leaves are sorted
+// so outward facing ones draw first to cut overdraw, and the vertices are laid out in the order they're first used
+class MeshOptimizer
+{
+public:
+    // the post transform cache size the orders are tuned for and the ACMR is measured with
+    static const unsigned int cacheSize = 16;
+
+    // runs every step on the mesh in place
+    static MeshOptimizeStats optimize(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        MeshOptimizeStats stats;
+        stats.verticesBefore = vertices.size();
+        stats.acmrBefore = acmr(indices, vertices.size());
+        stats.bytesBefore = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+
+        weld(vertices, indices);
+        vector<unsigned int> clusters;
+        indices = optimizeVertexCache(indices, vertices.size(), &clusters);
+        optimizeOverdraw(vertices, indices, clusters);
+        optimizeVertexFetch(vertices, indices);
+
+        stats.verticesAfter = vertices.size();
+        stats.acmrAfter = acmr(indices, vertices.size());
+        stats.bytesAfter = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+        return stats;
+    }
+
+    // the average cache miss ratio, vertices transformed per triangle through a fifo cache. 3 is no reuse at
+    // all, around 0.6 to 0.7 is as good as a regular mesh gets
+    static float acmr(const vector<unsigned int>& indices, size_t vertexCount)
+    {
+        if (indices.size() < 3)
+            return 0.0f;
+        // the time each vertex went into the cache, it's still there while fewer than cacheSize misses came since
+        vector<size_t> cachedAt(vertexCount, 0);
+        size_t misses = 0;
+        for (unsigned int index : indices)
+        {
+            if (cachedAt[index] == 0 || misses - cachedAt[index] >= cacheSize)
+                cachedAt[index] = ++misses;
+        }
+        return (float)misses / (float)(indices.size() / 3);
+    }
+
+    // Tipsify. fans out around one vertex at a time, moving on to whichever of the fan's vertices will still be
+    // in the cache once its own triangles are done. the start of each run after a dead end goes in clusters (as
+    // a triangle number), those runs are what optimizeOverdraw moves around
+    static vector<unsigned int> optimizeVertexCache(const vector<unsigned int>& indices, size_t vertexCount, vector<unsigned int>* clusters = nullptr)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        vector<unsigned int> output;
+        output.reserve(triangleCount * 3);
+        if (clusters)
+            clusters->clear();
+        if (triangleCount == 0)
+            return output;
+
+        // the triangles using each vertex, packed one vertex after another
+        vector<unsigned int> liveTriangles(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            liveTriangles[indices[i]]++;
+        vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+        vector<unsigned int> adjacency(adjacencyStart[vertexCount]);
+        vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (unsigned int corner = 0; corner < 3; corner++)
+                adjacency[fill[indices[t * 3 + corner]]++] = (unsigned int)t;
+
+        vector<unsigned int> cacheTime(vertexCount, 0);
+        vector<char> emitted(triangleCount, 0);
+        vector<unsigned int> deadEnds;
+        vector<unsigned int> candidates;
+        unsigned int time = cacheSize + 1;
+        size_t cursor = 0;
+
+        int fanning = nextLiveVertex(liveTriangles, deadEnds, cursor);
+        if (clusters)
+            clusters->push_back(0);
+        while (fanning >= 0)
+        {
+            candidates.clear();
+            for (unsigned int a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++)
+            {
+                unsigned int t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                emitted[t] = 1;
+                for (unsigned int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int v = indices[t * 3 + corner];
+                    output.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+                    if (time - cacheTime[v] > cacheSize)
+                        cacheTime[v] = time++;
+                }
+            }
+
+            // the candidate that will still be cached after its remaining triangles are emitted, oldest first
+            int best = -1;
+            int bestPriority = -1;
+            for (unsigned int v : candidates)
+            {
+                if (liveTriangles[v] == 0)
+                    continue;
+                int priority = 0;
+                if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                    priority = (int)(time - cacheTime[v]);
+                if (priority > bestPriority)
+                {
+                    best = (int)v;
+                    bestPriority = priority;
+                }
+            }
+            if (best < 0)
+            {
+                best = nextLiveVertex(liveTriangles, deadEnds, cursor);
+                if (clusters && best >= 0 && output.size() / 3 < triangleCount)
+                    clusters->push_back((unsigned int)(output.size() / 3));
+            }
+            fanning = best;
+        }
+        return output;
+    }
+
+private:
+    // the most recently used vertex that still has triangles, or failing that the next one in index order
+    static int nextLiveVertex(const vector<unsigned int>& liveTriangles, vector<unsigned int>& deadEnds, size_t& cursor)
+    {
+        while (!deadEnds.empty())
+        {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+                return (int)v;
+        }
+        while (cursor < liveTriangles.size())
+        {
+            if (liveTriangles[cursor] > 0)
+                return (int)cursor;
+            cursor++;
+        }
+        return -1;
+    }
+
+    // drops every vertex that is byte for byte the same as an earlier one
+    static void weld(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        vector<unsigned int> order(vertices.size());
+        for (unsigned int i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+        {
+            int compare = std::memcmp(&vertices[a], &vertices[b], sizeof(Vertex));
+            return compare < 0 || (compare == 0 && a < b);
+        });
+
+        vector<unsigned int> remap(vertices.size());
+        vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (i == 0 || std::memcmp(&vertices[order[i]], &vertices[order[i - 1]], sizeof(Vertex)) != 0)
+                welded.push_back(vertices[order[i]]);
+            remap[order[i]] = (unsigned int)(welded.size() - 1);
+        }
+        for (unsigned int& index : indices)
+            index = remap[index];
+        vertices.swap(welded);
+    }
+
+    // draws the clusters facing out from the middle of the mesh first, as they're the ones most likely to be in
+    // front. a view independent guess, but it keeps the cache order inside each cluster
+    static void optimizeOverdraw(const vector<Vertex>& vertices, vector<unsigned int>& indices, const vector<unsigned int>& clusters)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (clusters.size() < 2)
+            return;
+
+        glm::vec3 meshCentre(0.0f);
+        float meshArea = 0.0f;
+        vector<glm::vec3> clusterCentres(clusters.size(), glm::vec3(0.0f));
+        vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+        vector<float> clusterAreas(clusters.size(), 0.0f);
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+            for (size_t t = clusters[c]; t < end; t++)
+            {
+                const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+                // the cross product is twice the area, in the direction of the normal
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                clusterCentres[c] += (p0 + p1 + p2) / 3.0f * area;
+                clusterNormals[c] += normal;
+                clusterAreas[c] += area;
+            }
+            meshCentre += clusterCentres[c];
+            meshArea += clusterAreas[c];
+        }
+        if (meshArea <= 0.0f)
+            return;
+        meshCentre /= meshArea;
+
+        vector<float> facing(clusters.size(), 0.0f);
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            if (clusterAreas[c] <= 0.0f)
+                continue;
+            glm::vec3 centre = clusterCentres[c] / clusterAreas[c];
+            float normalLength = glm::length(clusterNormals[c]);
+            facing[c] = normalLength > 0.0f ? glm::dot(centre - meshCentre, clusterNormals[c] / normalLength) : 0.0f;
+        }
+
+        vector<unsigned int> order(clusters.size());
+        for (unsigned int c = 0; c < order.size(); c++)
+            order[c] = c;
+        std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return facing[a] > facing[b]; });
+
+        vector<unsigned int> sorted;
+        sorted.reserve(indices.size());
+        for (unsigned int c : order)
+        {
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+            sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+        }
+        indices.swap(sorted);
+    }
+
+    // puts the vertices in the order the indices first use them, so fetching them walks forward through memory.
+    // vertices nothing uses are dropped
+    static void optimizeVertexFetch(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        const unsigned int unused = ~0u;
+        vector<unsigned int> remap(vertices.size(), unused);
+        vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = (unsigned int)ordered.size();
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+};
+#endif
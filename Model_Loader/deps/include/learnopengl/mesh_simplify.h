@@ -0,0 +1,258 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Quadric edge collapse simplification (Garland and Heckbert). Each vertex collapses onto one of its
+// neighbours, so a simplified mesh only needs a new index list and can share the original vertex buffer.
+// Vertices on a border or a UV seam are never removed, which keeps the outline and the texturing intact
+class MeshSimplifier
+{
+public:
+    // returns indices drawing a simplified version of the mesh with about targetIndexCount indices, or as
+    // close as it can get without removing locked vertices or flipping triangles
+    static vector<unsigned int> simplify(const vector<Vertex>& vertices, const vector<unsigned int>& indices, size_t targetIndexCount)
+    {
+        // the importer doesn't join identical vertices, so every triangle would look like it had its own border
+        vector<unsigned int> remap = weld(vertices);
+
+        vector<unsigned int> triangles;
+        triangles.reserve(indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                triangles.push_back(a);
+                triangles.push_back(b);
+                triangles.push_back(c);
+            }
+        }
+
+        const size_t triangleCount = triangles.size() / 3;
+        size_t liveTriangles = triangleCount;
+        vector<char> triangleRemoved(triangleCount, 0);
+        vector<vector<unsigned int>> vertexTriangles(vertices.size());
+        for (size_t t = 0; t < triangleCount; t++)
+            for (unsigned int corner = 0; corner < 3; corner++)
+                vertexTriangles[triangles[t * 3 + corner]].push_back((unsigned int)t);
+
+        // an edge used by only one triangle is a border (or a seam, where the vertices either side differ)
+        vector<char> locked(vertices.size(), 0);
+        unordered_map<unsigned long long, unsigned int> edgeUses;
+        for (size_t t = 0; t < triangleCount; t++)
+            for (unsigned int corner = 0; corner < 3; corner++)
+                edgeUses[edgeKey(triangles[t * 3 + corner], triangles[t * 3 + (corner + 1) % 3])]++;
+        for (const pair<const unsigned long long, unsigned int>& edge : edgeUses)
+        {
+            if (edge.second == 1)
+            {
+                locked[(unsigned int)(edge.first >> 32)] = 1;
+                locked[(unsigned int)(edge.first & 0xffffffffull)] = 1;
+            }
+        }
+
+        // each vertex starts with the planes of the triangles around it, weighted by their area
+        vector<Quadric> quadrics(vertices.size());
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const glm::dvec3 p0(vertices[triangles[t * 3]].Position);
+            const glm::dvec3 p1(vertices[triangles[t * 3 + 1]].Position);
+            const glm::dvec3 p2(vertices[triangles[t * 3 + 2]].Position);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if (length <= 0.0)
+                continue;
+            normal /= length;
+
+            Quadric plane(normal, -glm::dot(normal, p0), length * 0.5);
+            for (unsigned int corner = 0; corner < 3; corner++)
+                quadrics[triangles[t * 3 + corner]].add(plane);
+        }
+
+        // cheapest collapse first. a candidate is stale once either vertex has changed since it was pushed
+        priority_queue<Collapse> candidates;
+        vector<unsigned int> versions(vertices.size(), 0);
+        vector<char> removed(vertices.size(), 0);
+        auto pushCandidate = [&](unsigned int from, unsigned int to)
+        {
+            if (locked[from])
+                return;
+            Quadric combined = quadrics[from];
+            combined.add(quadrics[to]);
+            Collapse collapse = { combined.evaluate(glm::dvec3(vertices[to].Position)), from, to, versions[from], versions[to] };
+            candidates.push(collapse);
+        };
+        for (size_t t = 0; t < triangleCount; t++)
+            for (unsigned int corner = 0; corner < 3; corner++)
+            {
+                unsigned int a = triangles[t * 3 + corner], b = triangles[t * 3 + (corner + 1) % 3];
+                pushCandidate(a, b);
+                pushCandidate(b, a);
+            }
+
+        while (liveTriangles * 3 > targetIndexCount && !candidates.empty())
+        {
+            Collapse collapse = candidates.top();
+            candidates.pop();
+            if (removed[collapse.from] || removed[collapse.to] ||
+                versions[collapse.from] != collapse.fromVersion || versions[collapse.to] != collapse.toVersion)
+                continue;
+
+            if (flipsTriangle(vertices, triangles, triangleRemoved, vertexTriangles[collapse.from], collapse.from, collapse.to))
+                continue;
+
+            // triangles on the edge disappear, the rest move over to the vertex being kept
+            for (unsigned int t : vertexTriangles[collapse.from])
+            {
+                if (triangleRemoved[t])
+                    continue;
+                unsigned int* corners = &triangles[t * 3];
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                {
+                    triangleRemoved[t] = 1;
+                    liveTriangles--;
+                    continue;
+                }
+                for (unsigned int corner = 0; corner < 3; corner++)
+                    if (corners[corner] == collapse.from)
+                        corners[corner] = collapse.to;
+                vertexTriangles[collapse.to].push_back(t);
+            }
+            removed[collapse.from] = 1;
+            vertexTriangles[collapse.from].clear();
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            versions[collapse.to]++;
+
+            // only the edges around the kept vertex have a new cost
+            for (unsigned int t : vertexTriangles[collapse.to])
+            {
+                if (triangleRemoved[t])
+                    continue;
+                for (unsigned int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int other = triangles[t * 3 + corner];
+                    if (other == collapse.to)
+                        continue;
+                    pushCandidate(collapse.to, other);
+                    pushCandidate(other, collapse.to);
+                }
+            }
+        }
+
+        vector<unsigned int> result;
+        result.reserve(liveTriangles * 3);
+        for (size_t t = 0; t < triangleCount; t++)
+            if (!triangleRemoved[t])
+                result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+        return result;
+    }
+
+private:
+    // a symmetric 4x4 matrix, the sum of squared distances to a set of planes
+    struct Quadric
+    {
+        double m[10];
+
+        Quadric() { std::fill(m, m + 10, 0.0); }
+        Quadric(const glm::dvec3& n, double d, double weight)
+        {
+            m[0] = n.x * n.x * weight; m[1] = n.x * n.y * weight; m[2] = n.x * n.z * weight; m[3] = n.x * d * weight;
+            m[4] = n.y * n.y * weight; m[5] = n.y * n.z * weight; m[6] = n.y * d * weight;
+            m[7] = n.z * n.z * weight; m[8] = n.z * d * weight;
+            m[9] = d * d * weight;
+        }
+
+        void add(const Quadric& other)
+        {
+            for (unsigned int i = 0; i < 10; i++)
+                m[i] += other.m[i];
+        }
+
+        double evaluate(const glm::dvec3& p) const
+        {
+            return m[0] * p.x * p.x + 2.0 * m[1] * p.x * p.y + 2.0 * m[2] * p.x * p.z + 2.0 * m[3] * p.x
+                 + m[4] * p.y * p.y + 2.0 * m[5] * p.y * p.z + 2.0 * m[6] * p.y
+                 + m[7] * p.z * p.z + 2.0 * m[8] * p.z
+                 + m[9];
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        unsigned int from;
+        unsigned int to;
+        unsigned int fromVersion;
+        unsigned int toVersion;
+
+        // priority_queue pops the largest, so the cheapest has to compare largest
+        bool operator<(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    static unsigned long long edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+    }
+
+    // maps every vertex to the first vertex with exactly the same position, normal and uv. the tangents are
+    // left out as they are worked out per corner, and would keep otherwise identical corners apart
+    static vector<unsigned int> weld(const vector<Vertex>& vertices)
+    {
+        const size_t keySize = offsetof(Vertex, Tangent);
+        vector<unsigned int> order(vertices.size());
+        for (unsigned int i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+        {
+            int compare = std::memcmp(&vertices[a], &vertices[b], keySize);
+            return compare < 0 || (compare == 0 && a < b);
+        });
+
+        vector<unsigned int> remap(vertices.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            bool same = i > 0 && std::memcmp(&vertices[order[i]], &vertices[order[i - 1]], keySize) == 0;
+            remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+        }
+        return remap;
+    }
+
+    // true if moving from onto to would turn any of the triangles that stay over (or flatten them)
+    static bool flipsTriangle(const vector<Vertex>& vertices, const vector<unsigned int>& triangles, const vector<char>& triangleRemoved,
+        const vector<unsigned int>& fromTriangles, unsigned int from, unsigned int to)
+    {
+        for (unsigned int t : fromTriangles)
+        {
+            if (triangleRemoved[t])
+                continue;
+            const unsigned int* corners = &triangles[t * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+                continue;
+
+            glm::vec3 before[3], after[3];
+            for (unsigned int corner = 0; corner < 3; corner++)
+            {
+                before[corner] = vertices[corners[corner]].Position;
+                after[corner] = vertices[corners[corner] == from ? to : corners[corner]].Position;
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+                return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -10,15 +10,25 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/cache_file.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimize.h>
+#include <learnopengl/mesh_simplify.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 using namespace std;
 
 class Model 
@@ -29,23 +39,335 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    // radius of a sphere around the model's origin that holds every vertex, for culling
+    float boundingRadius = 0.0f;
 
     /*  Functions   */
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // an empty model, for meshes made in code
+    Model() : gammaCorrection(false), uploaded(true) {}
+
+    // constructor, expects a filepath to a 3D model. each of lodRatios adds a level of detail to every mesh
+    // with about that fraction of its triangles, in the order given. vertexLayout picks what the meshes keep
+    // in their vertex buffers, usually made from the attributes of the shaders that will draw them.
+    // deferUpload makes no GL calls, so the model can be read on another thread, and leaves it to upload.
+    // the meshes' vertices and indices are let go of once they are uploaded, unless retainCpuData
+    Model(string const &path, bool gamma = false, const vector<float>& lodRatios = vector<float>(), const VertexLayout& vertexLayout = VertexLayout(), bool deferUpload = false,
+          bool retainCpuData = false)
+        : gammaCorrection(gamma), vertexLayout(vertexLayout), deferUpload(deferUpload), uploaded(!deferUpload), retainCpuData(retainCpuData)
     {
+        typedef chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        if(loadCachedModel(path, lodRatios))
+        {
+            cout << "Loaded " << path << " from its mesh cache in " << chrono::duration<float, milli>(Clock::now() - start).count() << " ms" << endl;
+            return;
+        }
+
         loadModel(path);
+        computeBoundingRadius();
+        if(!lodRatios.empty())
+            generateLods(path, lodRatios);
+        // the next start can skip all of the above. the cache is read back from the GPU, so a deferred model
+        // writes it once it is uploaded
+        if(deferUpload)
+        {
+            cacheSourcePath = path;
+            cacheLodRatios = lodRatios;
+        }
+        else
+        {
+            MeshCache::write(path, vertexLayout, lodRatios, boundingRadius, meshes);
+            if(!retainCpuData)
+                releaseCpuData();
+        }
+        cout << "Imported " << path << " in " << chrono::duration<float, milli>(Clock::now() - start).count() << " ms" << endl;
     }
 
+    // finishes a model made with deferUpload, on the thread that owns the context. the meshes and the textures
+    // decoded with them are uploaded, then the mesh cache is written if the model was imported
+    void upload()
+    {
+        if(uploaded)
+            return;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].upload();
+        // the meshes were uploaded straight out of the mapping, nothing needs it now
+        meshCache.reset();
+
+        // the names come back in the order loadTexture queued them, which is the order of textures_loaded
+        vector<unsigned int> ids = textureLoader.uploadAll();
+        for(unsigned int i = 0; i < ids.size() && i < textures_loaded.size(); i++)
+            textures_loaded[i].id = ids[i];
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            for(unsigned int j = 0; j < meshes[i].textures.size(); j++)
+                meshes[i].textures[j].id = textures_loaded[textureIndices[meshes[i].textures[j].path]].id;
+
+        if(!cacheSourcePath.empty())
+        {
+            MeshCache::write(cacheSourcePath, vertexLayout, cacheLodRatios, boundingRadius, meshes);
+            cacheSourcePath.clear();
+        }
+        if(!retainCpuData)
+            releaseCpuData();
+        uploaded = true;
+    }
+    bool isUploaded() const { return uploaded; }
+
+    // lets go of every mesh's vertices and indices, see Mesh::releaseCpuData. Mesh::readBackTriangles can
+    // bring the shape back from the GPU after
+    void releaseCpuData()
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].releaseCpuData();
+    }
+    bool hasCpuData() const
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            if(!meshes[i].vertices.empty())
+                return true;
+        return false;
+    }
+
+    // the bytes the model holds in memory, in GL buffers and textures, and what upload will send, for
+    // keeping to a memory budget
+    size_t getCpuBytes() const
+    {
+        size_t bytes = textureLoader.getDecodedBytes() + (meshCache ? meshCache->getMappedBytes() : 0);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            bytes += meshes[i].getCpuBytes();
+        return bytes;
+    }
+    size_t getGpuBytes() const
+    {
+        // release deletes the textures along with textures_loaded
+        size_t bytes = textures_loaded.empty() ? 0 : textureLoader.getUploadedBytes();
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            bytes += meshes[i].getGpuBytes();
+        return bytes;
+    }
+    size_t getUploadBytes() const
+    {
+        size_t bytes = textureLoader.getDecodedBytes();
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            bytes += meshes[i].getUploadBytes();
+        return bytes;
+    }
+
+    // deletes the meshes' buffers and the textures. models are copied about with their meshes, so they only
+    // let go of what they have in GL when asked
+    void release()
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].release();
+        for(unsigned int i = 0; i < textures_loaded.size(); i++)
+            glDeleteTextures(1, &textures_loaded[i].id);
+        textures_loaded.clear();
+        textureIndices.clear();
+    }
+
+    // the number of levels of detail every mesh has, level 0 being the full mesh
+    unsigned int getLodCount() const { return meshes.empty() ? 1 : meshes[0].getLodCount(); }
+
     // draws the model, and thus all its meshes
-    void Draw(Shader shader)
+    void Draw(Shader& shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // draws instanceCount copies of the model with one draw call per mesh, see Mesh::DrawInstanced
+    void DrawInstanced(Shader& shader, unsigned int instanceBuffer, unsigned int instanceCount, unsigned int baseInstance = 0)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].DrawInstanced(shader, instanceBuffer, instanceCount, baseInstance);
+    }
     
 private:
+    // how every mesh stores its vertices on the GPU
+    VertexLayout vertexLayout;
+    // where each texture's path is in textures_loaded
+    unordered_map<string, unsigned int> textureIndices;
+    // the textures the meshes use, decoded together once every mesh has been read
+    TextureLoader textureLoader;
+    // whether GL is left until upload, and whether it has been
+    bool deferUpload = false;
+    bool uploaded;
+    // whether the meshes keep their vertices and indices once they are uploaded
+    bool retainCpuData = false;
+    // the mesh cache a cached model waiting on upload reads its meshes from, mapped until upload
+    shared_ptr<MeshCache> meshCache;
+    // what an imported model waiting on upload writes its mesh cache with
+    string cacheSourcePath;
+    vector<float> cacheLodRatios;
+
+    // the start of a .lod file, and its layout version. bump the version if the layout or the simplifier changes
+    static const unsigned int LOD_CACHE_MAGIC = 0x43444f4c; // "LODC"
+    static const unsigned int LOD_CACHE_VERSION = 3;
+
     /*  Functions   */
+    // finds the vertex furthest from the origin
+    void computeBoundingRadius()
+    {
+        float maxLengthSquared = 0.0f;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            for(unsigned int j = 0; j < meshes[i].vertices.size(); j++)
+            {
+                const glm::vec3& position = meshes[i].vertices[j].Position;
+                maxLengthSquared = std::max(maxLengthSquared, glm::dot(position, position));
+            }
+        boundingRadius = std::sqrt(maxLengthSquared);
+    }
+
+    // simplifies every mesh once per ratio. simplifying takes a while, so the results are kept next to the model
+    // in a .lod file and only worked out again when the model or the ratios change. unlike the .mesh file it
+    // doesn't depend on the vertex layout, so a model loaded with another layout still skips the simplifier
+    void generateLods(string const &path, const vector<float>& lodRatios)
+    {
+        if(meshes.empty())
+            return;
+
+        // keyed like the mesh cache, on the model's path, size and modified time
+        unsigned long long sourceSize = 0, sourceTime = 0;
+        const bool stamped = MeshCache::sourceStamp(path, sourceSize, sourceTime);
+
+        // meshLods[mesh][level - 1] is the index list of that level
+        vector<vector<vector<unsigned int>>> meshLods;
+        if(!stamped || !readLodCache(path, sourceSize, sourceTime, lodRatios, meshLods))
+        {
+            meshLods.assign(meshes.size(), vector<vector<unsigned int>>());
+            for(unsigned int i = 0; i < meshes.size(); i++)
+                for(unsigned int j = 0; j < lodRatios.size(); j++)
+                {
+                    size_t target = (size_t)(meshes[i].indices.size() * lodRatios[j]) / 3 * 3;
+                    vector<unsigned int> lod = MeshSimplifier::simplify(meshes[i].vertices, meshes[i].indices, target);
+                    // the levels share the vertices, so only their triangles can be put in cache order
+                    meshLods[i].push_back(MeshOptimizer::optimizeVertexCache(lod, meshes[i].vertices.size()));
+                }
+            if(stamped)
+                writeLodCache(path, sourceSize, sourceTime, lodRatios, meshLods);
+        }
+
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].setLods(meshLods[i]);
+    }
+
+    template<typename T> static bool readValue(ifstream& file, T& value)
+    {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return (bool)file;
+    }
+
+    template<typename T> static void writeValue(ofstream& file, T value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // the cache is only used if it was made from the same file, the same size and modified at the same time, with
+    // the same ratios, and its meshes still have the same vertex and index counts
+    bool readLodCache(string const &path, unsigned long long sourceSize, unsigned long long sourceTime, const vector<float>& lodRatios,
+                      vector<vector<vector<unsigned int>>>& meshLods) const
+    {
+        ifstream file(path + ".lod", ios::binary);
+        if(!file)
+            return false;
+
+        unsigned int magic = 0, version = 0, ratioCount = 0, meshCount = 0;
+        unsigned long long pathHash = 0, cachedSourceSize = 0, cachedSourceTime = 0;
+        if(!readValue(file, magic) || magic != LOD_CACHE_MAGIC || !readValue(file, version) || version != LOD_CACHE_VERSION ||
+           !readValue(file, pathHash) || pathHash != MeshCache::hashPath(path) || !readValue(file, cachedSourceSize) || cachedSourceSize != sourceSize ||
+           !readValue(file, cachedSourceTime) || cachedSourceTime != sourceTime || !readValue(file, ratioCount) || ratioCount != lodRatios.size())
+            return false;
+        for(unsigned int i = 0; i < ratioCount; i++)
+        {
+            float ratio = 0.0f;
+            if(!readValue(file, ratio) || ratio != lodRatios[i])
+                return false;
+        }
+        if(!readValue(file, meshCount) || meshCount != meshes.size())
+            return false;
+
+        meshLods.assign(meshCount, vector<vector<unsigned int>>(ratioCount));
+        for(unsigned int i = 0; i < meshCount; i++)
+        {
+            unsigned int vertexCount = 0, indexCount = 0;
+            if(!readValue(file, vertexCount) || vertexCount != meshes[i].vertices.size() || !readValue(file, indexCount) || indexCount != meshes[i].indices.size())
+                return false;
+            for(unsigned int j = 0; j < ratioCount; j++)
+            {
+                unsigned int lodIndexCount = 0;
+                if(!readValue(file, lodIndexCount) || lodIndexCount > indexCount)
+                    return false;
+                meshLods[i][j].resize(lodIndexCount);
+                if(lodIndexCount > 0 && !file.read(reinterpret_cast<char*>(&meshLods[i][j][0]), lodIndexCount * sizeof(unsigned int)))
+                    return false;
+                for(unsigned int k = 0; k < lodIndexCount; k++)
+                    if(meshLods[i][j][k] >= vertexCount)
+                        return false;
+            }
+        }
+        return true;
+    }
+
+    void writeLodCache(string const &path, unsigned long long sourceSize, unsigned long long sourceTime, const vector<float>& lodRatios,
+                       const vector<vector<vector<unsigned int>>>& meshLods) const
+    {
+        CacheFileWriter writer(path + ".lod");
+        ofstream& file = writer.stream();
+        if(!file)
+        {
+            cout << "Failed to write level of detail cache " << path << ".lod" << endl;
+            return;
+        }
+
+        writeValue(file, LOD_CACHE_MAGIC);
+        writeValue(file, LOD_CACHE_VERSION);
+        writeValue(file, MeshCache::hashPath(path));
+        writeValue(file, sourceSize);
+        writeValue(file, sourceTime);
+        writeValue(file, (unsigned int)lodRatios.size());
+        for(unsigned int i = 0; i < lodRatios.size(); i++)
+            writeValue(file, lodRatios[i]);
+        writeValue(file, (unsigned int)meshes.size());
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            writeValue(file, (unsigned int)meshes[i].vertices.size());
+            writeValue(file, (unsigned int)meshes[i].indices.size());
+            for(unsigned int j = 0; j < meshLods[i].size(); j++)
+            {
+                writeValue(file, (unsigned int)meshLods[i][j].size());
+                if(!meshLods[i][j].empty())
+                    file.write(reinterpret_cast<const char*>(&meshLods[i][j][0]), meshLods[i][j].size() * sizeof(unsigned int));
+            }
+        }
+        if(!writer.commit())
+            cout << "Failed to write level of detail cache " << path << ".lod" << endl;
+    }
+
+    // makes the meshes straight from the .mesh file if it is there and still matches the model
+    bool loadCachedModel(string const &path, const vector<float>& lodRatios)
+    {
+        shared_ptr<MeshCache> cache = make_shared<MeshCache>();
+        if(!cache->open(path, vertexLayout, lodRatios))
+            return false;
+
+        directory = path.substr(0, path.find_last_of('/'));
+        boundingRadius = cache->getBoundingRadius();
+        meshes.reserve(cache->getMeshes().size());
+        for(unsigned int i = 0; i < cache->getMeshes().size(); i++)
+        {
+            const vector<TextureReference>& references = cache->getTextures(i);
+            vector<Texture> textures;
+            for(unsigned int j = 0; j < references.size(); j++)
+                textures.push_back(loadTexture(references[j].path, references[j].type));
+            meshes.push_back(Mesh(cache->getMeshes()[i], textures, deferUpload));
+        }
+        // a deferred model's meshes upload from the mapping, so it stays open until then
+        if(deferUpload)
+            meshCache = cache;
+        loadTextures();
+        return true;
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
@@ -63,6 +385,17 @@ private:
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        // the meshes already have their texture names, this fills them in
+        loadTextures();
+    }
+
+    // loads every texture loadTexture queued, or only decodes them if upload is deferred
+    void loadTextures()
+    {
+        if(deferUpload)
+            textureLoader.decodeAll();
+        else
+            textureLoader.loadAll();
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -160,8 +493,13 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
+        // assimp gives every corner its own vertex and keeps the file's triangle order, so weld and reorder for the GPU
+        MeshOptimizeStats stats = MeshOptimizer::optimize(vertices, indices);
+        cout << "Optimised mesh " << meshes.size() << " (" << mesh->mName.C_Str() << "): " << stats.verticesBefore << " -> " << stats.verticesAfter
+             << " vertices, ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter << ", " << stats.bytesBefore / 1024 << " KB -> " << stats.bytesAfter / 1024 << " KB" << endl;
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), vertexLayout, deferUpload);
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -173,68 +511,32 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
 
-    unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false)
+    // the texture at path relative to the model, queued on the loader the first time it is asked for
+    Texture loadTexture(const string& path, const string& typeName)
     {
-        string filename = string(path);
-        filename = directory + '/' + filename;
+        // check if texture was loaded before and if so, reuse it rather than loading it again
+        unordered_map<string, unsigned int>::const_iterator loaded = textureIndices.find(path);
+        if(loaded != textureIndices.end())
+            return textures_loaded[loaded->second];
 
-        unsigned int textureID;
-        glGenTextures(1, &textureID);
-
-        int width, height, nrComponents;
-        unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-        if (data)
-        {
-            GLenum format;
-            if (nrComponents == 1)
-                format = GL_RED;
-            else if (nrComponents == 3)
-                format = GL_RGB;
-            else if (nrComponents == 4)
-                format = GL_RGBA;
-
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-            stbi_image_free(data);
-        }
+        // otherwise queue it, it is loaded along with the model's other textures once all the meshes are read.
+        // a deferred model has no name for it until upload
+        Texture texture;
+        texture.id = 0;
+        if(deferUpload)
+            textureLoader.queue(this->directory + '/' + path);
         else
-        {
-            std::cout << "Texture failed to load at path: " << path << std::endl;
-            stbi_image_free(data);
-        }
-
-        return textureID;
+            texture.id = textureLoader.add(this->directory + '/' + path);
+        texture.type = typeName;
+        texture.path = path;
+        textureIndices[texture.path] = (unsigned int)textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+        return texture;
     }
 };
 #endif
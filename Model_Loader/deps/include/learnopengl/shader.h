@@ -8,6 +8,40 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// a uniform name interned once, so every use of the same name shares one string and looking
+// it up is a pointer hash rather than hashing the string. keep hot names in statics, building
+// one from a string interns it again
+class UniformName
+{
+public:
+    UniformName(const char* name) : interned(&intern(name)) {}
+    UniformName(const std::string& name) : interned(&intern(name)) {}
+
+    const std::string& str() const { return *interned; }
+    const char* c_str() const { return interned->c_str(); }
+    bool operator==(const UniformName& other) const { return interned == other.interned; }
+
+    struct Hash
+    {
+        size_t operator()(const UniformName& name) const { return std::hash<const std::string*>()(name.interned); }
+    };
+
+private:
+    const std::string* interned;
+
+    // the set never removes names, so the pointers it hands out stay valid
+    static const std::string& intern(const std::string& name)
+    {
+        static std::mutex lock;
+        static std::unordered_set<std::string> names;
+        std::lock_guard<std::mutex> guard(lock);
+        return *names.insert(name).first;
+    }
+};
 
 class Shader
 {
@@ -57,44 +91,29 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
-        {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
-        }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        compile(vertexCode.c_str(), fragmentCode.c_str(), geometryPath != nullptr ? geometryCode.c_str() : nullptr);
+    }
+    // builds the program from source that has already been read, for when the files were read on another
+    // thread. the program has to be made on the thread that owns the context. an empty geometryCode means
+    // there is no geometry shader
+    // ------------------------------------------------------------------------
+    static Shader* fromSource(const std::string& vertexCode, const std::string& fragmentCode, const std::string& geometryCode = std::string())
+    {
+        Shader* shader = new Shader();
+        shader->compile(vertexCode.c_str(), fragmentCode.c_str(), geometryCode.empty() ? nullptr : geometryCode.c_str());
+        return shader;
+    }
+    // reads a whole source file, false if it couldn't be opened
+    // ------------------------------------------------------------------------
+    static bool readSource(const char* path, std::string& code)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        code = stream.str();
+        return true;
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -102,66 +121,211 @@ public:
     { 
         glUseProgram(ID); 
     }
+    // the location of an active uniform, -1 (which glUniform ignores) if the program doesn't use it
+    // ------------------------------------------------------------------------
+    GLint location(const UniformName &name) const
+    {
+        std::unordered_map<UniformName, GLint, UniformName::Hash>::const_iterator found = uniformLocations.find(name);
+        return found != uniformLocations.end() ? found->second : -1;
+    }
+    // points an active uniform block at a uniform buffer binding point, returns false if the
+    // program has no block with that name
+    // ------------------------------------------------------------------------
+    bool bindUniformBlock(const UniformName &name, GLuint binding) const
+    {
+        std::unordered_map<UniformName, GLuint, UniformName::Hash>::const_iterator found = uniformBlocks.find(name);
+        if (found == uniformBlocks.end())
+            return false;
+        glUniformBlockBinding(ID, found->second, binding);
+        return true;
+    }
+    // a bit set for each vertex attribute location the program reads, so meshes only store what it uses
+    // ------------------------------------------------------------------------
+    unsigned int attributeMask() const
+    {
+        return activeAttributes;
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(const UniformName &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(location(name), (int)value); 
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(const UniformName &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(location(name), value); 
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setUint(const UniformName &name, unsigned int value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1ui(location(name), value); 
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setFloat(const UniformName &name, float value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform1f(location(name), value); 
     }
-    void setVec2(const std::string &name, float x, float y) const
+    // ------------------------------------------------------------------------
+    void setVec2(const UniformName &name, const glm::vec2 &value) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2fv(location(name), 1, &value[0]); 
+    }
+    void setVec2(const UniformName &name, float x, float y) const
+    { 
+        glUniform2f(location(name), x, y); 
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(const UniformName &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(location(name), 1, &value[0]); 
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(const UniformName &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(location(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(const UniformName &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(location(name), 1, &value[0]); 
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(const UniformName &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(location(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(const UniformName &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(const UniformName &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(const UniformName &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+protected:
+    // for programs built some other way (see ComputeShader), which have to call reflect once linked
+    Shader() : ID(0), activeAttributes(0) {}
+
+    // active uniforms and uniform blocks by name, filled in once the program links
+    std::unordered_map<UniformName, GLint, UniformName::Hash> uniformLocations;
+    std::unordered_map<UniformName, GLuint, UniformName::Hash> uniformBlocks;
+    // one bit per active vertex attribute location
+    unsigned int activeAttributes;
+
+    // asks the linked program for its active uniforms, blocks and attributes and caches where they are
+    // ------------------------------------------------------------------------
+    void reflect()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            std::string uniform(name.c_str(), length);
+            GLint uniformLocation = glGetUniformLocation(ID, uniform.c_str());
+            // members of uniform blocks have no location, they're set through the block's buffer
+            if (uniformLocation < 0)
+                continue;
+            uniformLocations[UniformName(uniform)] = uniformLocation;
+            // arrays are reported as name[0], let them be set by the plain name as well
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+                uniformLocations[UniformName(uniform.substr(0, uniform.size() - 3))] = uniformLocation;
+        }
+
+        count = 0;
+        maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+        name.assign(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(ID, i, (GLsizei)name.size(), &length, &name[0]);
+            uniformBlocks[UniformName(std::string(name.c_str(), length))] = (GLuint)i;
+        }
+
+        activeAttributes = 0;
+        count = 0;
+        maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTES, &count);
+        glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+        name.assign(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveAttrib(ID, i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            // built in inputs (gl_VertexID etc) are listed too, but have no location
+            GLint attributeLocation = glGetAttribLocation(ID, std::string(name.c_str(), length).c_str());
+            if (attributeLocation < 0)
+                continue;
+            // matrices take a location per column
+            GLint columns = 1;
+            if (type == GL_FLOAT_MAT2 || type == GL_FLOAT_MAT2x3 || type == GL_FLOAT_MAT2x4)
+                columns = 2;
+            else if (type == GL_FLOAT_MAT3 || type == GL_FLOAT_MAT3x2 || type == GL_FLOAT_MAT3x4)
+                columns = 3;
+            else if (type == GL_FLOAT_MAT4 || type == GL_FLOAT_MAT4x2 || type == GL_FLOAT_MAT4x3)
+                columns = 4;
+            for (GLint slot = attributeLocation; slot < attributeLocation + columns * size && slot < 32; slot++)
+                activeAttributes |= 1u << slot;
+        }
+    }
+
+    // compiles and links the program from its source, a null gShaderCode meaning there is no geometry shader
+    // ------------------------------------------------------------------------
+    void compile(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode)
+    {
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+        // if geometry shader is given, compile geometry shader
+        unsigned int geometry;
+        if(gShaderCode != nullptr)
+        {
+            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glCompileShader(geometry);
+            checkCompileErrors(geometry, "GEOMETRY");
+        }
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        if(gShaderCode != nullptr)
+            glAttachShader(ID, geometry);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // look every uniform up once now rather than on each set
+        reflect();
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        if(gShaderCode != nullptr)
+            glDeleteShader(geometry);
     }
 
-private:
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,80 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+class ComputeShader : public Shader
+{
+public:
+    // constructor generates the compute shader on the fly, defines (one "#define X" per line) are
+    // added after the #version line so one file can hold several passes
+    // ------------------------------------------------------------------------
+    ComputeShader(const char* computePath, const std::string& defines = "")
+    {
+        // 1. retrieve the compute source code from filePath
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        // ensure ifstream objects can throw exceptions:
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try 
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (const std::ifstream::failure&)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        }
+        // the #version line has to stay first
+        if (!defines.empty())
+        {
+            size_t versionEnd = computeCode.find('\n');
+            size_t insertAt = computeCode.compare(0, 8, "#version") == 0 && versionEnd != std::string::npos ? versionEnd + 1 : 0;
+            computeCode.insert(insertAt, defines + "\n");
+        }
+        const char* cShaderCode = computeCode.c_str();
+        // 2. compile shader
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // delete the shader as it's linked into our program now and no longer necessery
+        glDeleteShader(compute);
+        // look every uniform up once now rather than on each set
+        reflect();
+        GLint linked = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        valid = linked != 0;
+    }
+    // whether the program compiled and linked
+    // ------------------------------------------------------------------------
+    bool isValid() const
+    {
+        return valid;
+    }
+    // runs the shader over the given number of work groups, use() first
+    // ------------------------------------------------------------------------
+    void dispatch(unsigned int groupsX, unsigned int groupsY = 1, unsigned int groupsZ = 1) const
+    {
+        glDispatchCompute(groupsX, groupsY, groupsZ);
+    }
+
+private:
+    bool valid = false;
+};
+#endif
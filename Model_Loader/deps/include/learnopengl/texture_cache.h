@@ -0,0 +1,387 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/cache_file.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// the S3TC formats aren't core so the loader doesn't define them, any driver listing them takes these values
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// one level of a mip chain, where it sits in CachedTexture::data
+struct TextureLevel {
+    int width;
+    int height;
+    size_t offset;
+    size_t size;
+};
+
+// a texture ready to upload level by level, either BC1 and BC3 blocks or plain RGBA8
+struct CachedTexture {
+    GLenum format = GL_RGBA8;
+    bool compressed = false;
+    vector<TextureLevel> levels;
+    vector<unsigned char> data;
+};
+
+// Builds the full mip chain of a decoded image on the CPU, block compresses it when the driver can sample
+// BC1/BC3, and keeps the result next to the image in a .tex file. Later loads read that file instead of
+// decoding the image again, and the levels go straight to glCompressedTexImage2D with no mipmaps to generate
+class TextureCache
+{
+public:
+    // bump the version if the layout, the filter or the encoder changes
+    static const unsigned int CACHE_MAGIC = 0x43584554; // "TEXC"
+    static const unsigned int CACHE_VERSION = 1;
+    // a 1x1 level is reached well before this from any size GL allows
+    static const unsigned int MAX_LEVELS = 32;
+
+    static string cachePath(const string& sourcePath) { return sourcePath + ".tex"; }
+
+    // whether the context lists the S3TC formats. the answer is kept from the first call, which has to be on
+    // the thread that owns the context, so after that any thread can ask
+    static bool supportsCompression()
+    {
+        static const bool supported = querySupport();
+        return supported;
+    }
+
+    // the cache is only used if it was made from a file at the same path with the same size and modified time,
+    // and holds a format this context can use
+    static bool read(const string& sourcePath, bool allowCompressed, CachedTexture& texture)
+    {
+        unsigned long long sourceSize = 0, sourceTime = 0;
+        if (!sourceStamp(sourcePath, sourceSize, sourceTime))
+            return false;
+        ifstream file(cachePath(sourcePath), ios::binary | ios::ate);
+        if (!file)
+            return false;
+        // nothing is sized bigger than the file could hold
+        const unsigned long long fileSize = (unsigned long long)file.tellg();
+        file.seekg(0);
+
+        unsigned int magic = 0, version = 0, format = 0, levelCount = 0;
+        unsigned long long pathHash = 0, cachedSize = 0, cachedTime = 0, dataSize = 0;
+        if (!readValue(file, magic) || magic != CACHE_MAGIC || !readValue(file, version) || version != CACHE_VERSION ||
+            !readValue(file, pathHash) || pathHash != hashPath(sourcePath) || !readValue(file, cachedSize) || cachedSize != sourceSize ||
+            !readValue(file, cachedTime) || cachedTime != sourceTime || !readValue(file, format) || !readValue(file, levelCount) || levelCount == 0 || levelCount > MAX_LEVELS)
+            return false;
+
+        texture.format = format;
+        texture.compressed = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        if ((texture.compressed && !allowCompressed) || (!texture.compressed && format != GL_RGBA8))
+            return false;
+
+        texture.levels.resize(levelCount);
+        for (unsigned int i = 0; i < levelCount; i++)
+        {
+            TextureLevel& level = texture.levels[i];
+            if (!readValue(file, level.width) || !readValue(file, level.height) || level.width <= 0 || level.height <= 0 ||
+                (unsigned long long)level.width > fileSize || (unsigned long long)level.height > fileSize)
+                return false;
+            level.offset = dataSize;
+            level.size = levelSize(format, level.width, level.height);
+            dataSize += level.size;
+            if (dataSize > fileSize)
+                return false;
+        }
+
+        texture.data.resize(dataSize);
+        return (bool)file.read(reinterpret_cast<char*>(&texture.data[0]), dataSize);
+    }
+
+    static void write(const string& sourcePath, const CachedTexture& texture)
+    {
+        unsigned long long sourceSize = 0, sourceTime = 0;
+        if (!sourceStamp(sourcePath, sourceSize, sourceTime))
+            return;
+        CacheFileWriter writer(cachePath(sourcePath));
+        ofstream& file = writer.stream();
+        if (!file)
+        {
+            cout << "Failed to write texture cache " << cachePath(sourcePath) << endl;
+            return;
+        }
+
+        writeValue(file, CACHE_MAGIC);
+        writeValue(file, CACHE_VERSION);
+        writeValue(file, hashPath(sourcePath));
+        writeValue(file, sourceSize);
+        writeValue(file, sourceTime);
+        writeValue(file, (unsigned int)texture.format);
+        writeValue(file, (unsigned int)texture.levels.size());
+        for (unsigned int i = 0; i < texture.levels.size(); i++)
+        {
+            writeValue(file, texture.levels[i].width);
+            writeValue(file, texture.levels[i].height);
+        }
+        file.write(reinterpret_cast<const char*>(&texture.data[0]), texture.data.size());
+        if (!writer.commit())
+            cout << "Failed to write texture cache " << cachePath(sourcePath) << endl;
+    }
+
+    // builds the mip chain down to 1x1 from a decoded image. 1 and 2 component images are widened to RGBA the
+    // way GL_RED and GL_RG textures sample, with 0 in the missing colours and full alpha. images with any
+    // transparency become BC3, the rest BC1
+    static void build(const unsigned char* pixels, int width, int height, int components, bool compress, CachedTexture& texture)
+    {
+        vector<unsigned char> rgba((size_t)width * height * 4);
+        bool opaque = true;
+        for (size_t i = 0; i < (size_t)width * height; i++)
+        {
+            const unsigned char* texel = pixels + i * components;
+            rgba[i * 4 + 0] = texel[0];
+            rgba[i * 4 + 1] = components >= 2 ? texel[1] : 0;
+            rgba[i * 4 + 2] = components >= 3 ? texel[2] : 0;
+            rgba[i * 4 + 3] = components == 4 ? texel[3] : 255;
+            opaque = opaque && rgba[i * 4 + 3] == 255;
+        }
+
+        texture.format = !compress ? GL_RGBA8 : (opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+        texture.compressed = compress;
+        texture.levels.clear();
+        texture.data.clear();
+
+        for (;;)
+        {
+            TextureLevel level;
+            level.width = width;
+            level.height = height;
+            level.offset = texture.data.size();
+            level.size = levelSize(texture.format, width, height);
+            texture.levels.push_back(level);
+            texture.data.resize(level.offset + level.size);
+            if (compress)
+                encodeLevel(rgba, width, height, !opaque, &texture.data[level.offset]);
+            else
+                copy(rgba.begin(), rgba.end(), texture.data.begin() + level.offset);
+
+            if (width == 1 && height == 1)
+                break;
+            rgba = halve(rgba, width, height);
+            width = max(1, width / 2);
+            height = max(1, height / 2);
+        }
+    }
+
+    static size_t levelSize(GLenum format, int width, int height)
+    {
+        if (format == GL_RGBA8)
+            return (size_t)width * height * 4;
+        size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+        return blocks * (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16);
+    }
+
+private:
+    // asks the current context for its compressed formats
+    static bool querySupport()
+    {
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+        vector<GLint> formats(max(formatCount, 0));
+        if (formatCount > 0)
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, &formats[0]);
+        return find(formats.begin(), formats.end(), (GLint)GL_COMPRESSED_RGB_S3TC_DXT1_EXT) != formats.end() &&
+               find(formats.begin(), formats.end(), (GLint)GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) != formats.end();
+    }
+
+    template<typename T> static bool readValue(ifstream& file, T& value)
+    {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return (bool)file;
+    }
+
+    template<typename T> static void writeValue(ofstream& file, T value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // FNV-1a, so a cache copied next to another image with the same name isn't taken for its own
+    static unsigned long long hashPath(const string& path)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        for (size_t i = 0; i < path.size(); i++)
+            hash = (hash ^ (unsigned char)path[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    static bool sourceStamp(const string& path, unsigned long long& size, unsigned long long& time)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        size = (unsigned long long)info.st_size;
+        time = (unsigned long long)info.st_mtime;
+        return true;
+    }
+
+    // the next level down, each texel the average of the 2x2 above it. an odd row or column is folded into
+    // its neighbour by clamping
+    static vector<unsigned char> halve(const vector<unsigned char>& rgba, int width, int height)
+    {
+        int halfWidth = max(1, width / 2), halfHeight = max(1, height / 2);
+        vector<unsigned char> half((size_t)halfWidth * halfHeight * 4);
+        for (int y = 0; y < halfHeight; y++)
+            for (int x = 0; x < halfWidth; x++)
+            {
+                int x0 = min(x * 2, width - 1), x1 = min(x * 2 + 1, width - 1);
+                int y0 = min(y * 2, height - 1), y1 = min(y * 2 + 1, height - 1);
+                for (int c = 0; c < 4; c++)
+                {
+                    unsigned int sum = rgba[((size_t)y0 * width + x0) * 4 + c] + rgba[((size_t)y0 * width + x1) * 4 + c] +
+                                       rgba[((size_t)y1 * width + x0) * 4 + c] + rgba[((size_t)y1 * width + x1) * 4 + c];
+                    half[((size_t)y * halfWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        return half;
+    }
+
+    // compresses a level block by block, edge blocks repeat their last row and column
+    static void encodeLevel(const vector<unsigned char>& rgba, int width, int height, bool alpha, unsigned char* out)
+    {
+        unsigned char block[64];
+        for (int by = 0; by < height; by += 4)
+            for (int bx = 0; bx < width; bx += 4)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    int x = min(bx + i % 4, width - 1), y = min(by + i / 4, height - 1);
+                    memcpy(&block[i * 4], &rgba[((size_t)y * width + x) * 4], 4);
+                }
+                if (alpha)
+                {
+                    encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+                encodeColourBlock(block, out);
+                out += 8;
+            }
+    }
+
+    static unsigned short pack565(const int* colour)
+    {
+        return (unsigned short)(((colour[0] >> 3) << 11) | ((colour[1] >> 2) << 5) | (colour[2] >> 3));
+    }
+
+    static void unpack565(unsigned short packed, int* colour)
+    {
+        colour[0] = ((packed >> 11) & 31) * 255 / 31;
+        colour[1] = ((packed >> 5) & 63) * 255 / 63;
+        colour[2] = (packed & 31) * 255 / 31;
+    }
+
+    // the end points are the corners of the block's colour bounding box, pulled in by a sixteenth to make up for
+    // the ends being used less than the middle (van Waveren 2006, Real-Time DXT Compression). each texel then
+    // takes the nearest of the four palette colours
+    static void encodeColourBlock(const unsigned char* block, unsigned char* out)
+    {
+        int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+            {
+                low[c] = min(low[c], (int)block[i * 4 + c]);
+                high[c] = max(high[c], (int)block[i * 4 + c]);
+            }
+        for (int c = 0; c < 3; c++)
+        {
+            int inset = (high[c] - low[c]) / 16;
+            low[c] += inset;
+            high[c] -= inset;
+        }
+
+        unsigned short colour0 = pack565(high), colour1 = pack565(low);
+        // the first end point has to be the larger or the block reads as having transparency
+        if (colour0 < colour1)
+            swap(colour0, colour1);
+
+        int palette[4][3];
+        unpack565(colour0, palette[0]);
+        unpack565(colour1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        unsigned int indices = 0;
+        if (colour0 != colour1)
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = INT_MAX;
+                for (int p = 0; p < 4; p++)
+                {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++)
+                        distance += (block[i * 4 + c] - palette[p][c]) * (block[i * 4 + c] - palette[p][c]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= (unsigned int)best << (i * 2);
+            }
+
+        out[0] = (unsigned char)(colour0 & 255);
+        out[1] = (unsigned char)(colour0 >> 8);
+        out[2] = (unsigned char)(colour1 & 255);
+        out[3] = (unsigned char)(colour1 >> 8);
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (unsigned char)(indices >> (i * 8));
+    }
+
+    // BC3's alpha, the block's highest and lowest alpha with six steps between them
+    static void encodeAlphaBlock(const unsigned char* block, unsigned char* out)
+    {
+        int low = 255, high = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            low = min(low, (int)block[i * 4 + 3]);
+            high = max(high, (int)block[i * 4 + 3]);
+        }
+
+        int palette[8] = { high, low };
+        for (int p = 1; p < 7; p++)
+            palette[p + 1] = ((7 - p) * high + p * low) / 7;
+
+        unsigned long long indices = 0;
+        if (high != low)
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = INT_MAX;
+                for (int p = 0; p < 8; p++)
+                {
+                    int distance = abs(block[i * 4 + 3] - palette[p]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= (unsigned long long)best << (i * 3);
+            }
+
+        out[0] = (unsigned char)high;
+        out[1] = (unsigned char)low;
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (unsigned char)(indices >> (i * 8));
+    }
+};
+#endif
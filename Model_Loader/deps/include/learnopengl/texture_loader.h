@@ -0,0 +1,296 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb/stb_image.h>
+
+#include <learnopengl/texture_cache.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Loads a batch of image files into GL textures. The files are decoded on worker threads, all at once, while
+// the thread that owns the context uploads each one through a pixel unpack buffer as soon as it is decoded.
+// Each image's mip chain is built and block compressed once then read from the TextureCache after that
+class TextureLoader
+{
+public:
+    TextureLoader() {}
+
+    // queues a file and returns the texture it will be loaded into. the name is made straight away so it can be
+    // handed out before loadAll, it stays empty if the file won't decode
+    unsigned int add(const string& path)
+    {
+        Request request;
+        request.path = path;
+        glGenTextures(1, &request.id);
+        requests.push_back(request);
+        return request.id;
+    }
+
+    // decodes and uploads everything queued, and returns once it is all uploaded
+    void loadAll()
+    {
+        if (requests.empty())
+            return;
+
+        Clock::time_point start = Clock::now();
+
+        // stb_image keeps its error message per thread, so decoding is safe on any number of them
+        unsigned int threadCount = min((unsigned int)requests.size(), max(1u, thread::hardware_concurrency()));
+        const bool compress = TextureCache::supportsCompression();
+        atomic<unsigned int> nextRequest(0);
+        mutex decodedMutex;
+        condition_variable decodedCondition;
+        deque<Decoded> decoded;
+
+        vector<thread> workers;
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.push_back(thread([&]()
+            {
+                for (unsigned int request = nextRequest++; request < requests.size(); request = nextRequest++)
+                {
+                    Decoded image;
+                    decodeRequest(request, compress, image);
+                    {
+                        lock_guard<mutex> lock(decodedMutex);
+                        decoded.push_back(std::move(image));
+                    }
+                    decodedCondition.notify_one();
+                }
+            }));
+
+        // two buffers taking turns, so filling one doesn't wait on the driver still copying out of the other
+        unsigned int unpackBuffers[2];
+        glGenBuffers(2, unpackBuffers);
+        for (unsigned int uploaded = 0; uploaded < requests.size(); uploaded++)
+        {
+            Decoded image;
+            {
+                unique_lock<mutex> lock(decodedMutex);
+                decodedCondition.wait(lock, [&]() { return !decoded.empty(); });
+                image = std::move(decoded.front());
+                decoded.pop_front();
+            }
+
+            if (uploadDecoded(requests[image.request], image, unpackBuffers[uploaded % 2]))
+                uploadedBytes += image.texture.data.size();
+        }
+
+        for (unsigned int i = 0; i < workers.size(); i++)
+            workers[i].join();
+        glDeleteBuffers(2, unpackBuffers);
+
+        cout << "Loaded " << requests.size() << " textures on " << threadCount << " threads in "
+             << chrono::duration<float, milli>(Clock::now() - start).count() << " ms" << endl;
+        // the textures belong to whoever add handed them to now
+        requests.clear();
+    }
+
+    // queues a file without naming its texture, so models can be read off the thread that owns the context.
+    // decodeAll then uploadAll load it, and uploadAll hands back the name
+    void queue(const string& path)
+    {
+        Request request;
+        request.path = path;
+        request.id = 0;
+        requests.push_back(request);
+    }
+
+    // decodes everything queued on worker threads and keeps it for uploadAll. no GL calls are made, so this
+    // can run on any thread once TextureCache::supportsCompression has been asked on the context's thread
+    void decodeAll()
+    {
+        decodedImages.assign(requests.size(), Decoded());
+        unsigned int threadCount = min((unsigned int)requests.size(), max(1u, thread::hardware_concurrency()));
+        const bool compress = TextureCache::supportsCompression();
+        atomic<unsigned int> nextRequest(0);
+
+        vector<thread> workers;
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.push_back(thread([&]()
+            {
+                for (unsigned int request = nextRequest++; request < requests.size(); request = nextRequest++)
+                    decodeRequest(request, compress, decodedImages[request]);
+            }));
+        for (unsigned int i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    // uploads what decodeAll decoded and returns each texture's name, in the order the files were queued.
+    // files that didn't decode get 0. must be on the thread that owns the context, and the textures belong
+    // to the caller after
+    vector<unsigned int> uploadAll()
+    {
+        vector<unsigned int> ids(decodedImages.size(), 0);
+        unsigned int unpackBuffers[2];
+        glGenBuffers(2, unpackBuffers);
+        for (unsigned int i = 0; i < decodedImages.size(); i++)
+        {
+            Request& request = requests[i];
+            if (decodedImages[i].loaded && request.id == 0)
+                glGenTextures(1, &request.id);
+            if (uploadDecoded(request, decodedImages[i], unpackBuffers[i % 2]))
+            {
+                ids[i] = request.id;
+                uploadedBytes += decodedImages[i].texture.data.size();
+            }
+        }
+        glDeleteBuffers(2, unpackBuffers);
+
+        requests.clear();
+        decodedImages.clear();
+        return ids;
+    }
+
+    // the bytes decodeAll is holding for uploadAll, and the bytes of every texture uploaded so far
+    size_t getDecodedBytes() const
+    {
+        size_t bytes = 0;
+        for (unsigned int i = 0; i < decodedImages.size(); i++)
+            bytes += decodedImages[i].texture.data.size();
+        return bytes;
+    }
+    size_t getUploadedBytes() const { return uploadedBytes; }
+
+private:
+    typedef chrono::high_resolution_clock Clock;
+
+    TextureLoader(const TextureLoader&);
+    TextureLoader& operator=(const TextureLoader&);
+
+    struct Request {
+        string path;
+        unsigned int id;
+    };
+
+    struct Decoded {
+        Decoded() : request(0), loaded(false), fromCache(false), decodeMs(0.0f), failureReason("") {}
+
+        unsigned int request;
+        CachedTexture texture;
+        bool loaded;
+        bool fromCache;
+        float decodeMs;
+        // stb_image's message is only readable from the thread that decoded
+        const char* failureReason;
+    };
+
+    // decodes one of the requests and times it. runs on the workers
+    void decodeRequest(unsigned int request, bool compress, Decoded& image) const
+    {
+        Clock::time_point decodeStart = Clock::now();
+        image.request = request;
+        image.loaded = decode(requests[request].path, compress, image);
+        image.decodeMs = chrono::duration<float, milli>(Clock::now() - decodeStart).count();
+    }
+
+    // uploads a decoded image into its request's texture and logs how it went, false if it didn't decode
+    static bool uploadDecoded(const Request& request, const Decoded& image, unsigned int unpackBuffer)
+    {
+        if (!image.loaded)
+        {
+            cout << "Texture failed to load at path: " << request.path << " (" << image.failureReason << ")" << endl;
+            return false;
+        }
+
+        Clock::time_point uploadStart = Clock::now();
+        upload(request.id, image.texture, unpackBuffer);
+        float uploadMs = chrono::duration<float, milli>(Clock::now() - uploadStart).count();
+
+        const TextureLevel& top = image.texture.levels[0];
+        cout << "Texture " << request.path << ": " << top.width << "x" << top.height << " " << formatName(image.texture.format) << ", "
+             << (image.fromCache ? "read from cache in " : "decoded in ") << image.decodeMs << " ms, uploaded in " << uploadMs << " ms, "
+             << image.texture.data.size() / 1024 << " KB" << endl;
+        return true;
+    }
+
+    // reads the image's cache, or decodes the image and builds the cache from it. runs on the workers
+    static bool decode(const string& path, bool compress, Decoded& image)
+    {
+        image.fromCache = TextureCache::read(path, compress, image.texture);
+        if (image.fromCache)
+            return true;
+
+        int width, height, components;
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &components, 0);
+        if (!pixels)
+        {
+            image.failureReason = stbi_failure_reason();
+            return false;
+        }
+        TextureCache::build(pixels, width, height, components, compress, image.texture);
+        stbi_image_free(pixels);
+        TextureCache::write(path, image.texture);
+        return true;
+    }
+
+    static const char* formatName(GLenum format)
+    {
+        if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+            return "BC1";
+        if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+            return "BC3";
+        return "RGBA8";
+    }
+
+    // copies every level into the unpack buffer and has the texture take them from there, the copy from the
+    // buffer into the texture is left to the driver. falls back to uploading from the texture's own data if the
+    // buffer won't map
+    static void upload(unsigned int id, const CachedTexture& texture, unsigned int unpackBuffer)
+    {
+        bool fromBuffer = false;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        // reallocating drops the old storage, so the map doesn't wait on an upload still reading it
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, texture.data.size(), nullptr, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, texture.data.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped)
+        {
+            memcpy(mapped, &texture.data[0], texture.data.size());
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            fromBuffer = true;
+        }
+        else
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        // the last levels are narrower than 4 bytes a row
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, id);
+        for (unsigned int i = 0; i < texture.levels.size(); i++)
+        {
+            const TextureLevel& level = texture.levels[i];
+            // with the buffer bound the pointer is an offset into it
+            const void* pixels = fromBuffer ? reinterpret_cast<const void*>(level.offset) : &texture.data[level.offset];
+            if (texture.compressed)
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, texture.format, level.width, level.height, 0, (GLsizei)level.size, pixels);
+            else
+                glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    vector<Request> requests;
+    // what decodeAll decoded, one for each request
+    vector<Decoded> decodedImages;
+    size_t uploadedBytes = 0;
+};
+#endif